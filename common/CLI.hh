@@ -6,6 +6,7 @@
 #include <vector>
 #include <sstream>
 #include <iostream>
+#include <cstdint>
 #include <common/Logger.hh>
 #include <common/Retcode.hh>
 
@@ -120,6 +121,11 @@
                 return m_Values.at(index).value;
             }
 
+            size_t NumValues(void) const
+            {
+                return m_Values.size();
+            }
+
         protected:
             virtual bool TryConversion(const std::string& conversion, ArgType& value) = 0;
 
@@ -185,6 +191,17 @@
         }
     };
 
+    class CLI_StringListArgument: public CLI_Argument<std::string, 1, SIZE_MAX>
+    {
+        using CLI_Argument::CLI_Argument;
+
+        bool TryConversion(const std::string& conversion, std::string& value)
+        {
+            value = conversion;
+            return true;
+        }
+    };
+
     class Parser
     {
         public:
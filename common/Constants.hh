@@ -6,14 +6,17 @@
 namespace CONSTANTS
 {
     constexpr size_t WORD_SIZE = 8;
+    constexpr size_t CACHE_LINE_SIZE = 64;
 
     const std::string CURRENT_DIRECTORY = "./";
 
     const char SCHEMA_COMMENT = '#';
+    const std::string SCHEMA_BLOOM_FILTER = "bloom";
 
     const std::string SCHEMA_EXT = ".skm";
     const std::string HEADER_EXT = ".hh";
     const std::string DB_EXT = ".qcdb";
+    const std::string STATS_EXT = ".stats";
 
     constexpr int RW = 0666;
 }
@@ -3,6 +3,12 @@
 
 
 #include <common/OSdefines.hh>
+#include <common/Constants.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <algorithm>
 #ifdef WINDOWS_PLATFORM
 using pthread_rwlock_t = char[80];
 #else
@@ -11,14 +17,172 @@ using pthread_rwlock_t = char[80];
 /*
  * NOTE: DBHeader values should be accessed before fields
  *       to remain cache friendly
+ *
+ * The header fills whole cache lines so records start on a cache line.
  */
-struct DBHeader
+struct alignas(CONSTANTS::CACHE_LINE_SIZE) DBHeader
 {
     pthread_rwlock_t m_DBLock;
     char m_ObjectName[24];
     size_t m_NumRecords;
     size_t m_LastWritten;
     size_t m_Size;
+    size_t m_RecordSize;
+    uint64_t m_BloomFields; // Bit per schema field index with a Bloom filter
+    uint64_t m_BloomStale;  // Set by writers that can not update the filters
+    uint64_t m_Checksums;   // Non zero if every block of records has a checksum
+    uint64_t m_Generation;  // Stamped on changed blocks of records, 0 if not tracked
+};
+
+/*
+ * Every record has a version stamp that each write bumps, kept in an array
+ * after the records so the records themselves keep the generated layout.
+ */
+typedef uint64_t RECORD_VERSION;
+
+inline size_t VersionsOffset(size_t numRecords, size_t objectSize)
+{
+    size_t recordsEnd = sizeof(DBHeader) + numRecords * objectSize;
+    return (recordsEnd + CONSTANTS::CACHE_LINE_SIZE - 1) & ~(CONSTANTS::CACHE_LINE_SIZE - 1);
+}
+
+/*
+ * Fields declared with a Bloom filter in the schema get one after the
+ * versions. Each filter is BloomBlocks cache line sized blocks and every
+ * value sets bits in one block only, see qcDB/Bloom.hh.
+ */
+struct alignas(CONSTANTS::CACHE_LINE_SIZE) BLOOM_BLOCK
+{
+    uint64_t m_Words[CONSTANTS::CACHE_LINE_SIZE / sizeof(uint64_t)];
 };
 
+constexpr size_t BLOOM_BITS_PER_RECORD = 16;
+
+inline size_t BloomBlocks(size_t numRecords)
+{
+    size_t bitsPerBlock = sizeof(BLOOM_BLOCK) * 8;
+    return std::max<size_t>((numRecords * BLOOM_BITS_PER_RECORD + bitsPerBlock - 1) / bitsPerBlock, 1);
+}
+
+inline size_t BloomFiltersOffset(size_t numRecords, size_t objectSize)
+{
+    size_t versionsEnd = VersionsOffset(numRecords, objectSize) + numRecords * sizeof(RECORD_VERSION);
+    return (versionsEnd + CONSTANTS::CACHE_LINE_SIZE - 1) & ~(CONSTANTS::CACHE_LINE_SIZE - 1);
+}
+
+/*
+ * Tables generated with checksums keep a CRC32C of every CHECKSUM_BLOCK_SIZE
+ * bytes of records after the Bloom filters, see qcDB/Checksum.hh.
+ */
+typedef uint32_t BLOCK_CHECKSUM;
+
+constexpr size_t CHECKSUM_BLOCK_SIZE = 4096;
+
+inline size_t ChecksumBlocks(size_t numRecords, size_t objectSize)
+{
+    return (numRecords * objectSize + CHECKSUM_BLOCK_SIZE - 1) / CHECKSUM_BLOCK_SIZE;
+}
+
+/*
+ * Tables generated to track changes stamp every block of records they
+ * change with the generation in the DBHeader, in an array after the
+ * checksums. Backups copy the blocks stamped since the previous one, see
+ * dbBackup.
+ */
+typedef uint64_t BLOCK_GENERATION;
+
+constexpr size_t BACKUP_BLOCK_SIZE = 4096;
+
+inline size_t BackupBlocks(size_t numRecords, size_t objectSize)
+{
+    return (numRecords * objectSize + BACKUP_BLOCK_SIZE - 1) / BACKUP_BLOCK_SIZE;
+}
+
+/*
+ * Stamp the blocks holding [offset, offset + length) of the records with
+ * generation. Atomic since the field operations change records under the
+ * read lock, and only stored when it changes so readers keep the line.
+ */
+inline void StampBlocks(BLOCK_GENERATION* generations, BLOCK_GENERATION generation, size_t offset, size_t length)
+{
+    for (size_t block = offset / BACKUP_BLOCK_SIZE; length && block <= (offset + length - 1) / BACKUP_BLOCK_SIZE; block++)
+    {
+        if (generation != __atomic_load_n(&generations[block], __ATOMIC_RELAXED))
+        {
+            __atomic_store_n(&generations[block], generation, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+inline size_t DatabaseFileSize(size_t numRecords, size_t objectSize, size_t numBloomFilters = 0, bool hasChecksums = false,
+    bool hasGenerations = false)
+{
+    if (hasGenerations)
+    {
+        size_t end = DatabaseFileSize(numRecords, objectSize, numBloomFilters, hasChecksums);
+        size_t generationsOffset = (end + CONSTANTS::CACHE_LINE_SIZE - 1) & ~(CONSTANTS::CACHE_LINE_SIZE - 1);
+        return generationsOffset + BackupBlocks(numRecords, objectSize) * sizeof(BLOCK_GENERATION);
+    }
+
+    if (hasChecksums)
+    {
+        size_t end = DatabaseFileSize(numRecords, objectSize, numBloomFilters);
+        size_t checksumsOffset = (end + CONSTANTS::CACHE_LINE_SIZE - 1) & ~(CONSTANTS::CACHE_LINE_SIZE - 1);
+        return checksumsOffset + ChecksumBlocks(numRecords, objectSize) * sizeof(BLOCK_CHECKSUM);
+    }
+
+    if (0 == numBloomFilters)
+    {
+        return VersionsOffset(numRecords, objectSize) + numRecords * sizeof(RECORD_VERSION);
+    }
+
+    return BloomFiltersOffset(numRecords, objectSize) + numBloomFilters * BloomBlocks(numRecords) * sizeof(BLOOM_BLOCK);
+}
+
+inline size_t ChecksumsOffset(size_t numRecords, size_t objectSize, size_t numBloomFilters)
+{
+    size_t end = DatabaseFileSize(numRecords, objectSize, numBloomFilters);
+    return (end + CONSTANTS::CACHE_LINE_SIZE - 1) & ~(CONSTANTS::CACHE_LINE_SIZE - 1);
+}
+
+inline size_t GenerationsOffset(size_t numRecords, size_t objectSize, size_t numBloomFilters, bool hasChecksums)
+{
+    size_t end = DatabaseFileSize(numRecords, objectSize, numBloomFilters, hasChecksums);
+    return (end + CONSTANTS::CACHE_LINE_SIZE - 1) & ~(CONSTANTS::CACHE_LINE_SIZE - 1);
+}
+
+/*
+ * Size of the file described by a header.
+ */
+inline size_t DatabaseFileSize(const DBHeader& header)
+{
+    return DatabaseFileSize(header.m_NumRecords, header.m_RecordSize, __builtin_popcountll(header.m_BloomFields),
+        0 != header.m_Checksums, 0 != header.m_Generation);
+}
+
+/*
+ * A table split across several files keeps each shard in its own file,
+ * PERSON.qcdb becomes PERSON.0.qcdb, PERSON.1.qcdb and so on.
+ */
+inline std::string ShardFilePath(const std::string& dbPath, size_t shard)
+{
+    size_t extension = dbPath.size() - std::min(dbPath.size(), CONSTANTS::DB_EXT.size());
+    std::string basePath = dbPath;
+    if (0 == dbPath.compare(extension, std::string::npos, CONSTANTS::DB_EXT))
+    {
+        basePath.resize(extension);
+    }
+
+    return basePath + "." + std::to_string(shard) + CONSTANTS::DB_EXT;
+}
+
+/*
+ * Records in each shard of a table of numRecords records, every shard has
+ * the same size so the last one may have a few more than needed.
+ */
+inline size_t ShardNumRecords(size_t numRecords, size_t numShards)
+{
+    return (numRecords + numShards - 1) / numShards;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,201 @@
+#ifndef __HISTOGRAM_HH
+#define __HISTOGRAM_HH
+
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+/*
+ * Fixed size log-linear histogram in the style of HdrHistogram.
+ *
+ * Values below 2^SubBucketBits are counted exactly. Above that every power
+ * of two is split into 2^SubBucketBits linear sub-buckets so the relative
+ * error stays under 1 / 2^SubBucketBits across the full 64 bit range.
+ * SubBucketBits = 0 gives a plain log2 histogram.
+ *
+ * The struct is plain data with no pointers so it can be placed in shared
+ * memory or in a mapped file and read by another process.
+ */
+template <size_t SubBucketBits>
+struct Histogram
+{
+    static constexpr size_t SUB_BUCKET_COUNT = static_cast<size_t>(1) << SubBucketBits;
+    static constexpr uint64_t SUB_BUCKET_MASK = SUB_BUCKET_COUNT - 1;
+    static constexpr size_t NUM_BUCKETS = (64 - SubBucketBits + 1) * SUB_BUCKET_COUNT;
+
+    uint64_t m_Counts[NUM_BUCKETS];
+    uint64_t m_TotalCount;
+    uint64_t m_Sum;
+    uint64_t m_Min;
+    uint64_t m_Max;
+
+    void Reset(void)
+    {
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+        {
+            m_Counts[bucket] = 0;
+        }
+
+        m_TotalCount = 0;
+        m_Sum = 0;
+        m_Min = UINT64_MAX;
+        m_Max = 0;
+    }
+
+    /*
+     * Record a value. Not thread safe, each writer should own its histogram.
+     */
+    void Record(uint64_t value)
+    {
+        m_Counts[BucketIndex(value)]++;
+        m_TotalCount++;
+        m_Sum += value;
+        if (value < m_Min)
+        {
+            m_Min = value;
+        }
+
+        if (value > m_Max)
+        {
+            m_Max = value;
+        }
+    }
+
+    /*
+     * Record a value from several threads or processes at once.
+     * Min is not tracked since a zero filled histogram would never update it.
+     */
+    void AtomicRecord(uint64_t value)
+    {
+        __atomic_fetch_add(&m_Counts[BucketIndex(value)], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&m_TotalCount, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&m_Sum, value, __ATOMIC_RELAXED);
+
+        // New maximums are rare so the CAS loop is almost never taken
+        uint64_t max = __atomic_load_n(&m_Max, __ATOMIC_RELAXED);
+        while (value > max)
+        {
+            if (__atomic_compare_exchange_n(&m_Max, &max, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+    }
+
+    void Merge(const Histogram& other)
+    {
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+        {
+            m_Counts[bucket] += other.m_Counts[bucket];
+        }
+
+        m_TotalCount += other.m_TotalCount;
+        m_Sum += other.m_Sum;
+        if (other.m_Min < m_Min)
+        {
+            m_Min = other.m_Min;
+        }
+
+        if (other.m_Max > m_Max)
+        {
+            m_Max = other.m_Max;
+        }
+    }
+
+    double Mean(void) const
+    {
+        if (0 == m_TotalCount)
+        {
+            return 0.0;
+        }
+
+        return static_cast<double>(m_Sum) / m_TotalCount;
+    }
+
+    /*
+     * Value at the given percentile (0 - 100). Reports the highest value
+     * that falls into the same bucket as the percentile.
+     */
+    uint64_t Percentile(double percentile) const
+    {
+        if (0 == m_TotalCount)
+        {
+            return 0;
+        }
+
+        uint64_t target = static_cast<uint64_t>((percentile / 100.0) * m_TotalCount + 0.5);
+        if (0 == target)
+        {
+            target = 1;
+        }
+
+        uint64_t cumulative = 0;
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+        {
+            cumulative += m_Counts[bucket];
+            if (cumulative >= target)
+            {
+                return HighestEquivalentValue(bucket);
+            }
+        }
+
+        return HighestEquivalentValue(NUM_BUCKETS - 1);
+    }
+
+    static size_t BucketIndex(uint64_t value)
+    {
+        if (value < SUB_BUCKET_COUNT)
+        {
+            return static_cast<size_t>(value);
+        }
+
+        size_t mostSignificantBit = 63 - __builtin_clzll(value);
+        size_t shift = mostSignificantBit - SubBucketBits;
+        size_t subBucket = static_cast<size_t>((value >> shift) & SUB_BUCKET_MASK);
+        return ((shift + 1) << SubBucketBits) | subBucket;
+    }
+
+    static uint64_t LowestEquivalentValue(size_t bucket)
+    {
+        if (bucket < SUB_BUCKET_COUNT)
+        {
+            return bucket;
+        }
+
+        size_t shift = (bucket >> SubBucketBits) - 1;
+        uint64_t subBucket = bucket & SUB_BUCKET_MASK;
+        return (SUB_BUCKET_COUNT | subBucket) << shift;
+    }
+
+    static uint64_t HighestEquivalentValue(size_t bucket)
+    {
+        if (NUM_BUCKETS - 1 <= bucket)
+        {
+            return UINT64_MAX;
+        }
+
+        return LowestEquivalentValue(bucket + 1) - 1;
+    }
+};
+
+/*
+ * Write the summary of a histogram as a JSON object.
+ */
+template <size_t SubBucketBits>
+std::ostream& WriteHistogramJSON(std::ostream& os, const Histogram<SubBucketBits>& histogram)
+{
+    uint64_t min = histogram.m_TotalCount ? histogram.m_Min : 0;
+
+    return os
+        << "{\"count\": " << histogram.m_TotalCount
+        << ", \"min\": " << min
+        << ", \"mean\": " << histogram.Mean()
+        << ", \"p50\": " << histogram.Percentile(50.0)
+        << ", \"p90\": " << histogram.Percentile(90.0)
+        << ", \"p99\": " << histogram.Percentile(99.0)
+        << ", \"p999\": " << histogram.Percentile(99.9)
+        << ", \"max\": " << histogram.m_Max
+        << "}";
+}
+
+#endif
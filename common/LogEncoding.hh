@@ -0,0 +1,580 @@
+#ifndef __LOG_ENCODING_HH
+#define __LOG_ENCODING_HH
+
+#include <string>
+#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+/*
+ * Compact binary encoding of log arguments so they can be copied at the call
+ * site and turned into text later, by the async logger thread or offline.
+ *
+ * Every argument is a one byte tag followed by its value. Numbers are copied
+ * as 8 bytes, strings as a 4 byte length and their characters. Any other type
+ * is formatted with operator << once at the call site and stored as a string.
+ *
+ * Arguments that are string literals are the same for every message from a
+ * call site, so they are not copied at all. The call site keeps their text,
+ * see SITE_ARGUMENTS, and decoding puts it back between the other arguments.
+ */
+namespace LogEncoding
+{
+    enum class ARG_TYPE : uint8_t
+    {
+        INT = 0,
+        UINT,
+        DOUBLE,
+        BOOL,
+        CHAR,
+        STRING
+    };
+
+    /*
+     * Binary log file written by Logger::StartBinary: a header followed by
+     * site and message records. A site record appears once, before the first
+     * message from that call site, followed by its level name, its file name
+     * and, for every bit set in literals, a 4 byte length and the text of
+     * that literal argument. A message record is followed by its encoded
+     * arguments.
+     */
+    constexpr char BINARY_LOG_MAGIC[8] = { 'Q', 'C', 'D', 'B', 'L', 'O', 'G', '\0' };
+    constexpr uint32_t BINARY_LOG_VERSION = 2;
+
+    enum class BINARY_RECORD_TYPE : uint32_t
+    {
+        SITE = 1,
+        MESSAGE
+    };
+
+    struct BINARY_LOG_HEADER
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    struct BINARY_SITE_RECORD
+    {
+        uint32_t type;
+        uint32_t siteID;
+        uint32_t level;
+        int32_t lineNum;
+        uint32_t debugLevelLength;
+        uint32_t fileNameLength;
+        uint64_t literals;
+    };
+
+    struct BINARY_MESSAGE_RECORD
+    {
+        uint32_t type;
+        uint32_t siteID;
+        int64_t timestamp;
+        int32_t processID;
+        int32_t threadID;
+        uint32_t argumentsSize;
+        uint32_t reserved;
+    };
+
+    template <typename T>
+    struct IsCharacter : std::integral_constant<bool,
+        std::is_same<T, char>::value ||
+        std::is_same<T, signed char>::value ||
+        std::is_same<T, unsigned char>::value> {};
+
+    // Character arrays have their own specialization bounded by their size
+    template <typename T>
+    struct IsString : std::integral_constant<bool,
+        std::is_same<T, char*>::value ||
+        std::is_same<T, const char*>::value ||
+        std::is_same<T, std::string>::value> {};
+
+    inline size_t StringLength(const char* value)
+    {
+        return nullptr == value ? 0 : strlen(value);
+    }
+
+    inline size_t StringLength(const std::string& value)
+    {
+        return value.size();
+    }
+
+    inline const char* StringData(const char* value)
+    {
+        return value;
+    }
+
+    inline const char* StringData(const std::string& value)
+    {
+        return value.data();
+    }
+
+    inline char* EncodeString(char* cursor, const char* data, size_t length)
+    {
+        *cursor++ = static_cast<char>(ARG_TYPE::STRING);
+        uint32_t encodedLength = static_cast<uint32_t>(length);
+        memcpy(cursor, &encodedLength, sizeof(encodedLength));
+        cursor += sizeof(encodedLength);
+        if (length)
+        {
+            memcpy(cursor, data, length);
+        }
+
+        return cursor + length;
+    }
+
+    template <typename T>
+    inline char* EncodeValue(char* cursor, ARG_TYPE type, const T& value)
+    {
+        *cursor++ = static_cast<char>(type);
+        memcpy(cursor, &value, sizeof(T));
+        return cursor + sizeof(T);
+    }
+
+    /*
+     * Types with an encoding of their own, anything else goes through Prepare.
+     */
+    template <typename T>
+    struct IsCopied : std::integral_constant<bool, std::is_arithmetic<T>::value || IsString<T>::value> {};
+
+    template <size_t N>
+    struct IsCopied<char[N]> : std::true_type {};
+
+    template <typename T>
+    inline typename std::enable_if<IsCopied<T>::value, const T&>::type Prepare(const T& value)
+    {
+        return value;
+    }
+
+    /*
+     * Format an argument that is neither a number nor a string, once, so
+     * sizing and encoding it both use the same text.
+     */
+    template <typename T>
+    inline typename std::enable_if<!IsCopied<T>::value, std::string>::type Prepare(const T& value)
+    {
+        std::ostringstream stream;
+        stream << value;
+        return stream.str();
+    }
+
+    template <typename T, typename Enable = void>
+    struct Argument;
+
+    template <typename T>
+    struct Argument<T, typename std::enable_if<IsString<T>::value>::type>
+    {
+        static size_t Size(const T& value)
+        {
+            return 1 + sizeof(uint32_t) + StringLength(value);
+        }
+
+        static char* Encode(char* cursor, const T& value)
+        {
+            return EncodeString(cursor, StringData(value), StringLength(value));
+        }
+    };
+
+    template <size_t N>
+    struct Argument<char[N]>
+    {
+        static size_t Size(const char (&value)[N])
+        {
+            return 1 + sizeof(uint32_t) + strnlen(value, N);
+        }
+
+        static char* Encode(char* cursor, const char (&value)[N])
+        {
+            return EncodeString(cursor, value, strnlen(value, N));
+        }
+    };
+
+    template <typename T>
+    struct Argument<T, typename std::enable_if<std::is_same<T, bool>::value>::type>
+    {
+        static size_t Size(const T& /* value */)
+        {
+            return 2;
+        }
+
+        static char* Encode(char* cursor, const T& value)
+        {
+            return EncodeValue(cursor, ARG_TYPE::BOOL, value);
+        }
+    };
+
+    template <typename T>
+    struct Argument<T, typename std::enable_if<IsCharacter<T>::value>::type>
+    {
+        static size_t Size(const T& /* value */)
+        {
+            return 2;
+        }
+
+        static char* Encode(char* cursor, const T& value)
+        {
+            return EncodeValue(cursor, ARG_TYPE::CHAR, value);
+        }
+    };
+
+    template <typename T>
+    struct Argument<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && !IsCharacter<T>::value>::type>
+    {
+        static size_t Size(const T& /* value */)
+        {
+            return 1 + sizeof(uint64_t);
+        }
+
+        static char* Encode(char* cursor, const T& value)
+        {
+            if (std::is_signed<T>::value)
+            {
+                return EncodeValue(cursor, ARG_TYPE::INT, static_cast<int64_t>(value));
+            }
+
+            return EncodeValue(cursor, ARG_TYPE::UINT, static_cast<uint64_t>(value));
+        }
+    };
+
+    template <typename T>
+    struct Argument<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+    {
+        static size_t Size(const T& /* value */)
+        {
+            return 1 + sizeof(double);
+        }
+
+        static char* Encode(char* cursor, const T& value)
+        {
+            return EncodeValue(cursor, ARG_TYPE::DOUBLE, static_cast<double>(value));
+        }
+    };
+
+    /*
+     * What the text of a call site's arguments shows: how many there are
+     * and which ones are string literals, one bit per argument.
+     */
+    struct ARGUMENTS_TEXT
+    {
+        uint64_t literals;
+        size_t numArguments;
+    };
+
+    /*
+     * Split the stringized arguments of a LOG_* call at the commas outside
+     * brackets. An argument made of nothing but string literals is a
+     * literal. Text it cannot follow, like a raw string, only risks a wrong
+     * count, and Logger encodes every argument of a site whose count does
+     * not match.
+     */
+    constexpr ARGUMENTS_TEXT ParseArguments(const char* text)
+    {
+        ARGUMENTS_TEXT arguments = { 0, 0 };
+        size_t position = 0;
+        while (' ' == text[position])
+        {
+            position++;
+        }
+
+        if ('\0' == text[position])
+        {
+            return arguments;
+        }
+
+        while (true)
+        {
+            bool isLiteral = true;
+            bool hasString = false;
+            int depth = 0;
+            while ('\0' != text[position] && (',' != text[position] || 0 != depth))
+            {
+                char character = text[position];
+                if ('"' == character || '\'' == character)
+                {
+                    hasString = hasString || '"' == character;
+                    isLiteral = isLiteral && '"' == character;
+                    position++;
+                    while ('\0' != text[position] && character != text[position])
+                    {
+                        position += ('\\' == text[position] && '\0' != text[position + 1]) ? 2 : 1;
+                    }
+
+                    if ('\0' == text[position])
+                    {
+                        return ARGUMENTS_TEXT{ 0, 0 };
+                    }
+                }
+                else if ('(' == character || '[' == character || '{' == character)
+                {
+                    isLiteral = false;
+                    depth++;
+                }
+                else if (')' == character || ']' == character || '}' == character)
+                {
+                    isLiteral = false;
+                    depth--;
+                }
+                else if (' ' != character)
+                {
+                    isLiteral = false;
+                }
+
+                position++;
+            }
+
+            if (isLiteral && hasString && arguments.numArguments < 64)
+            {
+                arguments.literals |= uint64_t(1) << arguments.numArguments;
+            }
+
+            arguments.numArguments++;
+            if ('\0' == text[position])
+            {
+                return arguments;
+            }
+
+            position++;
+        }
+    }
+
+    /*
+     * The arguments of one call site. The text of its literals is only
+     * known once it logs, the first message fills texts in.
+     */
+    struct SITE_ARGUMENTS
+    {
+        // Literal arguments, cleared if the site's arguments do not match its text
+        uint64_t literals;
+        size_t numArguments;
+        // numArguments entries, only the literal ones are set
+        const char** texts;
+        // 0 until texts is filled in, 1 while it is, 2 after
+        std::atomic<int> state;
+    };
+
+    template <size_t N>
+    inline const char* LiteralText(const char (&value)[N])
+    {
+        return value;
+    }
+
+    template <typename T>
+    inline const char* LiteralText(const T&)
+    {
+        return nullptr;
+    }
+
+    inline void StoreLiteralTexts(SITE_ARGUMENTS&, size_t)
+    {
+    }
+
+    template <typename ThisArg, typename... RestOfArgs>
+    inline void StoreLiteralTexts(SITE_ARGUMENTS& arguments, size_t index, const ThisArg& arg1, const RestOfArgs&... args)
+    {
+        uint64_t bit = index < 64 ? uint64_t(1) << index : 0;
+        if (arguments.literals & bit)
+        {
+            arguments.texts[index] = LiteralText(arg1);
+            if (nullptr == arguments.texts[index])
+            {
+                arguments.literals &= ~bit;
+            }
+        }
+
+        StoreLiteralTexts(arguments, index + 1, args...);
+    }
+
+    /*
+     * Keep the text of the literal arguments the first time a site logs.
+     * Literals have static storage, so their addresses stay valid.
+     */
+    template <typename... Args>
+    inline void StoreLiterals(SITE_ARGUMENTS& arguments, const Args&... args)
+    {
+        int state = arguments.state.load(std::memory_order_acquire);
+        if (2 == state)
+        {
+            return;
+        }
+
+        if (0 == state && arguments.state.compare_exchange_strong(state, 1, std::memory_order_acq_rel))
+        {
+            if (sizeof...(Args) == arguments.numArguments)
+            {
+                StoreLiteralTexts(arguments, 0, args...);
+            }
+            else
+            {
+                arguments.literals = 0;
+            }
+
+            arguments.state.store(2, std::memory_order_release);
+            return;
+        }
+
+        while (2 != arguments.state.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    /*
+     * Size and encoding of the arguments whose bit is not set in literals.
+     */
+    inline size_t EncodedSize(uint64_t)
+    {
+        return 0;
+    }
+
+    template <typename ThisArg, typename... RestOfArgs>
+    inline size_t EncodedSize(uint64_t literals, const ThisArg& arg1, const RestOfArgs&... args)
+    {
+        return ((literals & 1) ? 0 : Argument<ThisArg>::Size(arg1)) + EncodedSize(literals >> 1, args...);
+    }
+
+    inline char* Encode(char* cursor, uint64_t)
+    {
+        return cursor;
+    }
+
+    template <typename ThisArg, typename... RestOfArgs>
+    inline char* Encode(char* cursor, uint64_t literals, const ThisArg& arg1, const RestOfArgs&... args)
+    {
+        return Encode((literals & 1) ? cursor : Argument<ThisArg>::Encode(cursor, arg1), literals >> 1, args...);
+    }
+
+    /*
+     * Whether [cursor, end) holds at least length more bytes.
+     */
+    inline bool HasBytes(const char* cursor, const char* end, size_t length)
+    {
+        return static_cast<size_t>(end - cursor) >= length;
+    }
+
+    /*
+     * Write the argument at cursor to the stream as text and move past it.
+     * Returns false if the encoding is malformed or truncated.
+     */
+    inline bool DecodeArgument(std::ostream& os, const char*& cursor, const char* end)
+    {
+        if (!HasBytes(cursor, end, 1))
+        {
+            return false;
+        }
+
+        ARG_TYPE type = static_cast<ARG_TYPE>(*cursor++);
+        switch (type)
+        {
+            case ARG_TYPE::INT:
+            {
+                int64_t value = 0;
+                if (!HasBytes(cursor, end, sizeof(value)))
+                {
+                    return false;
+                }
+
+                memcpy(&value, cursor, sizeof(value));
+                cursor += sizeof(value);
+                os << value;
+                break;
+            }
+            case ARG_TYPE::UINT:
+            {
+                uint64_t value = 0;
+                if (!HasBytes(cursor, end, sizeof(value)))
+                {
+                    return false;
+                }
+
+                memcpy(&value, cursor, sizeof(value));
+                cursor += sizeof(value);
+                os << value;
+                break;
+            }
+            case ARG_TYPE::DOUBLE:
+            {
+                double value = 0;
+                if (!HasBytes(cursor, end, sizeof(value)))
+                {
+                    return false;
+                }
+
+                memcpy(&value, cursor, sizeof(value));
+                cursor += sizeof(value);
+                os << value;
+                break;
+            }
+            case ARG_TYPE::BOOL:
+            {
+                if (!HasBytes(cursor, end, 1))
+                {
+                    return false;
+                }
+
+                os << (0 != *cursor++);
+                break;
+            }
+            case ARG_TYPE::CHAR:
+            {
+                if (!HasBytes(cursor, end, 1))
+                {
+                    return false;
+                }
+
+                os << *cursor++;
+                break;
+            }
+            case ARG_TYPE::STRING:
+            {
+                uint32_t length = 0;
+                if (!HasBytes(cursor, end, sizeof(length)))
+                {
+                    return false;
+                }
+
+                memcpy(&length, cursor, sizeof(length));
+                cursor += sizeof(length);
+                if (!HasBytes(cursor, end, length))
+                {
+                    return false;
+                }
+
+                os.write(cursor, length);
+                cursor += length;
+                break;
+            }
+            default:
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*
+     * Write a message to the stream as text, the literal arguments from
+     * texts and the others from [cursor, end).
+     */
+    inline bool Decode(std::ostream& os, const char* cursor, const char* end, uint64_t literals = 0, const char* const* texts = nullptr)
+    {
+        for (size_t index = 0; cursor < end || (index < 64 && 0 != (literals >> index)); index++)
+        {
+            if (index < 64 && (literals >> index) & 1)
+            {
+                os << texts[index];
+            }
+            else if (!DecodeArgument(os, cursor, end))
+            {
+                return false;
+            }
+        }
+
+        return cursor == end;
+    }
+}
+
+#endif
@@ -17,45 +17,210 @@
 #include <processthreadsapi.h>
 #else
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/syscall.h>
 #endif
 #include <iostream>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <string>
+#include <unordered_map>
 
 #include <common/UtilityFunctions.hh>
+#include <common/RingBuffer.hh>
+#include <common/LogEncoding.hh>
 
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
-// Template creates compile time arguments
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
-#define LOG_TEMPLATE( LEVEL, ... ) Logger::Instance().Log(std::cout, Logger::LEVEL, #LEVEL, GetCurrentProcessId(), GetCurrentThreadId(), __FILENAME__, __LINE__, ##__VA_ARGS__ )
+// Numeric log levels for the preprocessor, these match Logger::LogLevel
+#define LOG_LEVEL_FATAL 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_DEBUG 2
+#define LOG_LEVEL_INFO 3
+
+// Messages above this level are compiled out, arguments are not evaluated
+#ifndef QCDB_LOG_LEVEL
+#define QCDB_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Template creates compile time arguments, the static site describes the call site once
+#define LOG_TEMPLATE( LEVEL, ... ) \
+    [&]() -> std::ostream& \
+    { \
+        static constexpr LogEncoding::ARGUMENTS_TEXT arguments = LogEncoding::ParseArguments(#__VA_ARGS__); \
+        static const char* literalTexts[arguments.numArguments + 1]; \
+        static const Logger::LOG_SITE site = { Logger::LEVEL, #LEVEL, __FILENAME__, __LINE__, \
+            { arguments.literals, arguments.numArguments, literalTexts, { 0 } } }; \
+        return Logger::Instance().Log(std::cout, site, Logger::ProcessID(), Logger::ThreadID(), ##__VA_ARGS__ ); \
+    }()
+#define LOG_DISABLED( ... ) do { } while (0)
+
+#define LOG_FATAL( ... ) LOG_TEMPLATE( FATAL, ##__VA_ARGS__ )
+
+#if QCDB_LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN( ... ) LOG_TEMPLATE( WARN, ##__VA_ARGS__ )
 #else
-#define LOG_TEMPLATE( LEVEL, ... ) Logger::Instance().Log(std::cout, Logger::LEVEL, #LEVEL, getpid(), syscall(__NR_gettid), __FILENAME__, __LINE__, ##__VA_ARGS__ )
+#define LOG_WARN( ... ) LOG_DISABLED()
 #endif
+
+#if QCDB_LOG_LEVEL >= LOG_LEVEL_DEBUG
 #define LOG_DEBUG( ... ) LOG_TEMPLATE( DEBUG, ##__VA_ARGS__ )
+#else
+#define LOG_DEBUG( ... ) LOG_DISABLED()
+#endif
+
+#if QCDB_LOG_LEVEL >= LOG_LEVEL_INFO
 #define LOG_INFO( ... ) LOG_TEMPLATE( INFO, ##__VA_ARGS__ )
-#define LOG_WARN( ... ) LOG_TEMPLATE( WARN, ##__VA_ARGS__ )
-#define LOG_FATAL( ... ) LOG_TEMPLATE( FATAL, ##__VA_ARGS__ )
+#else
+#define LOG_INFO( ... ) LOG_DISABLED()
+#endif
 
 class Logger
 {
 public:
 
         typedef unsigned int LogLevel;
-        static constexpr LogLevel FATAL = 0;
-        static constexpr LogLevel WARN = 1;
-        static constexpr LogLevel DEBUG = 2;
-        static constexpr LogLevel INFO = 3;
+        static constexpr LogLevel FATAL = LOG_LEVEL_FATAL;
+        static constexpr LogLevel WARN = LOG_LEVEL_WARN;
+        static constexpr LogLevel DEBUG = LOG_LEVEL_DEBUG;
+        static constexpr LogLevel INFO = LOG_LEVEL_INFO;
         static constexpr LogLevel MAX_LOG_LEVEL = INFO;
 
+        // Bytes of pending messages each logging thread can queue
+        static constexpr size_t ASYNC_RING_SIZE = 256 * 1024;
+
+        // How long the writer thread sleeps when there is nothing to write
+        static constexpr int ASYNC_FLUSH_INTERVAL_MS = 10;
+
+        /*
+         * Everything about a log statement that is known at compile time.
+         * Each LOG_* call site has one static instance.
+         */
+        struct LOG_SITE
+        {
+            LogLevel level;
+            const char* debugLevel;
+            const char* fileName;
+            int lineNum;
+            // Which arguments are string literals and their text, kept here instead of in every message
+            mutable LogEncoding::SITE_ARGUMENTS arguments;
+        };
+
         template<typename Stream, typename... RestOfArgs>
-        Stream& Log(Stream& stream, LogLevel level, const char* debugLevel, int processID, int threadID, const char* fileName, int lineNum, const RestOfArgs& ... args)
+        Stream& Log(Stream& stream, const LOG_SITE& site, int processID, int threadID, const RestOfArgs& ... args)
         {
+            if(m_IsAsync.load(std::memory_order_acquire) && LogAsync(site, processID, threadID, args...))
+            {
+                return stream;
+            }
+
             /* Internal string stream used to ensure thread safety when printing.
              * It is passed through to collect the arguments into a single string,
              * which will do a single << to the input stream at the end
              */
             std::stringstream internalStream;
-            return PrependLog(stream, internalStream, level, debugLevel, processID, threadID, fileName, lineNum, args...);
+            return PrependLog(stream, internalStream, site.level, site.debugLevel, processID, threadID, site.fileName, site.lineNum, args...);
+        }
+
+        /*
+         * Switch to asynchronous logging. Callers only copy their arguments
+         * into a per thread ring and a background thread formats and writes
+         * them to output in batches.
+         */
+        void StartAsync(std::ostream& output = std::cout)
+        {
+            std::lock_guard<std::mutex> lock(m_AsyncMutex);
+            if(m_WriterThread.joinable())
+            {
+                return;
+            }
+
+            m_Output = &output;
+            m_SiteIDs.clear();
+            m_IsRunning.store(true, std::memory_order_release);
+            m_WriterThread = std::thread(&Logger::WriterThread, this);
+            m_IsAsync.store(true, std::memory_order_release);
+        }
+
+        /*
+         * Like StartAsync but the writer thread does no formatting at all.
+         * Messages are written to a binary file as the id of their call site
+         * and their encoded arguments, logDecoder turns the file into text.
+         */
+        bool StartBinary(const std::string& path)
+        {
+            StopAsync();
+
+            m_BinaryFile.open(path, std::ios::binary | std::ios::trunc);
+            if(!m_BinaryFile)
+            {
+                return false;
+            }
+
+            LogEncoding::BINARY_LOG_HEADER header = {};
+            memcpy(header.magic, LogEncoding::BINARY_LOG_MAGIC, sizeof(header.magic));
+            header.version = LogEncoding::BINARY_LOG_VERSION;
+            m_BinaryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            m_IsBinary = true;
+            StartAsync(m_BinaryFile);
+            return m_BinaryFile.good();
+        }
+
+        /*
+         * Write everything still queued and go back to synchronous logging.
+         */
+        void StopAsync(void)
+        {
+            std::lock_guard<std::mutex> lock(m_AsyncMutex);
+            if(!m_WriterThread.joinable())
+            {
+                return;
+            }
+
+            m_IsAsync.store(false, std::memory_order_release);
+            m_IsRunning.store(false, std::memory_order_release);
+            m_Wake.notify_one();
+            m_WriterThread.join();
+
+            // Catch messages from callers that saw m_IsAsync just before it changed
+            std::ostringstream batch;
+            if(DrainRings(batch))
+            {
+                *m_Output << batch.str();
+                m_Output->flush();
+            }
+
+            if(m_IsBinary)
+            {
+                m_BinaryFile.close();
+                m_Output = &std::cout;
+                m_IsBinary = false;
+            }
+        }
+
+        /*
+         * Block until every message logged so far has been written.
+         * The writer thread takes the request number before it drains the
+         * rings and publishes it once what it drained is written and
+         * flushed.
+         */
+        void Flush(void)
+        {
+            std::lock_guard<std::mutex> asyncLock(m_AsyncMutex);
+            if(!m_WriterThread.joinable())
+            {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(m_WakeMutex);
+            uint64_t request = ++m_FlushRequested;
+            m_Wake.notify_one();
+            m_Flushed.wait(lock, [&]() { return m_FlushCompleted >= request; });
         }
 
         // Singleton instance
@@ -65,70 +230,376 @@ public:
             return instance;
         }
 
+        /*
+         * Process and thread ids are cached per thread so logging does not
+         * make a system call for every message.
+         */
+        static int ProcessID(void)
+        {
+            return CachedIDs().processID;
+        }
+
+        static int ThreadID(void)
+        {
+            return CachedIDs().threadID;
+        }
+
 private:
 
-        template<typename Stream, typename... RestOfArgs>
-        Stream& PrependLog(Stream& stream, std::stringstream& internalStream, LogLevel level, const char* debugLevel, int processID, int threadID, const char* fileName, int lineNum, const RestOfArgs& ... args)
+        /*
+         * Fixed part of a queued message, followed by the encoded arguments.
+         * The site is static so only its address is copied.
+         */
+        struct ASYNC_RECORD
         {
-            if(INFO != level)
+            int64_t timestamp;
+            const LOG_SITE* site;
+            int processID;
+            int threadID;
+        };
+
+        struct THREAD_IDS
+        {
+            bool isCached;
+            int processID;
+            int threadID;
+        };
+
+        static THREAD_IDS& CachedIDs(void)
+        {
+            thread_local THREAD_IDS ids = { false, 0, 0 };
+            if(!ids.isCached)
+            {
+#ifdef WINDOWS_PLATFORM
+                ids.processID = GetCurrentProcessId();
+                ids.threadID = GetCurrentThreadId();
+#else
+                // The forking thread is the only one left in the child
+                static bool isForkHandlerSet = (0 == pthread_atfork(nullptr, nullptr, &Logger::AfterFork));
+                (void)isForkHandlerSet;
+                ids.processID = getpid();
+                ids.threadID = syscall(__NR_gettid);
+#endif
+                ids.isCached = true;
+            }
+
+            return ids;
+        }
+
+#ifndef WINDOWS_PLATFORM
+        static void AfterFork(void)
+        {
+            CachedIDs().isCached = false;
+
+            // The writer thread does not survive a fork
+            Logger& logger = Instance();
+            logger.m_IsAsync.store(false, std::memory_order_release);
+            logger.m_IsRunning.store(false, std::memory_order_release);
+            if(logger.m_WriterThread.joinable())
+            {
+                logger.m_WriterThread.detach();
+            }
+        }
+#endif
+
+        template<typename... RestOfArgs>
+        bool LogAsync(const LOG_SITE& site, int processID, int threadID, const RestOfArgs& ... args)
+        {
+            LogEncoding::StoreLiterals(site.arguments, args...);
+            return LogPrepared(site, processID, threadID, LogEncoding::Prepare(args)...);
+        }
+
+        /*
+         * Queue a message whose arguments are all numbers or strings, the
+         * literal ones are left to the site.
+         */
+        template<typename... RestOfArgs>
+        bool LogPrepared(const LOG_SITE& site, int processID, int threadID, const RestOfArgs& ... args)
+        {
+            uint64_t literals = site.arguments.literals;
+            size_t size = sizeof(ASYNC_RECORD) + LogEncoding::EncodedSize(literals, args...);
+            SPSCRingBuffer& ring = ThreadRing();
+
+            char* buffer = ring.Reserve(size);
+            while(nullptr == buffer)
+            {
+                // Too big to ever fit or the writer went away, log synchronously
+                if(size > ASYNC_RING_SIZE / 2 || !m_IsAsync.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+
+                m_Wake.notify_one();
+                std::this_thread::yield();
+                buffer = ring.Reserve(size);
+            }
+
+            ASYNC_RECORD record;
+            record.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            record.site = &site;
+            record.processID = processID;
+            record.threadID = threadID;
+
+            memcpy(buffer, &record, sizeof(record));
+            LogEncoding::Encode(buffer + sizeof(record), literals, args...);
+            ring.Commit();
+
+            return true;
+        }
+
+        SPSCRingBuffer& ThreadRing(void)
+        {
+            thread_local std::shared_ptr<SPSCRingBuffer> ring;
+            if(!ring)
             {
-                std::chrono::system_clock::time_point systemTime = std::chrono::system_clock::now();
-                std::chrono::microseconds microSeconds = std::chrono::duration_cast<std::chrono::microseconds>(systemTime.time_since_epoch()) % 1000000;
-                time_t time = std::chrono::system_clock::to_time_t(systemTime);
-                std::tm convertedTime = { 0 };
+                ring = std::make_shared<SPSCRingBuffer>(static_cast<size_t>(ASYNC_RING_SIZE));
+                std::lock_guard<std::mutex> lock(m_RingsMutex);
+                m_Rings.push_back(ring);
+            }
+
+            return *ring;
+        }
+
+        /*
+         * Format everything queued in every ring into one batch.
+         * Returns the number of messages formatted.
+         */
+        size_t DrainRings(std::ostringstream& batch)
+        {
+            std::vector<std::shared_ptr<SPSCRingBuffer>> rings;
+            {
+                std::lock_guard<std::mutex> lock(m_RingsMutex);
+                rings = m_Rings;
+            }
+
+            size_t numMessages = 0;
+            for(const std::shared_ptr<SPSCRingBuffer>& ring : rings)
+            {
+                size_t size = 0;
+                const char* message = ring->Front(size);
+                while(nullptr != message)
+                {
+                    ASYNC_RECORD record;
+                    memcpy(&record, message, sizeof(record));
+                    if(m_IsBinary)
+                    {
+                        WriteBinaryRecord(batch, record, message + sizeof(record), size - sizeof(record));
+                    }
+                    else
+                    {
+                        const LOG_SITE& site = *record.site;
+                        if(INFO != site.level)
+                        {
+                            std::chrono::system_clock::time_point systemTime{std::chrono::microseconds(record.timestamp)};
+                            WriteDecoration(batch, systemTime, site.debugLevel, record.processID, record.threadID, site.fileName, site.lineNum);
+                        }
+
+                        LogEncoding::Decode(batch, message + sizeof(record), message + size, site.arguments.literals, site.arguments.texts);
+                        batch << "\n";
+                    }
+
+                    ring->Pop();
+                    numMessages++;
+                    message = ring->Front(size);
+                }
+            }
+
+            // Drop rings whose threads have exited once they are drained
+            std::lock_guard<std::mutex> lock(m_RingsMutex);
+            for(size_t index = 0; index < m_Rings.size();)
+            {
+                // One reference here, one in the copy above
+                if(2 == m_Rings[index].use_count() && m_Rings[index]->Empty())
+                {
+                    m_Rings.erase(m_Rings.begin() + index);
+                }
+                else
+                {
+                    index++;
+                }
+            }
+
+            return numMessages;
+        }
+
+        /*
+         * Append a message to a binary batch, preceded by the definition of
+         * its call site the first time the site is seen.
+         */
+        void WriteBinaryRecord(std::ostringstream& batch, const ASYNC_RECORD& record, const char* arguments, size_t argumentsSize)
+        {
+            uint32_t siteID = 0;
+            std::unordered_map<const LOG_SITE*, uint32_t>::const_iterator found = m_SiteIDs.find(record.site);
+            if(m_SiteIDs.end() == found)
+            {
+                siteID = static_cast<uint32_t>(m_SiteIDs.size());
+                m_SiteIDs.emplace(record.site, siteID);
+
+                LogEncoding::BINARY_SITE_RECORD site = {};
+                site.type = static_cast<uint32_t>(LogEncoding::BINARY_RECORD_TYPE::SITE);
+                site.siteID = siteID;
+                site.level = record.site->level;
+                site.lineNum = record.site->lineNum;
+                site.debugLevelLength = static_cast<uint32_t>(strlen(record.site->debugLevel));
+                site.fileNameLength = static_cast<uint32_t>(strlen(record.site->fileName));
+                site.literals = record.site->arguments.literals;
+                batch.write(reinterpret_cast<const char*>(&site), sizeof(site));
+                batch.write(record.site->debugLevel, site.debugLevelLength);
+                batch.write(record.site->fileName, site.fileNameLength);
+                for(size_t index = 0; index < 64; index++)
+                {
+                    if((site.literals >> index) & 1)
+                    {
+                        uint32_t length = static_cast<uint32_t>(strlen(record.site->arguments.texts[index]));
+                        batch.write(reinterpret_cast<const char*>(&length), sizeof(length));
+                        batch.write(record.site->arguments.texts[index], length);
+                    }
+                }
+            }
+            else
+            {
+                siteID = found->second;
+            }
+
+            LogEncoding::BINARY_MESSAGE_RECORD message = {};
+            message.type = static_cast<uint32_t>(LogEncoding::BINARY_RECORD_TYPE::MESSAGE);
+            message.siteID = siteID;
+            message.timestamp = record.timestamp;
+            message.processID = record.processID;
+            message.threadID = record.threadID;
+            message.argumentsSize = static_cast<uint32_t>(argumentsSize);
+            batch.write(reinterpret_cast<const char*>(&message), sizeof(message));
+            batch.write(arguments, argumentsSize);
+        }
+
+        void WriterThread(void)
+        {
+            std::ostringstream batch;
+            while(true)
+            {
+                bool isRunning = m_IsRunning.load(std::memory_order_acquire);
+                uint64_t flushRequested = 0;
+                {
+                    std::lock_guard<std::mutex> lock(m_WakeMutex);
+                    flushRequested = m_FlushRequested;
+                }
+
+                size_t numMessages = DrainRings(batch);
+                if(numMessages)
+                {
+                    const std::string& text = batch.str();
+                    m_Output->write(text.data(), text.size());
+                    m_Output->flush();
+                    batch.str("");
+                }
+
+                std::unique_lock<std::mutex> lock(m_WakeMutex);
+                if(m_FlushCompleted < flushRequested)
+                {
+                    m_FlushCompleted = flushRequested;
+                    m_Flushed.notify_all();
+                }
+
+                if(numMessages)
+                {
+                    continue;
+                }
+                else if(!isRunning)
+                {
+                    break;
+                }
+                else if(flushRequested == m_FlushRequested)
+                {
+                    m_Wake.wait_for(lock, std::chrono::milliseconds(ASYNC_FLUSH_INTERVAL_MS));
+                }
+            }
+        }
+
+public:
+
+        /*
+         * [weekday mon day year hour:min:sec.usec]{filename:linenum}<processID:threadID>(debug level)
+         * localtime is only called when the second changes.
+         */
+        static void WriteDecoration(std::ostream& os, std::chrono::system_clock::time_point systemTime, const char* debugLevel, int processID, int threadID, const char* fileName, int lineNum)
+        {
+            thread_local time_t cachedTime = -1;
+            thread_local std::string cachedPrefix;
+
+            std::chrono::microseconds microSeconds = std::chrono::duration_cast<std::chrono::microseconds>(systemTime.time_since_epoch()) % 1000000;
+            time_t time = std::chrono::system_clock::to_time_t(systemTime);
+            if(time != cachedTime)
+            {
+                std::tm convertedTime = {};
+                std::ostringstream prefix;
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
                 errno_t error = localtime_s(&convertedTime, &time);
                 if(!error)
                 {
-                    // [weekday mon day year hour:min:sec.usec]
-                    internalStream
+                    prefix
                         << "["
-                        << std::put_time(&convertedTime, "%a %b %d %Y %H:%M:%S.")
-                        << std::setfill('0') << std::setw(6) << microSeconds.count()
-                        << "]";
+                        << std::put_time(&convertedTime, "%a %b %d %Y %H:%M:%S.");
                 }
                 else
                 {
-                    internalStream
+                    prefix
                         << "[Time error: "
                         << ErrorString(error)
-                        << "]";
+                        << " ";
                 }
 #else
-                convertedTime = *localtime(&time);
-                // [weekday mon day year hour:min:sec.usec]
-                internalStream
+                localtime_r(&time, &convertedTime);
+                prefix
                     << "["
-                    << std::put_time(&convertedTime, "%a %b %d %Y %H:%M:%S.")
-                    << std::setfill('0') << std::setw(6) << microSeconds.count()
-                    << "]";
+                    << std::put_time(&convertedTime, "%a %b %d %Y %H:%M:%S.");
 #endif
-                // <filename:linenum>
-                internalStream
-                    << "{"
-                    << fileName
-                    << ":"
-                    << lineNum
-                    << "}";
+                cachedPrefix = prefix.str();
+                cachedTime = time;
+            }
+
+            // [weekday mon day year hour:min:sec.usec]
+            os
+                << cachedPrefix
+                << std::setfill('0') << std::setw(6) << microSeconds.count()
+                << std::setfill(' ')
+                << "]";
 
-                // {processID:threadID}
-                internalStream
-                    << "<"
-                    << processID
-                    << ":"
-                    << threadID
-                    << ">";
+            // <filename:linenum>
+            os
+                << "{"
+                << fileName
+                << ":"
+                << lineNum
+                << "}";
 
-                // (debug level)
-                internalStream
-                    << "("
-                    << debugLevel
-                    << ")";
+            // {processID:threadID}
+            os
+                << "<"
+                << processID
+                << ":"
+                << threadID
+                << ">";
 
-                // Space between decorator and user text
-                internalStream << " ";
+            // (debug level)
+            os
+                << "("
+                << debugLevel
+                << ")";
 
+            // Space between decorator and user text
+            os << " ";
+        }
+
+private:
+
+        template<typename Stream, typename... RestOfArgs>
+        Stream& PrependLog(Stream& stream, std::stringstream& internalStream, LogLevel level, const char* debugLevel, int processID, int threadID, const char* fileName, int lineNum, const RestOfArgs& ... args)
+        {
+            if(INFO != level)
+            {
+                WriteDecoration(internalStream, std::chrono::system_clock::now(), debugLevel, processID, threadID, fileName, lineNum);
             }
 
             return Log(stream, internalStream, args...);
@@ -150,12 +621,39 @@ private:
             return ( stream << internalStream.str() );
         }
 
-        Logger()
+        Logger() :
+            m_IsAsync(false), m_IsRunning(false), m_IsBinary(false), m_Output(&std::cout),
+            m_FlushRequested(0), m_FlushCompleted(0)
         { }
 
+        ~Logger()
+        {
+            StopAsync();
+        }
 
         Logger(Logger const&) = delete;
         void operator = (Logger const&) = delete;
+
+        std::atomic<bool> m_IsAsync;
+        std::atomic<bool> m_IsRunning;
+        bool m_IsBinary;
+        std::ostream* m_Output;
+        std::ofstream m_BinaryFile;
+
+        // Only touched by the writer thread
+        std::unordered_map<const LOG_SITE*, uint32_t> m_SiteIDs;
+        std::thread m_WriterThread;
+        std::mutex m_AsyncMutex;
+
+        std::mutex m_RingsMutex;
+        std::vector<std::shared_ptr<SPSCRingBuffer>> m_Rings;
+
+        // Flush requests and the last one written, guarded by m_WakeMutex
+        std::mutex m_WakeMutex;
+        std::condition_variable m_Wake;
+        uint64_t m_FlushRequested;
+        uint64_t m_FlushCompleted;
+        std::condition_variable m_Flushed;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -36,4 +36,10 @@
     // Lock failed
     constexpr RETCODE RTN_LOCK_ERROR = 0x0100;
 
+    // Record changed since it was read
+    constexpr RETCODE RTN_CONFLICT = 0x0200;
+
+    // Data does not match its checksum
+    constexpr RETCODE RTN_CORRUPT = 0x0400;
+
 #endif
\ No newline at end of file
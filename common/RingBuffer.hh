@@ -0,0 +1,161 @@
+#ifndef __RING_BUFFER_HH
+#define __RING_BUFFER_HH
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include <common/Constants.hh>
+
+/*
+ * Lock-free single producer single consumer ring of variable sized records.
+ *
+ * Every record is stored contiguously behind a 4 byte length so the consumer
+ * can hand out a pointer straight into the buffer. When a record does not fit
+ * before the end of the buffer the remaining bytes are marked as padding and
+ * the record starts again at the front.
+ */
+class SPSCRingBuffer
+{
+public:
+
+    /*
+     * Capacity is rounded up to a power of two.
+     */
+    explicit SPSCRingBuffer(size_t capacity) :
+        m_Capacity(RoundUpPowerOfTwo(capacity)), m_Mask(m_Capacity - 1),
+        m_Buffer(m_Capacity), m_Head(0), m_CachedTail(0), m_Tail(0)
+    {
+    }
+
+    SPSCRingBuffer(SPSCRingBuffer const&) = delete;
+    void operator = (SPSCRingBuffer const&) = delete;
+
+    /*
+     * Producer: get space for a record of the given size.
+     * Returns nullptr if the ring is currently too full.
+     */
+    char* Reserve(size_t size)
+    {
+        size_t recordSize = RecordSize(size);
+        if (recordSize > m_Capacity)
+        {
+            return nullptr;
+        }
+
+        uint64_t head = m_Head.load(std::memory_order_relaxed);
+        size_t offset = head & m_Mask;
+        size_t contiguous = m_Capacity - offset;
+        size_t needed = recordSize <= contiguous ? recordSize : recordSize + contiguous;
+
+        if (m_Capacity - (head - m_CachedTail) < needed)
+        {
+            m_CachedTail = m_Tail.load(std::memory_order_acquire);
+            if (m_Capacity - (head - m_CachedTail) < needed)
+            {
+                return nullptr;
+            }
+        }
+
+        if (recordSize > contiguous)
+        {
+            // Skip to the front, the consumer will see the padding marker
+            uint32_t padding = PADDING;
+            memcpy(&m_Buffer[offset], &padding, sizeof(padding));
+            m_Head.store(head + contiguous, std::memory_order_release);
+            offset = 0;
+        }
+
+        uint32_t length = static_cast<uint32_t>(size);
+        memcpy(&m_Buffer[offset], &length, sizeof(length));
+        m_ReservedSize = recordSize;
+
+        return &m_Buffer[offset + HEADER_SIZE];
+    }
+
+    /*
+     * Producer: publish the record returned by the last Reserve.
+     */
+    void Commit(void)
+    {
+        m_Head.store(m_Head.load(std::memory_order_relaxed) + m_ReservedSize, std::memory_order_release);
+    }
+
+    /*
+     * Consumer: the oldest record, or nullptr if the ring is empty.
+     */
+    const char* Front(size_t& out_size)
+    {
+        uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+        while (tail != m_Head.load(std::memory_order_acquire))
+        {
+            size_t offset = tail & m_Mask;
+            uint32_t length = 0;
+            memcpy(&length, &m_Buffer[offset], sizeof(length));
+            if (PADDING == length)
+            {
+                tail += m_Capacity - offset;
+                m_Tail.store(tail, std::memory_order_release);
+                continue;
+            }
+
+            out_size = length;
+            return &m_Buffer[offset + HEADER_SIZE];
+        }
+
+        return nullptr;
+    }
+
+    /*
+     * Consumer: release the record returned by Front.
+     */
+    void Pop(void)
+    {
+        uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+        uint32_t length = 0;
+        memcpy(&length, &m_Buffer[tail & m_Mask], sizeof(length));
+        m_Tail.store(tail + RecordSize(length), std::memory_order_release);
+    }
+
+    bool Empty(void) const
+    {
+        return m_Tail.load(std::memory_order_acquire) == m_Head.load(std::memory_order_acquire);
+    }
+
+private:
+
+    static constexpr uint32_t PADDING = UINT32_MAX;
+    static constexpr size_t HEADER_SIZE = sizeof(uint32_t);
+
+    // Records stay 8 byte aligned so the length prefix never straddles the end
+    static size_t RecordSize(size_t size)
+    {
+        return (HEADER_SIZE + size + CONSTANTS::WORD_SIZE - 1) & ~(CONSTANTS::WORD_SIZE - 1);
+    }
+
+    static size_t RoundUpPowerOfTwo(size_t value)
+    {
+        size_t power = CONSTANTS::WORD_SIZE;
+        while (power < value)
+        {
+            power <<= 1;
+        }
+
+        return power;
+    }
+
+    const size_t m_Capacity;
+    const size_t m_Mask;
+    std::vector<char> m_Buffer;
+
+    // Producer and consumer indexes live on separate cache lines
+    alignas(CONSTANTS::CACHE_LINE_SIZE) std::atomic<uint64_t> m_Head;
+    size_t m_ReservedSize = 0;
+    uint64_t m_CachedTail;
+
+    alignas(CONSTANTS::CACHE_LINE_SIZE) std::atomic<uint64_t> m_Tail;
+};
+
+#endif
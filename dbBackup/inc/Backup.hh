@@ -0,0 +1,86 @@
+#ifndef __DB_BACKUP_HH
+#define __DB_BACKUP_HH
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include <common/Retcode.hh>
+#include <common/DBHeader.hh>
+#include <qcDB/Policies.hh>
+
+/*
+ * What a backup copied.
+ */
+struct BACKUP_SUMMARY
+{
+    bool isIncremental;
+    size_t numRounds;
+    size_t numBlocks;
+    size_t numBlocksCopied;
+    size_t numBytesCopied;
+};
+
+/*
+ * Backs a database file up into another file while writers keep going.
+ *
+ * Tables generated with --track-changes stamp every block of records they
+ * change with the generation in the DBHeader. A backup starts a new
+ * generation and copies the blocks stamped since the backup it updates,
+ * under the read lock a batch at a time, until few enough changed during a
+ * round. The last round holds the read lock while it copies the remaining
+ * blocks, the Bloom filters, the checksums and the header, so the backup is
+ * the table as of that moment. The backup header keeps the generation it
+ * is current to, the next backup into the same file only copies what
+ * changed since.
+ *
+ * Tables that do not track changes are copied whole under the read lock.
+ *
+ * The table must use the lock in the file, the default ProcessSharedLock.
+ */
+class DatabaseBackup
+{
+public:
+
+    DatabaseBackup(void);
+    ~DatabaseBackup(void);
+
+    DatabaseBackup(DatabaseBackup const&) = delete;
+    void operator = (DatabaseBackup const&) = delete;
+
+    RETCODE Open(const std::string& dbPath, const std::string& backupPath);
+
+    /*
+     * isFull: copy every block even if the backup file can be updated
+     */
+    RETCODE Run(bool isFull, BACKUP_SUMMARY& out_summary);
+
+private:
+
+    uint64_t BackupGeneration(void);
+    RETCODE CopyChangedBlocks(uint64_t since, bool isLocking, BACKUP_SUMMARY& out_summary, size_t& out_numCopied);
+    RETCODE CopyBlock(size_t block, BACKUP_SUMMARY& out_summary);
+    RETCODE CopyRange(size_t offset, size_t length, BACKUP_SUMMARY& out_summary);
+    RETCODE MarkIncomplete(void);
+    RETCODE WriteHeader(DBHeader header, uint64_t generation);
+    RETCODE Sync(void);
+
+    char* m_DBAddress;
+    size_t m_Size;
+    DBHeader* m_Header;
+    BLOCK_GENERATION* m_Generations;
+    int m_BackupFD;
+    std::string m_BackupPath;
+    qcDB::ProcessSharedLock m_Lock;
+
+    // Rounds copying while writers run before the locked last round
+    static constexpr size_t MAX_ROUNDS = 4;
+
+    // Changed blocks few enough to copy in the locked last round
+    static constexpr size_t LAST_ROUND_BLOCKS = 1024;
+
+    // Blocks copied per read lock acquisition in the other rounds
+    static constexpr size_t BATCH_BLOCKS = 256;
+};
+
+#endif
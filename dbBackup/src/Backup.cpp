@@ -0,0 +1,337 @@
+#include <dbBackup/inc/Backup.hh>
+
+#include <common/Logger.hh>
+#include <common/UtilityFunctions.hh>
+
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+DatabaseBackup::DatabaseBackup(void) :
+    m_DBAddress(nullptr), m_Size(0), m_Header(nullptr), m_Generations(nullptr), m_BackupFD(-1)
+{
+}
+
+DatabaseBackup::~DatabaseBackup(void)
+{
+    if (nullptr != m_DBAddress)
+    {
+        munmap(m_DBAddress, m_Size);
+    }
+
+    if (0 <= m_BackupFD)
+    {
+        close(m_BackupFD);
+    }
+}
+
+RETCODE DatabaseBackup::Open(const std::string& dbPath, const std::string& backupPath)
+{
+    int fd = open(dbPath.c_str(), O_RDWR);
+    if (0 > fd)
+    {
+        LOG_WARN("Could not open ", dbPath, " due to error: ", ErrorString(errno));
+        return RTN_NOT_FOUND;
+    }
+
+    struct stat statbuf;
+    if (0 > fstat(fd, &statbuf))
+    {
+        close(fd);
+        return RTN_NOT_FOUND;
+    }
+
+    // Writable since starting a generation writes the header
+    m_Size = statbuf.st_size;
+    void* address = mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == address)
+    {
+        LOG_WARN("Could not map ", dbPath, " due to error: ", ErrorString(errno));
+        return RTN_MALLOC_FAIL;
+    }
+
+    m_DBAddress = static_cast<char*>(address);
+    m_Header = reinterpret_cast<DBHeader*>(m_DBAddress);
+    if (sizeof(DBHeader) > m_Size || 0 == m_Header->m_RecordSize || m_Size < DatabaseFileSize(*m_Header))
+    {
+        LOG_WARN(dbPath, " is not a database generated by this version of dbGenerator");
+        return RTN_BAD_ARG;
+    }
+
+    if (m_Header->m_Generation)
+    {
+        size_t generationsOffset = GenerationsOffset(m_Header->m_NumRecords, m_Header->m_RecordSize,
+            __builtin_popcountll(m_Header->m_BloomFields), 0 != m_Header->m_Checksums);
+        m_Generations = reinterpret_cast<BLOCK_GENERATION*>(m_DBAddress + generationsOffset);
+    }
+
+    m_BackupPath = backupPath;
+    m_BackupFD = open(backupPath.c_str(), O_RDWR | O_CREAT, CONSTANTS::RW);
+    if (0 > m_BackupFD)
+    {
+        LOG_WARN("Could not open ", backupPath, " due to error: ", ErrorString(errno));
+        return RTN_NOT_FOUND;
+    }
+
+    return RTN_OK;
+}
+
+RETCODE DatabaseBackup::Run(bool isFull, BACKUP_SUMMARY& out_summary)
+{
+    RETCODE retcode = RTN_OK;
+    memset(&out_summary, 0, sizeof(out_summary));
+    out_summary.numBlocks = BackupBlocks(m_Header->m_NumRecords, m_Header->m_RecordSize);
+
+    uint64_t since = isFull ? 0 : BackupGeneration();
+    out_summary.isIncremental = 0 != since;
+    if (!out_summary.isIncremental && 0 != ftruncate(m_BackupFD, 0))
+    {
+        return RTN_EOF;
+    }
+
+    retcode = MarkIncomplete();
+    if (RTN_OK != retcode || 0 != ftruncate(m_BackupFD, m_Size))
+    {
+        return RTN_OK == retcode ? RTN_EOF : retcode;
+    }
+
+    DBHeader header;
+    size_t numCopied = 0;
+    if (nullptr == m_Generations)
+    {
+        // Nothing tells what changed, copy everything while writers wait
+        retcode = m_Lock.Lock(m_Header, true);
+        if (RTN_OK != retcode)
+        {
+            return retcode;
+        }
+
+        retcode = CopyRange(sizeof(DBHeader), m_Size - sizeof(DBHeader), out_summary);
+        memcpy(&header, m_Header, sizeof(header));
+        m_Lock.Unlock(m_Header, true);
+
+        out_summary.numBlocksCopied = out_summary.numBlocks;
+        out_summary.numRounds = 1;
+        retcode = RTN_OK == retcode ? Sync() : retcode;
+        return RTN_OK == retcode ? WriteHeader(header, 0) : retcode;
+    }
+
+    // Blocks changed while a round copies are copied again by the next one
+    for (; out_summary.numRounds < MAX_ROUNDS; out_summary.numRounds++)
+    {
+        retcode = m_Lock.Lock(m_Header, true);
+        if (RTN_OK != retcode)
+        {
+            return retcode;
+        }
+
+        uint64_t generation = __atomic_fetch_add(&m_Header->m_Generation, 1, __ATOMIC_SEQ_CST);
+        m_Lock.Unlock(m_Header, true);
+
+        retcode = CopyChangedBlocks(since, true, out_summary, numCopied);
+        if (RTN_OK != retcode)
+        {
+            return retcode;
+        }
+
+        // Blocks changed from here on are stamped with the new generation
+        since = generation + 1;
+        if (LAST_ROUND_BLOCKS >= numCopied)
+        {
+            break;
+        }
+    }
+
+    retcode = m_Lock.Lock(m_Header, true);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    uint64_t generation = __atomic_fetch_add(&m_Header->m_Generation, 1, __ATOMIC_SEQ_CST);
+    out_summary.numRounds++;
+    retcode = CopyChangedBlocks(since, false, out_summary, numCopied);
+
+    // The filters and checksums are small next to the records, they are copied whole
+    size_t numBloomFilters = __builtin_popcountll(m_Header->m_BloomFields);
+    if (RTN_OK == retcode && numBloomFilters)
+    {
+        retcode = CopyRange(BloomFiltersOffset(m_Header->m_NumRecords, m_Header->m_RecordSize),
+            numBloomFilters * BloomBlocks(m_Header->m_NumRecords) * sizeof(BLOOM_BLOCK), out_summary);
+    }
+
+    if (RTN_OK == retcode && m_Header->m_Checksums)
+    {
+        retcode = CopyRange(ChecksumsOffset(m_Header->m_NumRecords, m_Header->m_RecordSize, numBloomFilters),
+            ChecksumBlocks(m_Header->m_NumRecords, m_Header->m_RecordSize) * sizeof(BLOCK_CHECKSUM), out_summary);
+    }
+
+    // Copy the header while nothing can change it, it is written once the data is synced
+    memcpy(&header, m_Header, sizeof(header));
+    m_Lock.Unlock(m_Header, true);
+
+    retcode = RTN_OK == retcode ? Sync() : retcode;
+    return RTN_OK == retcode ? WriteHeader(header, generation + 1) : retcode;
+}
+
+/*
+ * The generation the backup file is current to if it is a complete backup
+ * of this table, 0 if everything has to be copied.
+ */
+uint64_t DatabaseBackup::BackupGeneration(void)
+{
+    struct stat statbuf;
+    DBHeader header;
+    if (nullptr == m_Generations || 0 > fstat(m_BackupFD, &statbuf) || m_Size != static_cast<size_t>(statbuf.st_size) ||
+        static_cast<ssize_t>(sizeof(header)) != pread(m_BackupFD, &header, sizeof(header), 0))
+    {
+        return 0;
+    }
+
+    bool isSameTable = 0 == strncmp(header.m_ObjectName, m_Header->m_ObjectName, sizeof(header.m_ObjectName)) &&
+        header.m_NumRecords == m_Header->m_NumRecords &&
+        header.m_RecordSize == m_Header->m_RecordSize &&
+        header.m_BloomFields == m_Header->m_BloomFields &&
+        header.m_Checksums == m_Header->m_Checksums;
+    if (!isSameTable || header.m_Generation > __atomic_load_n(&m_Header->m_Generation, __ATOMIC_ACQUIRE))
+    {
+        LOG_INFO(m_BackupPath, " is not a backup of this table, copying everything");
+        return 0;
+    }
+
+    return header.m_Generation;
+}
+
+RETCODE DatabaseBackup::CopyChangedBlocks(uint64_t since, bool isLocking, BACKUP_SUMMARY& out_summary, size_t& out_numCopied)
+{
+    RETCODE retcode = RTN_OK;
+    size_t numBlocks = BackupBlocks(m_Header->m_NumRecords, m_Header->m_RecordSize);
+    out_numCopied = 0;
+    for (size_t first = 0; first < numBlocks; first += BATCH_BLOCKS)
+    {
+        size_t last = std::min(first + BATCH_BLOCKS, numBlocks);
+        if (isLocking)
+        {
+            retcode = m_Lock.Lock(m_Header, true);
+            if (RTN_OK != retcode)
+            {
+                return retcode;
+            }
+        }
+
+        for (size_t block = first; block < last && RTN_OK == retcode; block++)
+        {
+            if (since <= __atomic_load_n(&m_Generations[block], __ATOMIC_ACQUIRE))
+            {
+                retcode = CopyBlock(block, out_summary);
+                out_numCopied++;
+            }
+        }
+
+        if (isLocking)
+        {
+            m_Lock.Unlock(m_Header, true);
+        }
+
+        if (RTN_OK != retcode)
+        {
+            return retcode;
+        }
+    }
+
+    return RTN_OK;
+}
+
+/*
+ * A block of records and the versions of every record in it.
+ */
+RETCODE DatabaseBackup::CopyBlock(size_t block, BACKUP_SUMMARY& out_summary)
+{
+    size_t recordsLength = m_Header->m_NumRecords * m_Header->m_RecordSize;
+    size_t first = block * BACKUP_BLOCK_SIZE;
+    size_t length = std::min(BACKUP_BLOCK_SIZE, recordsLength - first);
+    RETCODE retcode = CopyRange(sizeof(DBHeader) + first, length, out_summary);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    size_t firstRecord = first / m_Header->m_RecordSize;
+    size_t lastRecord = (first + length - 1) / m_Header->m_RecordSize;
+    size_t versionsOffset = VersionsOffset(m_Header->m_NumRecords, m_Header->m_RecordSize);
+    out_summary.numBlocksCopied++;
+    return CopyRange(versionsOffset + firstRecord * sizeof(RECORD_VERSION), (lastRecord - firstRecord + 1) * sizeof(RECORD_VERSION), out_summary);
+}
+
+RETCODE DatabaseBackup::CopyRange(size_t offset, size_t length, BACKUP_SUMMARY& out_summary)
+{
+    out_summary.numBytesCopied += length;
+    while (length)
+    {
+        ssize_t numWritten = pwrite(m_BackupFD, m_DBAddress + offset, length, offset);
+        if (0 > numWritten && EINTR == errno)
+        {
+            continue;
+        }
+
+        if (0 >= numWritten)
+        {
+            LOG_WARN("Could not write ", m_BackupPath, " due to error: ", ErrorString(errno));
+            return RTN_EOF;
+        }
+
+        offset += numWritten;
+        length -= numWritten;
+    }
+
+    return RTN_OK;
+}
+
+/*
+ * Until a backup completes its file is no base for another backup, an
+ * interrupted one is copied whole the next time.
+ */
+RETCODE DatabaseBackup::MarkIncomplete(void)
+{
+    uint64_t generation = 0;
+    ssize_t numWritten = pwrite(m_BackupFD, &generation, sizeof(generation), offsetof(DBHeader, m_Generation));
+    return static_cast<ssize_t>(sizeof(generation)) == numWritten ? RTN_OK : RTN_EOF;
+}
+
+/*
+ * The header of the table with the generation the backup is current to
+ * and a lock of its own.
+ */
+RETCODE DatabaseBackup::WriteHeader(DBHeader header, uint64_t generation)
+{
+    header.m_Generation = generation;
+
+    pthread_rwlockattr_t lockAttributes;
+    pthread_rwlockattr_init(&lockAttributes);
+    pthread_rwlockattr_setpshared(&lockAttributes, PTHREAD_PROCESS_SHARED);
+    pthread_rwlock_init(&header.m_DBLock, &lockAttributes);
+
+    if (static_cast<ssize_t>(sizeof(header)) != pwrite(m_BackupFD, &header, sizeof(header), 0))
+    {
+        LOG_WARN("Could not write ", m_BackupPath, " due to error: ", ErrorString(errno));
+        return RTN_EOF;
+    }
+
+    return Sync();
+}
+
+RETCODE DatabaseBackup::Sync(void)
+{
+    if (0 != fsync(m_BackupFD))
+    {
+        LOG_WARN("Could not sync ", m_BackupPath, " due to error: ", ErrorString(errno));
+        return RTN_EOF;
+    }
+
+    return RTN_OK;
+}
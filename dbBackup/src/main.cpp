@@ -0,0 +1,47 @@
+#include <common/Retcode.hh>
+#include <common/Logger.hh>
+#include <common/CLI.hh>
+
+#include <dbBackup/inc/Backup.hh>
+
+int main(int argc, char* argv[])
+{
+    CLI_StringArgument dbPathArg("-d", "The database file to back up", true);
+    CLI_StringArgument backupPathArg("-o", "The backup file, updated with the changes since it was taken if it exists", true);
+    CLI_FlagArgument fullArg("--full", "Copy every block even if the backup file can be updated");
+
+    Parser parser("dbBackup", "Back up a qcDB file while it is in use");
+
+    parser
+        .AddArg(dbPathArg)
+        .AddArg(backupPathArg)
+        .AddArg(fullArg);
+
+    RETCODE retcode = parser.ParseCommandLineArguments(argc, argv);
+    if (RTN_OK != retcode)
+    {
+        parser.Usage();
+        return retcode;
+    }
+
+    DatabaseBackup backup;
+    retcode = backup.Open(dbPathArg.GetValue(), backupPathArg.GetValue());
+    if (RTN_OK != retcode)
+    {
+        LOG_FATAL("Could not open: ", dbPathArg.GetValue(), " with error: ", retcode);
+        return retcode;
+    }
+
+    BACKUP_SUMMARY summary;
+    retcode = backup.Run(fullArg.IsInUse(), summary);
+    if (RTN_OK != retcode)
+    {
+        LOG_FATAL("Could not back up: ", dbPathArg.GetValue(), " with error: ", retcode);
+        return retcode;
+    }
+
+    LOG_INFO(summary.isIncremental ? "Incremental" : "Full", " backup of ", dbPathArg.GetValue(), " in ", summary.numRounds,
+        " rounds copied ", summary.numBlocksCopied, " of ", summary.numBlocks, " blocks, ", summary.numBytesCopied, " bytes");
+
+    return RTN_OK;
+}
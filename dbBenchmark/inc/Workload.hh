@@ -0,0 +1,81 @@
+#ifndef __WORKLOAD_HH
+#define __WORKLOAD_HH
+
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+#include <common/Retcode.hh>
+#include <common/Histogram.hh>
+
+/*
+ * Operations the benchmark can issue against a dbInterface.
+ */
+enum class OPERATION : size_t
+{
+    READ = 0,
+    READ_BATCH,
+    WRITE,
+    WRITE_BATCH,
+    DELETE_RECORD,
+    FIND,
+    NUM_OPERATIONS
+};
+
+constexpr size_t NUM_OPERATIONS = static_cast<size_t>(OPERATION::NUM_OPERATIONS);
+
+const char* OperationName(OPERATION operation);
+
+/*
+ * ~3% relative error on latencies in nanoseconds.
+ */
+using LatencyHistogram = Histogram<5>;
+
+struct WORKLOAD_OPTIONS
+{
+    std::string schemaPath;
+    std::string outputDirectory;
+    std::string databasePath;
+    size_t numRecords;
+    size_t seconds;
+    size_t numProcesses;
+    size_t numThreads;
+    size_t batchSize;
+    // Relative weight of each operation
+    size_t mix[NUM_OPERATIONS];
+};
+
+/*
+ * Results of a single worker thread. Plain data so it can be written
+ * by forked processes into a shared mapping.
+ */
+struct WORKER_RESULTS
+{
+    LatencyHistogram latencies[NUM_OPERATIONS];
+    uint64_t errors[NUM_OPERATIONS];
+    uint64_t elapsedNanoseconds;
+};
+
+/*
+ * Parse a mix such as "read=50,write=30,find=1" into per operation weights.
+ * Operations that are not listed get a weight of 0.
+ */
+RETCODE ParseOperationMix(const std::string& mix, WORKLOAD_OPTIONS& out_options);
+
+/*
+ * Generate the schema, header and database into the output directory and
+ * fill every record so reads hit real data.
+ */
+RETCODE PrepareDatabase(WORKLOAD_OPTIONS& options);
+
+/*
+ * Run the operation mix against the database until the time is up.
+ */
+void RunWorker(const WORKLOAD_OPTIONS& options, size_t workerIndex, WORKER_RESULTS& out_results);
+
+/*
+ * Merge all worker results and write them as a single JSON document.
+ */
+void WriteReport(const WORKLOAD_OPTIONS& options, const WORKER_RESULTS* results, size_t numResults, std::ostream& os);
+
+#endif
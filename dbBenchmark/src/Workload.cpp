@@ -0,0 +1,390 @@
+#include <dbBenchmark/inc/Workload.hh>
+#include <dbGenerator/inc/Schema.hh>
+
+#include <common/Logger.hh>
+#include <common/Constants.hh>
+#include <common/UtilityFunctions.hh>
+
+#include <qcDB/qcDB.hh>
+#include <dbHeaders/BENCHMARK.hh>
+
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <cstdio>
+
+static const char* OPERATION_NAMES[NUM_OPERATIONS] =
+{
+    "read",
+    "readBatch",
+    "write",
+    "writeBatch",
+    "delete",
+    "find"
+};
+
+const char* OperationName(OPERATION operation)
+{
+    return OPERATION_NAMES[static_cast<size_t>(operation)];
+}
+
+RETCODE ParseOperationMix(const std::string& mix, WORKLOAD_OPTIONS& out_options)
+{
+    for (size_t operation = 0; operation < NUM_OPERATIONS; operation++)
+    {
+        out_options.mix[operation] = 0;
+    }
+
+    size_t totalWeight = 0;
+    std::istringstream mixStream(mix);
+    std::string entry;
+    while (std::getline(mixStream, entry, ','))
+    {
+        size_t separator = entry.find('=');
+        if (std::string::npos == separator)
+        {
+            LOG_WARN("Operation mix entry: ", entry, " is not of the form name=weight");
+            return RTN_BAD_ARG;
+        }
+
+        std::string name = entry.substr(0, separator);
+        size_t weight = 0;
+        try
+        {
+            weight = std::stoul(entry.substr(separator + 1));
+        }
+        catch (std::exception const& except)
+        {
+            LOG_WARN("Could not convert weight of: ", entry, " due to error: ", except.what());
+            return RTN_BAD_ARG;
+        }
+
+        bool found = false;
+        for (size_t operation = 0; operation < NUM_OPERATIONS; operation++)
+        {
+            if (name == OPERATION_NAMES[operation])
+            {
+                out_options.mix[operation] = weight;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            LOG_WARN("Unknown operation: ", name, " in operation mix");
+            return RTN_BAD_ARG;
+        }
+
+        totalWeight += weight;
+    }
+
+    if (0 == totalWeight)
+    {
+        LOG_WARN("Operation mix: ", mix, " has no operations");
+        return RTN_BAD_ARG;
+    }
+
+    return RTN_OK;
+}
+
+/*
+ * Copy the benchmark schema into the output directory with the requested
+ * number of records so the struct layout always matches the compiled header.
+ */
+static RETCODE WriteSchema(const WORKLOAD_OPTIONS& options, std::string& out_schemaPath)
+{
+    std::ifstream schema(options.schemaPath);
+    if (!schema)
+    {
+        LOG_FATAL("Failed to open: ", options.schemaPath, " due to error: ", ErrorString(errno));
+        return RTN_NOT_FOUND;
+    }
+
+    out_schemaPath = options.outputDirectory + "BENCHMARK" + CONSTANTS::SCHEMA_EXT;
+    std::ofstream output(out_schemaPath);
+    if (!output)
+    {
+        LOG_FATAL("Failed to create: ", out_schemaPath, " due to error: ", ErrorString(errno));
+        return RTN_NOT_FOUND;
+    }
+
+    bool readObject = false;
+    std::string line;
+    while (std::getline(schema, line))
+    {
+        size_t firstNonEmptyChar = line.find_first_not_of(' ');
+        if (std::string::npos == firstNonEmptyChar || CONSTANTS::SCHEMA_COMMENT == line.at(firstNonEmptyChar))
+        {
+            continue;
+        }
+
+        if (!readObject)
+        {
+            size_t objectNumber = 0;
+            std::string objectName;
+            std::istringstream lineStream(line);
+            lineStream >> objectNumber >> objectName;
+            output << objectNumber << " " << objectName << " " << options.numRecords << "\n";
+            readObject = true;
+        }
+        else
+        {
+            output << line << "\n";
+        }
+    }
+
+    if (output.bad())
+    {
+        LOG_FATAL("Could not write: ", out_schemaPath, " due to error: ", ErrorString(errno));
+        return RTN_FAIL;
+    }
+
+    return RTN_OK;
+}
+
+static void FillRecord(size_t record, uint64_t counter, BENCHMARK& out_object)
+{
+    out_object = { 0 };
+    out_object.KEY = record + 1;
+    out_object.COUNTER = counter;
+    snprintf(out_object.NAME, sizeof(out_object.NAME), "record_%zu", record);
+}
+
+RETCODE PrepareDatabase(WORKLOAD_OPTIONS& options)
+{
+    std::string schemaPath;
+    RETCODE retcode = WriteSchema(options, schemaPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    // Start from an empty file, otherwise old records survive the resize
+    options.databasePath = options.outputDirectory + "BENCHMARK" + CONSTANTS::DB_EXT;
+    std::remove(options.databasePath.c_str());
+
+    GENERATE_OPTIONS generateOptions = { 0 };
+    retcode = GenerateDatabase(schemaPath, options.outputDirectory, options.outputDirectory, generateOptions);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<BENCHMARK> database(options.databasePath);
+    if (database.NumberOfRecords() != options.numRecords)
+    {
+        LOG_FATAL("Could not open: ", options.databasePath);
+        return RTN_NOT_FOUND;
+    }
+
+    constexpr size_t FILL_BATCH = 4096;
+    std::vector<std::tuple<size_t, BENCHMARK>> batch;
+    batch.reserve(FILL_BATCH);
+    for (size_t record = 0; record < options.numRecords; record++)
+    {
+        BENCHMARK object;
+        FillRecord(record, 0, object);
+        batch.emplace_back(record, object);
+
+        if (FILL_BATCH == batch.size() || options.numRecords - 1 == record)
+        {
+            retcode = database.WriteObjects(batch);
+            if (RTN_OK != retcode)
+            {
+                LOG_FATAL("Failed to fill: ", options.databasePath, " with error: ", retcode);
+                return retcode;
+            }
+
+            batch.clear();
+        }
+    }
+
+    LOG_DEBUG("Filled: ", options.numRecords, " records of: ", options.databasePath);
+
+    return RTN_OK;
+}
+
+void RunWorker(const WORKLOAD_OPTIONS& options, size_t workerIndex, WORKER_RESULTS& out_results)
+{
+    for (size_t operation = 0; operation < NUM_OPERATIONS; operation++)
+    {
+        out_results.latencies[operation].Reset();
+        out_results.errors[operation] = 0;
+    }
+
+    qcDB::dbInterface<BENCHMARK> database(options.databasePath);
+    size_t numRecords = database.NumberOfRecords();
+    if (0 == numRecords)
+    {
+        LOG_WARN("Worker: ", workerIndex, " could not open: ", options.databasePath);
+        return;
+    }
+
+    size_t totalWeight = 0;
+    for (size_t operation = 0; operation < NUM_OPERATIONS; operation++)
+    {
+        totalWeight += options.mix[operation];
+    }
+
+    std::mt19937_64 generator(workerIndex * 0x9E3779B97F4A7C15ull + 1);
+    std::uniform_int_distribution<size_t> recordDistribution(0, numRecords - 1);
+    std::uniform_int_distribution<size_t> mixDistribution(0, totalWeight - 1);
+
+    std::vector<std::tuple<size_t, BENCHMARK>> batch(options.batchSize);
+    std::vector<BENCHMARK> found;
+    BENCHMARK object = { 0 };
+    uint64_t counter = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point end = start + std::chrono::seconds(options.seconds);
+    std::chrono::steady_clock::time_point now = start;
+
+    while (now < end)
+    {
+        size_t pick = mixDistribution(generator);
+        size_t operation = 0;
+        for (; operation < NUM_OPERATIONS - 1; operation++)
+        {
+            if (pick < options.mix[operation])
+            {
+                break;
+            }
+
+            pick -= options.mix[operation];
+        }
+
+        size_t record = recordDistribution(generator);
+        if (static_cast<size_t>(OPERATION::READ_BATCH) == operation || static_cast<size_t>(OPERATION::WRITE_BATCH) == operation)
+        {
+            for (std::tuple<size_t, BENCHMARK>& entry : batch)
+            {
+                std::get<0>(entry) = recordDistribution(generator);
+                FillRecord(std::get<0>(entry), ++counter, std::get<1>(entry));
+            }
+        }
+
+        RETCODE retcode = RTN_OK;
+        std::chrono::steady_clock::time_point operationStart = std::chrono::steady_clock::now();
+        switch (static_cast<OPERATION>(operation))
+        {
+            case OPERATION::READ:
+            {
+                retcode = database.ReadObject(record, object);
+                break;
+            }
+            case OPERATION::READ_BATCH:
+            {
+                retcode = database.ReadObjects(batch);
+                break;
+            }
+            case OPERATION::WRITE:
+            {
+                FillRecord(record, ++counter, object);
+                retcode = database.WriteObject(record, object);
+                break;
+            }
+            case OPERATION::WRITE_BATCH:
+            {
+                retcode = database.WriteObjects(batch);
+                break;
+            }
+            case OPERATION::DELETE_RECORD:
+            {
+                retcode = database.DeleteObject(record);
+                break;
+            }
+            case OPERATION::FIND:
+            {
+                uint64_t key = record + 1;
+                found.clear();
+                retcode = database.FindObjects(
+                    [key](const BENCHMARK* current) -> bool
+                    {
+                        return current->KEY == key;
+                    },
+                    found);
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+        now = std::chrono::steady_clock::now();
+
+        uint64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(now - operationStart).count();
+        out_results.latencies[operation].Record(latency);
+        if (RTN_OK != retcode)
+        {
+            out_results.errors[operation]++;
+        }
+    }
+
+    out_results.elapsedNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+}
+
+void WriteReport(const WORKLOAD_OPTIONS& options, const WORKER_RESULTS* results, size_t numResults, std::ostream& os)
+{
+    // Merged histograms are too big for the stack
+    std::vector<LatencyHistogram> merged(NUM_OPERATIONS + 1);
+    uint64_t errors[NUM_OPERATIONS + 1] = { 0 };
+    uint64_t elapsedNanoseconds = 0;
+
+    for (LatencyHistogram& histogram : merged)
+    {
+        histogram.Reset();
+    }
+
+    for (size_t result = 0; result < numResults; result++)
+    {
+        for (size_t operation = 0; operation < NUM_OPERATIONS; operation++)
+        {
+            merged[operation].Merge(results[result].latencies[operation]);
+            merged[NUM_OPERATIONS].Merge(results[result].latencies[operation]);
+            errors[operation] += results[result].errors[operation];
+            errors[NUM_OPERATIONS] += results[result].errors[operation];
+        }
+
+        if (results[result].elapsedNanoseconds > elapsedNanoseconds)
+        {
+            elapsedNanoseconds = results[result].elapsedNanoseconds;
+        }
+    }
+
+    double elapsedSeconds = elapsedNanoseconds / 1e9;
+    if (0.0 == elapsedSeconds)
+    {
+        elapsedSeconds = 1.0;
+    }
+
+    os << "{\n";
+    os << "  \"config\": {"
+       << "\"records\": " << options.numRecords
+       << ", \"recordSize\": " << sizeof(BENCHMARK)
+       << ", \"seconds\": " << options.seconds
+       << ", \"processes\": " << options.numProcesses
+       << ", \"threads\": " << options.numThreads
+       << ", \"batchSize\": " << options.batchSize
+       << ", \"mix\": {";
+    for (size_t operation = 0; operation < NUM_OPERATIONS; operation++)
+    {
+        os << (operation ? ", " : "") << "\"" << OPERATION_NAMES[operation] << "\": " << options.mix[operation];
+    }
+    os << "}},\n";
+
+    os << "  \"elapsedSeconds\": " << elapsedSeconds << ",\n";
+    os << "  \"operations\": {\n";
+    for (size_t operation = 0; operation <= NUM_OPERATIONS; operation++)
+    {
+        const char* name = NUM_OPERATIONS == operation ? "total" : OPERATION_NAMES[operation];
+        os << "    \"" << name << "\": {"
+           << "\"opsPerSecond\": " << merged[operation].m_TotalCount / elapsedSeconds
+           << ", \"errors\": " << errors[operation]
+           << ", \"latencyNanoseconds\": ";
+        WriteHistogramJSON(os, merged[operation]);
+        os << "}" << (NUM_OPERATIONS == operation ? "\n" : ",\n");
+    }
+    os << "  }\n";
+    os << "}\n";
+}
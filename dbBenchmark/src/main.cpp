@@ -0,0 +1,177 @@
+#include <common/Retcode.hh>
+#include <common/Logger.hh>
+#include <common/CLI.hh>
+#include <common/Constants.hh>
+#include <common/OSdefines.hh>
+
+#include <dbBenchmark/inc/Workload.hh>
+
+#include <thread>
+#include <fstream>
+
+#ifndef WINDOWS_PLATFORM
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
+
+static const std::string DEFAULT_MIX = "read=50,readBatch=10,write=25,writeBatch=10,delete=4,find=1";
+
+/*
+ * Run every worker thread of one process.
+ */
+static void RunProcess(const WORKLOAD_OPTIONS& options, size_t processIndex, WORKER_RESULTS* results)
+{
+    std::vector<std::thread> threads;
+    for (size_t threadIndex = 0; threadIndex < options.numThreads; threadIndex++)
+    {
+        size_t workerIndex = processIndex * options.numThreads + threadIndex;
+        threads.emplace_back(RunWorker, std::cref(options), workerIndex, std::ref(results[workerIndex]));
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    CLI_StringArgument directoryArg("-d", "Directory to generate the benchmark schema, header and database in");
+    CLI_IntArgument recordsArg("-r", "Number of records in the benchmark database");
+    CLI_IntArgument timeArg("-s", "Number of seconds to run the workload");
+    CLI_IntArgument numProcessArg("-p", "Number of worker processes");
+    CLI_IntArgument numThreadArg("-t", "Number of worker threads per process");
+    CLI_IntArgument batchArg("-b", "Number of records per batch read/write");
+    CLI_StringArgument mixArg("-m", "Operation weights, e.g. " + DEFAULT_MIX);
+    CLI_StringArgument outputArg("-o", "Write the JSON report to this file instead of stdout");
+
+    Parser parser("dbBenchmark", "Benchmark qcDB operations across threads and processes");
+
+    parser
+        .AddArg(directoryArg)
+        .AddArg(recordsArg)
+        .AddArg(timeArg)
+        .AddArg(numProcessArg)
+        .AddArg(numThreadArg)
+        .AddArg(batchArg)
+        .AddArg(mixArg)
+        .AddArg(outputArg);
+
+    RETCODE retcode = parser.ParseCommandLineArguments(argc, argv);
+    if (RTN_OK != retcode)
+    {
+        parser.Usage();
+        return retcode;
+    }
+
+    WORKLOAD_OPTIONS options;
+    options.schemaPath = QCDB_BENCHMARK_SCHEMA;
+    options.outputDirectory = directoryArg.IsInUse() ? directoryArg.GetValue() : CONSTANTS::CURRENT_DIRECTORY;
+    options.numRecords = recordsArg.IsInUse() ? recordsArg.GetValue() : 100000;
+    options.seconds = timeArg.IsInUse() ? timeArg.GetValue() : 5;
+    options.numProcesses = numProcessArg.IsInUse() ? numProcessArg.GetValue() : 1;
+    options.numThreads = numThreadArg.IsInUse() ? numThreadArg.GetValue() : 1;
+    options.batchSize = batchArg.IsInUse() ? batchArg.GetValue() : 20;
+
+    if ('/' != options.outputDirectory.back())
+    {
+        options.outputDirectory += '/';
+    }
+
+    if (0 == options.numRecords || 0 == options.numProcesses || 0 == options.numThreads || 0 == options.batchSize)
+    {
+        LOG_FATAL("Records, processes, threads and batch size must be greater than 0");
+        parser.Usage();
+        return RTN_BAD_ARG;
+    }
+
+    retcode = ParseOperationMix(mixArg.IsInUse() ? mixArg.GetValue() : DEFAULT_MIX, options);
+    if (RTN_OK != retcode)
+    {
+        parser.Usage();
+        return retcode;
+    }
+
+    retcode = PrepareDatabase(options);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+#ifdef WINDOWS_PLATFORM
+    if (1 < options.numProcesses)
+    {
+        LOG_WARN("Multiple processes are not supported on Windows, running threads only");
+        options.numProcesses = 1;
+    }
+#endif
+
+    size_t numWorkers = options.numProcesses * options.numThreads;
+    size_t resultsSize = numWorkers * sizeof(WORKER_RESULTS);
+
+#ifdef WINDOWS_PLATFORM
+    std::vector<WORKER_RESULTS> resultsBuffer(numWorkers);
+    WORKER_RESULTS* results = resultsBuffer.data();
+    RunProcess(options, 0, results);
+#else
+    // Shared with the forked workers so the parent can merge their histograms
+    WORKER_RESULTS* results = static_cast<WORKER_RESULTS*>(mmap(nullptr, resultsSize,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (MAP_FAILED == static_cast<void*>(results))
+    {
+        LOG_FATAL("Could not map results due to error: ", ErrorString(errno));
+        return RTN_MALLOC_FAIL;
+    }
+
+    std::vector<pid_t> pids;
+    for (size_t processIndex = 0; processIndex < options.numProcesses; processIndex++)
+    {
+        pid_t pid = fork();
+        if (0 == pid)
+        {
+            RunProcess(options, processIndex, results);
+            _exit(0);
+        }
+        else if (0 > pid)
+        {
+            LOG_FATAL("Could not fork worker process due to error: ", ErrorString(errno));
+            return RTN_FAIL;
+        }
+
+        pids.push_back(pid);
+    }
+
+    for (size_t processIndex = 0; processIndex < pids.size(); processIndex++)
+    {
+        int status = 0;
+        while (-1 == waitpid(pids[processIndex], &status, 0));
+        if (!WIFEXITED(status) || 0 != WEXITSTATUS(status))
+        {
+            LOG_FATAL("Worker process: ", processIndex, " (pid ", pids[processIndex], ") failed");
+            retcode = RTN_FAIL;
+        }
+    }
+#endif
+
+    if (outputArg.IsInUse())
+    {
+        std::ofstream output(outputArg.GetValue());
+        if (!output)
+        {
+            LOG_FATAL("Could not create: ", outputArg.GetValue(), " due to error: ", ErrorString(errno));
+            return RTN_NOT_FOUND;
+        }
+
+        WriteReport(options, results, numWorkers, output);
+    }
+    else
+    {
+        WriteReport(options, results, numWorkers, std::cout);
+    }
+
+#ifndef WINDOWS_PLATFORM
+    munmap(results, resultsSize);
+#endif
+
+    return retcode;
+}
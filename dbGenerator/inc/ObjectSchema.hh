@@ -32,6 +32,7 @@ struct FIELD_SCHEMA
     size_t numElements;
     size_t fieldSize;
     size_t fieldAlignment;
+    bool hasBloomFilter;
 };
 
 inline std::istream& operator >> (std::istream& input_stream,
@@ -65,6 +66,8 @@ struct OBJECT_SCHEMA
     size_t numberOfRecords;
     std::vector<FIELD_SCHEMA> fields;
     size_t objectSize;
+    size_t objectAlignment; // Only set when records are aligned past their fields
+    bool isReordered;
 };
 
 inline std::istream& operator >> (std::istream& input_stream,
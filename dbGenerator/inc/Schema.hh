@@ -2,8 +2,30 @@
 #define __SCHEMA_HH
 
 #include <string>
+#include <cstddef>
 #include <common/Retcode.hh>
 
-RETCODE GenerateDatabase(const std::string& schemaPath, const std::string& headerOutputPath, const std::string& databaseOutputPath, bool isStrict);
+/*
+ * How dbGenerator lays out the records and files. Zero initialized options
+ * generate a single file with the fields in schema order.
+ */
+struct GENERATE_OPTIONS
+{
+    // Fail if the fields need padding
+    bool isStrict;
+    // Reorder fields by alignment so no padding is needed
+    bool isOptimized;
+    // Align records so none of them straddles a cache line
+    bool isCacheAligned;
+    // Split the records across this many files, see ShardFilePath
+    size_t numShards;
+    // Keep a checksum of every block of records, see qcDB/Checksum.hh
+    bool hasChecksums;
+    // Stamp changed blocks of records for incremental backups
+    bool isTrackingChanges;
+};
+
+RETCODE GenerateDatabase(const std::string& schemaPath, const std::string& headerOutputPath, const std::string& databaseOutputPath,
+    const GENERATE_OPTIONS& options);
 
 #endif
\ No newline at end of file
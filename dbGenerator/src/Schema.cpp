@@ -8,6 +8,7 @@
 
 #include <fcntl.h>
 #include <fstream>
+#include <algorithm>
 
 static RETCODE ParseField(std::istringstream& lineStream, FIELD_SCHEMA& out_field)
 {
@@ -17,6 +18,19 @@ static RETCODE ParseField(std::istringstream& lineStream, FIELD_SCHEMA& out_fiel
         return RTN_BAD_ARG;
     }
 
+    // Optional attributes after the number of elements
+    std::string attribute;
+    while(lineStream >> attribute)
+    {
+        if(CONSTANTS::SCHEMA_BLOOM_FILTER != attribute)
+        {
+            LOG_FATAL("field: ", out_field.fieldName, " attribute: ", attribute, " is invalid");
+            return RTN_BAD_ARG;
+        }
+
+        out_field.hasBloomFilter = true;
+    }
+
     switch(static_cast<FIELD_TYPE>(out_field.fieldType))
     {
         case FIELD_TYPE::INT:
@@ -119,15 +133,53 @@ static RETCODE ParseObject(std::istringstream& lineStream, OBJECT_SCHEMA& out_ob
     return RTN_OK;
 }
 
+/*
+ * Fields are emitted in layout order, reflection keeps the schema order so
+ * generic code sees the same field indexes whatever the layout is.
+ */
+static std::vector<const FIELD_SCHEMA*> FieldsInSchemaOrder(const OBJECT_SCHEMA& object)
+{
+    std::vector<const FIELD_SCHEMA*> fields;
+    for(const FIELD_SCHEMA& field : object.fields)
+    {
+        fields.push_back(&field);
+    }
+
+    std::stable_sort(fields.begin(), fields.end(),
+        [](const FIELD_SCHEMA* left, const FIELD_SCHEMA* right)
+        {
+            return left->fieldNumber < right->fieldNumber;
+        });
+
+    return fields;
+}
+
 static RETCODE GenerateObjectHeader(const OBJECT_SCHEMA& object, std::ofstream& headerFile)
 {
     headerFile << "// GENERATED: DO NOT MODIFY!!\n";
     /* Header guard */
     headerFile << "#ifndef " << std::uppercase << object.objectName << "__HH\n";
     headerFile << "#define " << std::uppercase << object.objectName << "__HH\n\n";
+    headerFile << "#include <cstddef>\n";
+    headerFile << "#include <qcDB/Reflection.hh>\n";
+
+    if(object.isReordered)
+    {
+        headerFile << "\n/* Fields reordered by dbGenerator --optimize, schema order:";
+        for(size_t field = 0; field < object.fields.size(); field++)
+        {
+            headerFile << " " << FieldsInSchemaOrder(object)[field]->fieldName;
+        }
+        headerFile << " */";
+    }
+
+    headerFile << "\nstruct ";
+    if(object.objectAlignment)
+    {
+        headerFile << "alignas(" << object.objectAlignment << ") ";
+    }
 
     headerFile
-        << "\nstruct "
         << std::uppercase
         << object.objectName
         << "\n{";
@@ -244,10 +296,86 @@ static RETCODE GenerateFieldHeader(const FIELD_SCHEMA& field, std::ofstream& hea
     return RTN_OK;
 }
 
+/*
+ * Field types and descriptors so generic code never has to parse the schema.
+ */
+static RETCODE GenerateObjectReflection(const OBJECT_SCHEMA& object, std::ofstream& headerFile)
+{
+    const std::string& name = object.objectName;
+    std::vector<const FIELD_SCHEMA*> fields = FieldsInSchemaOrder(object);
+
+    headerFile << "namespace " << name << "_FIELDS\n{";
+    for(size_t field = 0; field < fields.size(); field++)
+    {
+        const std::string& fieldName = fields[field]->fieldName;
+        headerFile
+            << "\n    using " << fieldName
+            << " = qcDB::Field<" << name << ", " << field
+            << ", decltype(" << name << "::" << fieldName << ")"
+            << ", &" << name << "::" << fieldName << ">;";
+    }
+    headerFile << "\n}\n\n";
+
+    headerFile
+        << "namespace qcDB\n{\n"
+        << "    template <>\n"
+        << "    struct Reflection<" << name << ">\n    {\n"
+        << "        static constexpr const char* OBJECT_NAME = \"" << name << "\";\n"
+        << "        static constexpr size_t OBJECT_NUMBER = " << object.objectNumber << ";\n"
+        << "        static constexpr size_t NUM_RECORDS = " << object.numberOfRecords << ";\n"
+        << "        static constexpr size_t NUM_FIELDS = " << fields.size() << ";\n"
+        << "        static constexpr bool IS_REORDERED = " << (object.isReordered ? "true" : "false") << ";\n\n"
+        << "        static constexpr FIELD_DESCRIPTOR FIELDS[NUM_FIELDS] =\n        {";
+
+    for(const FIELD_SCHEMA* field : fields)
+    {
+        headerFile
+            << "\n            { \"" << field->fieldName << "\", '" << field->fieldType << "'"
+            << ", offsetof(" << name << ", " << field->fieldName << ")"
+            << ", sizeof(" << name << "::" << field->fieldName << ")"
+            << ", " << field->numElements << " },";
+    }
+
+    // Index into FIELDS of each member in memory order
+    headerFile << "\n        };\n\n        static constexpr size_t LAYOUT_ORDER[NUM_FIELDS] = { ";
+    for(size_t member = 0; member < object.fields.size(); member++)
+    {
+        size_t field = std::find(fields.begin(), fields.end(), &object.fields[member]) - fields.begin();
+        headerFile << (member ? ", " : "") << field;
+    }
+
+    headerFile << " };\n\n        using Fields = std::tuple<";
+    for(size_t field = 0; field < fields.size(); field++)
+    {
+        headerFile
+            << (field ? ", " : "")
+            << name << "_FIELDS::" << fields[field]->fieldName;
+    }
+    headerFile << ">;\n    };\n}\n\n";
+
+    if(headerFile.bad())
+    {
+        LOG_FATAL("Could not generate reflection for object: ",
+            name,
+            " due to error: ",
+            ErrorString(errno));
+
+        return RTN_FAIL;
+    }
+
+    return RTN_OK;
+}
+
 static RETCODE GenerateObectFooter(const OBJECT_SCHEMA& object, std::ofstream& headerFile)
 {
     headerFile << "\n};\n\n";
 
+    RETCODE retcode = GenerateObjectReflection(object, headerFile);
+    if(RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
     headerFile << "#endif";
 
     if(headerFile.bad())
@@ -311,10 +439,118 @@ size_t inline CalculatePadding(const OBJECT_SCHEMA& object, const FIELD_SCHEMA&
     return padding;
 }
 
-RETCODE CreateDatabaseFile(const OBJECT_SCHEMA& object, const std::string& databaseOutputDirectory)
+/*
+ * Place the fields and work out the record size, including the padding the
+ * compiler adds to the end of the struct.
+ */
+static RETCODE LayoutObject(OBJECT_SCHEMA& object, const GENERATE_OPTIONS& options)
 {
-    std::string databaseFile = databaseOutputDirectory + object.objectName + CONSTANTS::DB_EXT;
-    size_t fileSize = sizeof(DBHeader) + object.objectSize * object.numberOfRecords;
+    if(options.isOptimized)
+    {
+        // Largest alignment first leaves no gaps since every alignment is a power of two
+        std::vector<FIELD_SCHEMA> schemaOrder = object.fields;
+        std::stable_sort(object.fields.begin(), object.fields.end(),
+            [](const FIELD_SCHEMA& left, const FIELD_SCHEMA& right)
+            {
+                return left.fieldAlignment > right.fieldAlignment;
+            });
+
+        for(size_t field = 0; field < object.fields.size(); field++)
+        {
+            if(object.fields[field].fieldNumber != schemaOrder[field].fieldNumber)
+            {
+                object.isReordered = true;
+            }
+        }
+    }
+
+    size_t objectAlignment = 1;
+    object.objectSize = 0;
+    for(const FIELD_SCHEMA& field : object.fields)
+    {
+        size_t padding = CalculatePadding(object, field);
+        if(options.isStrict && padding)
+        {
+            LOG_FATAL("Padding of: ",
+                padding,
+                " bytes dected for field: ",
+                field.fieldName,
+                " number: ",
+                field.fieldNumber);
+
+            return RTN_BAD_ARG;
+        }
+
+        object.objectSize += field.fieldSize + padding;
+        objectAlignment = std::max(objectAlignment, field.fieldAlignment);
+    }
+
+    object.objectSize += (objectAlignment - object.objectSize % objectAlignment) % objectAlignment;
+
+    if(options.isCacheAligned)
+    {
+        /* Small records are aligned to the next power of two so a whole number
+         * of them fits in a cache line, bigger ones start on a cache line. */
+        size_t recordAlignment = objectAlignment;
+        while(recordAlignment < object.objectSize && recordAlignment < CONSTANTS::CACHE_LINE_SIZE)
+        {
+            recordAlignment <<= 1;
+        }
+
+        if(recordAlignment > objectAlignment)
+        {
+            object.objectAlignment = recordAlignment;
+            object.objectSize += (recordAlignment - object.objectSize % recordAlignment) % recordAlignment;
+        }
+    }
+
+    if(object.isReordered || object.objectAlignment)
+    {
+        LOG_DEBUG("OBJECT: ", object.objectName,
+            " reordered: ", object.isReordered,
+            " record alignment: ", object.objectAlignment ? object.objectAlignment : objectAlignment);
+    }
+
+    return RTN_OK;
+}
+
+/*
+ * Bit per schema field index that has a Bloom filter.
+ */
+static RETCODE BloomFields(const OBJECT_SCHEMA& object, uint64_t& out_bloomFields)
+{
+    out_bloomFields = 0;
+    std::vector<const FIELD_SCHEMA*> fields = FieldsInSchemaOrder(object);
+    for(size_t field = 0; field < fields.size(); field++)
+    {
+        if(!fields[field]->hasBloomFilter)
+        {
+            continue;
+        }
+
+        if(64 <= field)
+        {
+            LOG_FATAL("field: ", fields[field]->fieldName, " is past the first 64 fields and can not have a Bloom filter");
+            return RTN_BAD_ARG;
+        }
+
+        out_bloomFields |= 1ULL << field;
+    }
+
+    return RTN_OK;
+}
+
+RETCODE CreateDatabaseFile(const OBJECT_SCHEMA& object, const std::string& databaseFile, size_t numRecords, const GENERATE_OPTIONS& options)
+{
+    uint64_t bloomFields = 0;
+    RETCODE retcode = BloomFields(object, bloomFields);
+    if(RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    // Checksums start from zero so the zeroed blocks need no initial checksum
+    size_t fileSize = DatabaseFileSize(numRecords, object.objectSize, __builtin_popcountll(bloomFields), options.hasChecksums, options.isTrackingChanges);
 
     LOG_DEBUG(databaseFile, " is: ", fileSize, " bytes");
 
@@ -376,7 +612,13 @@ RETCODE CreateDatabaseFile(const OBJECT_SCHEMA& object, const std::string& datab
 #endif
 
     DBHeader dbHeader = { 0 };
-    dbHeader.m_NumRecords = object.numberOfRecords;
+    dbHeader.m_NumRecords = numRecords;
+    dbHeader.m_RecordSize = object.objectSize;
+    dbHeader.m_BloomFields = bloomFields;
+    dbHeader.m_Checksums = options.hasChecksums ? 1 : 0;
+
+    // Generation 0 means changes are not tracked
+    dbHeader.m_Generation = options.isTrackingChanges ? 1 : 0;
 
 #ifdef WINDOWS_PLATFORM
 
@@ -448,7 +690,8 @@ RETCODE CreateDatabaseFile(const OBJECT_SCHEMA& object, const std::string& datab
     return RTN_OK;
 }
 
-RETCODE GenerateDatabase(const std::string& schemaPath, const std::string& headerOutputPath, const std::string& databaseOutputPath, bool isStrict)
+RETCODE GenerateDatabase(const std::string& schemaPath, const std::string& headerOutputPath, const std::string& databaseOutputPath,
+    const GENERATE_OPTIONS& options)
 {
     RETCODE retcode = RTN_OK;
     size_t currentLineNumber = 0;
@@ -496,23 +739,6 @@ RETCODE GenerateDatabase(const std::string& schemaPath, const std::string& heade
                 return retcode;
             }
 
-            size_t padding = CalculatePadding(object, field);
-            if(isStrict)
-            {
-                if(padding)
-                {
-                    LOG_FATAL("Padding of: ",
-                        padding,
-                        " bytes dected for field: ",
-                        field.fieldName,
-                        " on line: ",
-                        currentLineNumber);
-
-                    return RTN_BAD_ARG;
-                }
-            }
-
-            object.objectSize += field.fieldSize + padding;
             object.fields.push_back(field);
         }
         else
@@ -528,6 +754,12 @@ RETCODE GenerateDatabase(const std::string& schemaPath, const std::string& heade
         }
     }
 
+    retcode = LayoutObject(object, options);
+    if(RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
     LOG_DEBUG("OBJECT: ", object.objectName, " size is: ", object.objectSize, " bytes per record");
 
     retcode = GenerateHeader(object, headerOutputPath);
@@ -536,10 +768,20 @@ RETCODE GenerateDatabase(const std::string& schemaPath, const std::string& heade
         return retcode;
     }
 
-    retcode = CreateDatabaseFile(object, databaseOutputPath);
-    if(RTN_OK != retcode)
+    std::string databaseFile = databaseOutputPath + object.objectName + CONSTANTS::DB_EXT;
+    if(1 >= options.numShards)
     {
-        return retcode;
+        return CreateDatabaseFile(object, databaseFile, object.numberOfRecords, options);
+    }
+
+    for(size_t shard = 0; shard < options.numShards; shard++)
+    {
+        retcode = CreateDatabaseFile(object, ShardFilePath(databaseFile, shard),
+            ShardNumRecords(object.numberOfRecords, options.numShards), options);
+        if(RTN_OK != retcode)
+        {
+            return retcode;
+        }
     }
 
     return retcode;
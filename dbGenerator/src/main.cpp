@@ -11,6 +11,11 @@ int main(int argc, char* argv[])
     CLI_StringArgument headerPathArg("-h", "Path to the header file");
     CLI_StringArgument databasePathArg("-d", "Path to the database file");
     CLI_FlagArgument strictArg("--strict", "Enforce byte boundaries for compact databases");
+    CLI_FlagArgument optimizeArg("--optimize", "Reorder fields to remove padding");
+    CLI_FlagArgument cacheLineArg("--cache-line", "Align records so none straddles a cache line");
+    CLI_IntArgument shardsArg("--shards", "Split the records across this many database files");
+    CLI_FlagArgument checksumsArg("--checksums", "Keep a CRC32C checksum of every block of records");
+    CLI_FlagArgument trackChangesArg("--track-changes", "Track changed blocks of records for incremental backups");
 
     Parser parser("dbGenerator", "Generates a qcDB file");
 
@@ -18,7 +23,12 @@ int main(int argc, char* argv[])
         .AddArg(schemaArg)
         .AddArg(headerPathArg)
         .AddArg(databasePathArg)
-        .AddArg(strictArg);
+        .AddArg(strictArg)
+        .AddArg(optimizeArg)
+        .AddArg(cacheLineArg)
+        .AddArg(shardsArg)
+        .AddArg(checksumsArg)
+        .AddArg(trackChangesArg);
 
     RETCODE retcode = parser.ParseCommandLineArguments(argc, argv);
     if(RTN_OK != retcode)
@@ -27,6 +37,13 @@ int main(int argc, char* argv[])
         return retcode;
     }
 
+    int numShards = shardsArg.IsInUse() ? shardsArg.GetValue() : 1;
+    if(0 >= numShards)
+    {
+        parser.Usage();
+        return RTN_BAD_ARG;
+    }
+
     std::string schemaPath = schemaArg.GetValue();
 
     std::string headerOutputPath;
@@ -49,10 +66,15 @@ int main(int argc, char* argv[])
         databaseOutputPath = CONSTANTS::CURRENT_DIRECTORY;
     }
 
-    retcode = GenerateDatabase(schemaPath,
-        headerOutputPath,
-        databaseOutputPath,
-        strictArg.IsInUse());
+    GENERATE_OPTIONS options = { 0 };
+    options.isStrict = strictArg.IsInUse();
+    options.isOptimized = optimizeArg.IsInUse();
+    options.isCacheAligned = cacheLineArg.IsInUse();
+    options.numShards = numShards;
+    options.hasChecksums = checksumsArg.IsInUse();
+    options.isTrackingChanges = trackChangesArg.IsInUse();
+
+    retcode = GenerateDatabase(schemaPath, headerOutputPath, databaseOutputPath, options);
 
     return retcode;
 }
\ No newline at end of file
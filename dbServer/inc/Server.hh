@@ -0,0 +1,87 @@
+#ifndef __DB_SERVER_HH
+#define __DB_SERVER_HH
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+
+#include <common/Retcode.hh>
+#include <qcDB/Protocol.hh>
+#include <dbServer/inc/Table.hh>
+
+/*
+ * Serves database tables to dbClient over a Unix domain socket.
+ *
+ * One thread runs an epoll loop. Every time it wakes up it reads everything
+ * the ready clients sent, then runs all complete requests for a table in a
+ * single lock section, so many pipelined or concurrent requests cost one
+ * lock handoff.
+ *
+ * A client is not read while it has more than MAX_PENDING_OUTPUT bytes of
+ * responses it did not take yet, and at most MAX_BUFFERED_INPUT bytes of its
+ * requests are read at a time, so a client that sends without reading
+ * cannot make the server buffer without bound.
+ */
+class Server
+{
+public:
+
+    Server(void);
+    ~Server(void);
+
+    RETCODE AddTable(const std::string& dbPath);
+    RETCODE Listen(const std::string& socketPath);
+
+    /*
+     * Serve until Stop is called, from a signal handler or another thread.
+     */
+    RETCODE Run(void);
+    void Stop(void);
+
+private:
+
+    struct CLIENT
+    {
+        int fd;
+        std::vector<char> input;
+        // Bytes of input taken by the requests of the current batch
+        size_t consumed;
+        std::vector<char> output;
+        size_t outputOffset;
+        // The epoll events the client is registered for
+        uint32_t events;
+        bool isClosing;
+    };
+
+    // A complete request waiting in a client's input buffer
+    struct PENDING_REQUEST
+    {
+        CLIENT* client;
+        size_t offset;
+    };
+
+    void AcceptClients(void);
+    void ReadClient(CLIENT& client);
+    void ParseRequests(CLIENT& client, std::vector<PENDING_REQUEST>& out_requests);
+    void RunBatch(const std::vector<PENDING_REQUEST>& requests);
+    void RunRequest(const PENDING_REQUEST& request);
+    void Respond(CLIENT& client, const qcDB::REQUEST_HEADER& request, RETCODE retcode, uint64_t version, const char* payload, size_t length);
+    void FlushClient(CLIENT& client);
+    void UpdateEvents(CLIENT& client);
+    void CloseClient(int fd);
+
+    static bool IsReadRequest(uint16_t opcode);
+
+    std::vector<std::unique_ptr<ServedTable>> m_Tables;
+    std::unordered_map<int, std::unique_ptr<CLIENT>> m_Clients;
+    std::string m_SocketPath;
+    std::vector<char> m_RecordBuffer;
+    int m_ListenFD;
+    int m_EpollFD;
+    std::atomic<bool> m_IsRunning;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef __SERVED_TABLE_HH
+#define __SERVED_TABLE_HH
+
+#include <string>
+#include <cstdint>
+
+#include <common/Retcode.hh>
+#include <common/DBHeader.hh>
+#include <qcDB/Policies.hh>
+#include <qcDB/Statistics.hh>
+#include <qcDB/Protocol.hh>
+#include <qcDB/RecordStore.hh>
+
+/*
+ * A database file served by dbServer. The server does not know the object
+ * types so records are plain bytes of the size stored in the DBHeader.
+ * Writes follow the same rules as dbInterface, and the lock in the file is
+ * still used so processes that map the file directly keep working.
+ */
+class ServedTable
+{
+public:
+
+    ServedTable(void);
+    ~ServedTable(void);
+
+    ServedTable(ServedTable const&) = delete;
+    void operator = (ServedTable const&) = delete;
+
+    RETCODE Open(const std::string& dbPath);
+
+    RETCODE Lock(bool isRead);
+    RETCODE Unlock(bool isRead);
+
+    /*
+     * The table must be locked, for writing for everything but Read and Info.
+     */
+    RETCODE Read(uint64_t record, char* out_record, uint64_t& out_version);
+    RETCODE Write(uint64_t record, const char* recordData, uint64_t& out_version);
+    RETCODE CompareAndWrite(uint64_t record, uint64_t expectedVersion, const char* recordData, uint64_t& out_version);
+    RETCODE Delete(uint64_t record, uint64_t& out_version);
+    qcDB::TABLE_INFO Info(size_t table) const;
+
+    std::string ObjectName(void) const;
+
+    size_t RecordSize(void) const
+    {
+        return m_Header->m_RecordSize;
+    }
+
+private:
+
+    char* Get(uint64_t record);
+
+    char* m_DBAddress;
+    size_t m_Size;
+    DBHeader* m_Header;
+    qcDB::RecordStore m_Store;
+    qcDB::ProcessSharedLock m_Lock;
+    qcDB::dbStatistics m_Statistics;
+};
+
+#endif
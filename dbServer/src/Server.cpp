@@ -0,0 +1,521 @@
+#include <dbServer/inc/Server.hh>
+
+#include <common/Logger.hh>
+#include <common/UtilityFunctions.hh>
+
+#include <cstring>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static constexpr int MAX_EVENTS = 64;
+static constexpr int POLL_INTERVAL_MS = 100;
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+// Room for the largest request, the Protocol limits the payload
+static constexpr size_t MAX_BUFFERED_INPUT = 2 * (sizeof(qcDB::REQUEST_HEADER) + qcDB::MAX_PAYLOAD_SIZE);
+static constexpr size_t MAX_PENDING_OUTPUT = 4 * 1024 * 1024;
+static_assert(qcDB::MAX_PIPELINED_BYTES < MAX_BUFFERED_INPUT && qcDB::MAX_PIPELINED_BYTES < MAX_PENDING_OUTPUT,
+    "A pipelined batch of dbClient must fit what the server buffers per client");
+
+static bool SetNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return 0 <= flags && 0 == fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+Server::Server(void) :
+    m_ListenFD(-1), m_EpollFD(-1), m_IsRunning(false)
+{
+}
+
+Server::~Server(void)
+{
+    while (!m_Clients.empty())
+    {
+        CloseClient(m_Clients.begin()->first);
+    }
+
+    if (0 <= m_ListenFD)
+    {
+        close(m_ListenFD);
+        unlink(m_SocketPath.c_str());
+    }
+
+    if (0 <= m_EpollFD)
+    {
+        close(m_EpollFD);
+    }
+}
+
+RETCODE Server::AddTable(const std::string& dbPath)
+{
+    std::unique_ptr<ServedTable> table(new ServedTable());
+    RETCODE retcode = table->Open(dbPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    for (const std::unique_ptr<ServedTable>& served : m_Tables)
+    {
+        if (served->ObjectName() == table->ObjectName())
+        {
+            LOG_WARN("A table of object ", table->ObjectName(), " is already served");
+            return RTN_BAD_ARG;
+        }
+    }
+
+    m_RecordBuffer.resize(std::max(m_RecordBuffer.size(), table->RecordSize()));
+
+    LOG_INFO("Serving ", table->ObjectName(), " from ", dbPath);
+    m_Tables.push_back(std::move(table));
+    return RTN_OK;
+}
+
+RETCODE Server::Listen(const std::string& socketPath)
+{
+    sockaddr_un address = { 0 };
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        LOG_WARN("Socket path is too long: ", socketPath);
+        return RTN_BAD_ARG;
+    }
+
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    m_ListenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (0 > m_ListenFD)
+    {
+        LOG_WARN("Could not create socket due to error: ", ErrorString(errno));
+        return RTN_CONNECTION_FAIL;
+    }
+
+    // A stale socket from a server that did not exit cleanly
+    unlink(socketPath.c_str());
+
+    if (0 > bind(m_ListenFD, reinterpret_cast<sockaddr*>(&address), sizeof(address)) ||
+        0 > listen(m_ListenFD, SOMAXCONN) ||
+        !SetNonBlocking(m_ListenFD))
+    {
+        LOG_WARN("Could not listen on ", socketPath, " due to error: ", ErrorString(errno));
+        close(m_ListenFD);
+        m_ListenFD = -1;
+        return RTN_CONNECTION_FAIL;
+    }
+
+    m_SocketPath = socketPath;
+
+    m_EpollFD = epoll_create1(0);
+    if (0 > m_EpollFD)
+    {
+        return RTN_CONNECTION_FAIL;
+    }
+
+    epoll_event event = { 0 };
+    event.events = EPOLLIN;
+    event.data.fd = m_ListenFD;
+    if (0 > epoll_ctl(m_EpollFD, EPOLL_CTL_ADD, m_ListenFD, &event))
+    {
+        return RTN_CONNECTION_FAIL;
+    }
+
+    return RTN_OK;
+}
+
+RETCODE Server::Run(void)
+{
+    if (0 > m_EpollFD)
+    {
+        return RTN_CONNECTION_FAIL;
+    }
+
+    epoll_event events[MAX_EVENTS];
+    std::vector<PENDING_REQUEST> requests;
+
+    m_IsRunning.store(true);
+    while (m_IsRunning.load())
+    {
+        int numEvents = epoll_wait(m_EpollFD, events, MAX_EVENTS, POLL_INTERVAL_MS);
+        if (0 > numEvents)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            LOG_WARN("epoll_wait failed due to error: ", ErrorString(errno));
+            return RTN_FAIL;
+        }
+
+        requests.clear();
+        for (int event = 0; event < numEvents; event++)
+        {
+            int fd = events[event].data.fd;
+            if (m_ListenFD == fd)
+            {
+                AcceptClients();
+                continue;
+            }
+
+            std::unordered_map<int, std::unique_ptr<CLIENT>>::iterator client = m_Clients.find(fd);
+            if (m_Clients.end() == client)
+            {
+                continue;
+            }
+
+            if (events[event].events & EPOLLOUT)
+            {
+                FlushClient(*client->second);
+            }
+
+            // A client with too much output waiting is read again once it drained
+            if ((events[event].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && (client->second->events & EPOLLIN))
+            {
+                ReadClient(*client->second);
+                ParseRequests(*client->second, requests);
+            }
+        }
+
+        RunBatch(requests);
+
+        // Drop what was handled, keeping partial requests, and answer everyone in one go
+        std::vector<int> closing;
+        for (std::unordered_map<int, std::unique_ptr<CLIENT>>::value_type& entry : m_Clients)
+        {
+            CLIENT& client = *entry.second;
+            client.input.erase(client.input.begin(), client.input.begin() + client.consumed);
+            client.consumed = 0;
+            FlushClient(client);
+            if (client.isClosing && client.outputOffset == client.output.size())
+            {
+                closing.push_back(entry.first);
+            }
+        }
+
+        for (int fd : closing)
+        {
+            CloseClient(fd);
+        }
+    }
+
+    return RTN_OK;
+}
+
+void Server::Stop(void)
+{
+    m_IsRunning.store(false);
+}
+
+void Server::AcceptClients(void)
+{
+    for (;;)
+    {
+        int fd = accept(m_ListenFD, nullptr, nullptr);
+        if (0 > fd)
+        {
+            return;
+        }
+
+        if (!SetNonBlocking(fd))
+        {
+            close(fd);
+            continue;
+        }
+
+        epoll_event event = { 0 };
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (0 > epoll_ctl(m_EpollFD, EPOLL_CTL_ADD, fd, &event))
+        {
+            close(fd);
+            continue;
+        }
+
+        std::unique_ptr<CLIENT> client(new CLIENT());
+        client->fd = fd;
+        client->consumed = 0;
+        client->outputOffset = 0;
+        client->events = EPOLLIN;
+        client->isClosing = false;
+        m_Clients.emplace(fd, std::move(client));
+    }
+}
+
+void Server::ReadClient(CLIENT& client)
+{
+    while (client.input.size() - client.consumed < MAX_BUFFERED_INPUT)
+    {
+        size_t used = client.input.size();
+        client.input.resize(used + READ_CHUNK_SIZE);
+        ssize_t numRead = recv(client.fd, client.input.data() + used, READ_CHUNK_SIZE, 0);
+        client.input.resize(used + std::max<ssize_t>(numRead, 0));
+
+        if (0 == numRead)
+        {
+            client.isClosing = true;
+            return;
+        }
+
+        if (0 > numRead)
+        {
+            if (EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno)
+            {
+                client.isClosing = true;
+            }
+
+            if (EINTR != errno)
+            {
+                return;
+            }
+        }
+    }
+}
+
+void Server::ParseRequests(CLIENT& client, std::vector<PENDING_REQUEST>& out_requests)
+{
+    size_t offset = client.consumed;
+    while (client.input.size() - offset >= sizeof(qcDB::REQUEST_HEADER))
+    {
+        qcDB::REQUEST_HEADER header;
+        memcpy(&header, client.input.data() + offset, sizeof(header));
+        if (qcDB::MAX_PAYLOAD_SIZE < header.length)
+        {
+            LOG_WARN("Closing client sending a ", header.length, " byte request");
+            client.isClosing = true;
+            break;
+        }
+
+        if (client.input.size() - offset < sizeof(header) + header.length)
+        {
+            break;
+        }
+
+        out_requests.push_back(PENDING_REQUEST{ &client, offset });
+        offset += sizeof(header) + header.length;
+    }
+
+    client.consumed = offset;
+}
+
+void Server::RunBatch(const std::vector<PENDING_REQUEST>& requests)
+{
+    // Tables in the order their first request arrived, each locked once
+    std::vector<uint16_t> tables;
+    for (const PENDING_REQUEST& request : requests)
+    {
+        qcDB::REQUEST_HEADER header;
+        memcpy(&header, request.client->input.data() + request.offset, sizeof(header));
+        if (static_cast<uint16_t>(qcDB::OPCODE::OPEN) == header.opcode || header.table >= m_Tables.size())
+        {
+            RunRequest(request);
+        }
+        else if (tables.end() == std::find(tables.begin(), tables.end(), header.table))
+        {
+            tables.push_back(header.table);
+        }
+    }
+
+    for (uint16_t table : tables)
+    {
+        bool isRead = true;
+        for (const PENDING_REQUEST& request : requests)
+        {
+            qcDB::REQUEST_HEADER header;
+            memcpy(&header, request.client->input.data() + request.offset, sizeof(header));
+            if (table == header.table && !IsReadRequest(header.opcode))
+            {
+                isRead = false;
+                break;
+            }
+        }
+
+        RETCODE retcode = m_Tables[table]->Lock(isRead);
+        for (const PENDING_REQUEST& request : requests)
+        {
+            qcDB::REQUEST_HEADER header;
+            memcpy(&header, request.client->input.data() + request.offset, sizeof(header));
+            if (table != header.table || static_cast<uint16_t>(qcDB::OPCODE::OPEN) == header.opcode)
+            {
+                continue;
+            }
+
+            if (RTN_OK == retcode)
+            {
+                RunRequest(request);
+            }
+            else
+            {
+                Respond(*request.client, header, retcode, 0, nullptr, 0);
+            }
+        }
+
+        if (RTN_OK == retcode)
+        {
+            m_Tables[table]->Unlock(isRead);
+        }
+    }
+
+}
+
+void Server::RunRequest(const PENDING_REQUEST& request)
+{
+    CLIENT& client = *request.client;
+    qcDB::REQUEST_HEADER header;
+    memcpy(&header, client.input.data() + request.offset, sizeof(header));
+    const char* payload = client.input.data() + request.offset + sizeof(header);
+
+    if (static_cast<uint16_t>(qcDB::OPCODE::OPEN) == header.opcode)
+    {
+        std::string objectName(payload, header.length);
+        for (size_t table = 0; table < m_Tables.size(); table++)
+        {
+            if (m_Tables[table]->ObjectName() == objectName)
+            {
+                qcDB::TABLE_INFO info = m_Tables[table]->Info(table);
+                Respond(client, header, RTN_OK, 0, reinterpret_cast<const char*>(&info), sizeof(info));
+                return;
+            }
+        }
+
+        Respond(client, header, RTN_NOT_FOUND, 0, nullptr, 0);
+        return;
+    }
+
+    if (header.table >= m_Tables.size())
+    {
+        Respond(client, header, RTN_NOT_FOUND, 0, nullptr, 0);
+        return;
+    }
+
+    ServedTable& table = *m_Tables[header.table];
+    bool hasRecord = header.length == table.RecordSize();
+    RETCODE retcode = RTN_OK;
+    uint64_t version = 0;
+
+    switch (static_cast<qcDB::OPCODE>(header.opcode))
+    {
+        case qcDB::OPCODE::READ:
+        {
+            retcode = table.Read(header.record, m_RecordBuffer.data(), version);
+            Respond(client, header, retcode, version, m_RecordBuffer.data(), RTN_OK == retcode ? table.RecordSize() : 0);
+            return;
+        }
+        case qcDB::OPCODE::WRITE:
+        {
+            retcode = hasRecord ? table.Write(header.record, payload, version) : RTN_BAD_ARG;
+            break;
+        }
+        case qcDB::OPCODE::COMPARE_AND_WRITE:
+        {
+            retcode = hasRecord ? table.CompareAndWrite(header.record, header.version, payload, version) : RTN_BAD_ARG;
+            break;
+        }
+        case qcDB::OPCODE::DELETE_RECORD:
+        {
+            retcode = table.Delete(header.record, version);
+            break;
+        }
+        case qcDB::OPCODE::INFO:
+        {
+            qcDB::TABLE_INFO info = table.Info(header.table);
+            Respond(client, header, RTN_OK, 0, reinterpret_cast<const char*>(&info), sizeof(info));
+            return;
+        }
+        default:
+        {
+            retcode = RTN_BAD_ARG;
+            break;
+        }
+    }
+
+    Respond(client, header, retcode, version, nullptr, 0);
+}
+
+void Server::Respond(CLIENT& client, const qcDB::REQUEST_HEADER& request, RETCODE retcode, uint64_t version, const char* payload, size_t length)
+{
+    qcDB::RESPONSE_HEADER response = { 0 };
+    response.length = static_cast<uint32_t>(length);
+    response.requestID = request.requestID;
+    response.retcode = retcode;
+    response.version = version;
+
+    const char* responseBytes = reinterpret_cast<const char*>(&response);
+    client.output.insert(client.output.end(), responseBytes, responseBytes + sizeof(response));
+    if (length)
+    {
+        client.output.insert(client.output.end(), payload, payload + length);
+    }
+}
+
+void Server::FlushClient(CLIENT& client)
+{
+    while (client.outputOffset < client.output.size())
+    {
+        ssize_t numSent = send(client.fd, client.output.data() + client.outputOffset,
+            client.output.size() - client.outputOffset, MSG_NOSIGNAL);
+        if (0 > numSent)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            if (EAGAIN != errno && EWOULDBLOCK != errno)
+            {
+                client.isClosing = true;
+                client.output.clear();
+                client.outputOffset = 0;
+                return;
+            }
+
+            break;
+        }
+
+        client.outputOffset += numSent;
+    }
+
+    if (client.outputOffset == client.output.size())
+    {
+        client.output.clear();
+        client.outputOffset = 0;
+    }
+
+    UpdateEvents(client);
+}
+
+/*
+ * Only wait for the socket to drain while there is something left to send,
+ * and only take requests while the client keeps up with the responses.
+ */
+void Server::UpdateEvents(CLIENT& client)
+{
+    size_t pending = client.output.size() - client.outputOffset;
+    uint32_t events = (MAX_PENDING_OUTPUT > pending ? EPOLLIN : 0) | (0 < pending ? EPOLLOUT : 0);
+    if (events == client.events)
+    {
+        return;
+    }
+
+    client.events = events;
+    epoll_event event = { 0 };
+    event.events = events;
+    event.data.fd = client.fd;
+    epoll_ctl(m_EpollFD, EPOLL_CTL_MOD, client.fd, &event);
+}
+
+void Server::CloseClient(int fd)
+{
+    epoll_ctl(m_EpollFD, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_Clients.erase(fd);
+}
+
+bool Server::IsReadRequest(uint16_t opcode)
+{
+    return static_cast<uint16_t>(qcDB::OPCODE::READ) == opcode ||
+        static_cast<uint16_t>(qcDB::OPCODE::INFO) == opcode;
+}
@@ -0,0 +1,179 @@
+#include <dbServer/inc/Table.hh>
+
+#include <common/Logger.hh>
+#include <common/UtilityFunctions.hh>
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+ServedTable::ServedTable(void) :
+    m_DBAddress(nullptr), m_Size(0), m_Header(nullptr)
+{
+}
+
+ServedTable::~ServedTable(void)
+{
+    if (nullptr != m_DBAddress)
+    {
+        munmap(m_DBAddress, m_Size);
+    }
+}
+
+RETCODE ServedTable::Open(const std::string& dbPath)
+{
+    int fd = open(dbPath.c_str(), O_RDWR);
+    if (0 > fd)
+    {
+        LOG_WARN("Could not open ", dbPath, " due to error: ", ErrorString(errno));
+        return RTN_NOT_FOUND;
+    }
+
+    struct stat statbuf;
+    if (0 > fstat(fd, &statbuf))
+    {
+        close(fd);
+        return RTN_NOT_FOUND;
+    }
+
+    m_Size = statbuf.st_size;
+    void* address = mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == address)
+    {
+        LOG_WARN("Could not map ", dbPath, " due to error: ", ErrorString(errno));
+        return RTN_MALLOC_FAIL;
+    }
+
+    m_DBAddress = static_cast<char*>(address);
+    m_Header = reinterpret_cast<DBHeader*>(m_DBAddress);
+    if (sizeof(DBHeader) > m_Size || 0 == m_Header->m_RecordSize ||
+        m_Size < DatabaseFileSize(*m_Header))
+    {
+        LOG_WARN(dbPath, " is not a database generated by this version of dbGenerator");
+        munmap(m_DBAddress, m_Size);
+        m_DBAddress = nullptr;
+        return RTN_BAD_ARG;
+    }
+
+    m_Store.Attach(m_DBAddress);
+
+    // Statistics are best effort, the table works without them
+    m_Statistics.Attach(dbPath, true);
+
+    return RTN_OK;
+}
+
+RETCODE ServedTable::Lock(bool isRead)
+{
+    RETCODE retcode = m_Lock.Lock(m_Header, isRead);
+    if (RTN_OK == retcode)
+    {
+        m_Statistics.Count(qcDB::STATISTIC::LOCK_ACQUISITIONS);
+    }
+
+    return retcode;
+}
+
+RETCODE ServedTable::Unlock(bool isRead)
+{
+    return m_Lock.Unlock(m_Header, isRead);
+}
+
+RETCODE ServedTable::Read(uint64_t record, char* out_record, uint64_t& out_version)
+{
+    const char* p_record = Get(record);
+    if (nullptr == p_record)
+    {
+        return m_Statistics.Failure(RTN_NULL_OBJ);
+    }
+
+    // The version before the record, a write racing the copy then makes CompareAndWrite conflict
+    out_version = __atomic_load_n(&m_Store.Versions()[record], __ATOMIC_ACQUIRE);
+    memcpy(out_record, p_record, RecordSize());
+
+    m_Statistics.Count(qcDB::STATISTIC::READS);
+    m_Statistics.Count(qcDB::STATISTIC::BYTES_COPIED, RecordSize());
+
+    return RTN_OK;
+}
+
+RETCODE ServedTable::Write(uint64_t record, const char* recordData, uint64_t& out_version)
+{
+    char* p_record = Get(record);
+    if (nullptr == p_record)
+    {
+        return m_Statistics.Failure(RTN_NULL_OBJ);
+    }
+
+    out_version = m_Store.WriteRecord(p_record, record, recordData);
+
+    // Records are plain bytes here, the Bloom filters are left to RebuildBloomFilters
+    if (m_Header->m_BloomFields)
+    {
+        m_Header->m_BloomStale = 1;
+    }
+
+    m_Statistics.Count(qcDB::STATISTIC::WRITES);
+    m_Statistics.Count(qcDB::STATISTIC::BYTES_COPIED, RecordSize());
+
+    return RTN_OK;
+}
+
+RETCODE ServedTable::CompareAndWrite(uint64_t record, uint64_t expectedVersion, const char* recordData, uint64_t& out_version)
+{
+    if (nullptr == Get(record))
+    {
+        return m_Statistics.Failure(RTN_NULL_OBJ);
+    }
+
+    out_version = __atomic_load_n(&m_Store.Versions()[record], __ATOMIC_ACQUIRE);
+    if (expectedVersion != out_version)
+    {
+        return m_Statistics.Failure(RTN_CONFLICT);
+    }
+
+    return Write(record, recordData, out_version);
+}
+
+RETCODE ServedTable::Delete(uint64_t record, uint64_t& out_version)
+{
+    char* p_record = Get(record);
+    if (nullptr == p_record)
+    {
+        return m_Statistics.Failure(RTN_NULL_OBJ);
+    }
+
+    out_version = m_Store.DeleteRecord(p_record, record);
+
+    m_Statistics.Count(qcDB::STATISTIC::DELETES);
+
+    return RTN_OK;
+}
+
+qcDB::TABLE_INFO ServedTable::Info(size_t table) const
+{
+    qcDB::TABLE_INFO info = { 0 };
+    info.table = table;
+    info.numRecords = m_Header->m_NumRecords;
+    info.recordSize = m_Header->m_RecordSize;
+    info.lastWritten = m_Header->m_LastWritten;
+    return info;
+}
+
+std::string ServedTable::ObjectName(void) const
+{
+    return std::string(m_Header->m_ObjectName, strnlen(m_Header->m_ObjectName, sizeof(m_Header->m_ObjectName)));
+}
+
+char* ServedTable::Get(uint64_t record)
+{
+    if (record >= m_Header->m_NumRecords)
+    {
+        return nullptr;
+    }
+
+    return m_DBAddress + sizeof(DBHeader) + RecordSize() * record;
+}
@@ -0,0 +1,64 @@
+#include <common/Retcode.hh>
+#include <common/Logger.hh>
+#include <common/CLI.hh>
+
+#include <dbServer/inc/Server.hh>
+
+#include <csignal>
+
+static Server* g_Server = nullptr;
+
+static void StopServer(int signal)
+{
+    if (g_Server)
+    {
+        g_Server->Stop();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    CLI_StringArgument socketArg("-s", "The path of the Unix domain socket to listen on", true);
+    CLI_StringListArgument dbPathsArg("-d", "The database files to serve", true);
+
+    Parser parser("dbServer", "Serve qcDB files to dbClient over a Unix domain socket");
+
+    parser
+        .AddArg(socketArg)
+        .AddArg(dbPathsArg);
+
+    RETCODE retcode = parser.ParseCommandLineArguments(argc, argv);
+    if (RTN_OK != retcode)
+    {
+        parser.Usage();
+        return retcode;
+    }
+
+    Server server;
+    for (size_t dbPath = 0; dbPath < dbPathsArg.NumValues(); dbPath++)
+    {
+        retcode = server.AddTable(dbPathsArg.GetValue(dbPath));
+        if (RTN_OK != retcode)
+        {
+            LOG_FATAL("Could not serve: ", dbPathsArg.GetValue(dbPath), " with error: ", retcode);
+            return retcode;
+        }
+    }
+
+    retcode = server.Listen(socketArg.GetValue());
+    if (RTN_OK != retcode)
+    {
+        LOG_FATAL("Could not listen on: ", socketArg.GetValue(), " with error: ", retcode);
+        return retcode;
+    }
+
+    g_Server = &server;
+    signal(SIGINT, StopServer);
+    signal(SIGTERM, StopServer);
+
+    LOG_INFO("Listening on ", socketArg.GetValue());
+    retcode = server.Run();
+    g_Server = nullptr;
+
+    return retcode;
+}
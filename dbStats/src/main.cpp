@@ -0,0 +1,204 @@
+#include <common/Retcode.hh>
+#include <common/Logger.hh>
+#include <common/CLI.hh>
+
+#include <qcDB/Statistics.hh>
+
+#include <chrono>
+#include <thread>
+#include <iomanip>
+
+static void PrintHeader(void)
+{
+    std::cout
+        << std::setw(10) << "PID"
+        << std::setw(12) << "reads/s"
+        << std::setw(12) << "writes/s"
+        << std::setw(12) << "deletes/s"
+        << std::setw(12) << "scans/s"
+        << std::setw(14) << "scanned/s"
+        << std::setw(10) << "MB/s"
+        << std::setw(12) << "locks/s"
+        << "  failures (RETCODE:count)"
+        << "\n";
+}
+
+static void PrintRates(const std::string& owner, const qcDB::DBStatsSlot& previous, const qcDB::DBStatsSlot& current, double seconds)
+{
+    uint64_t deltas[qcDB::NUM_STATISTICS];
+    for (size_t statistic = 0; statistic < qcDB::NUM_STATISTICS; statistic++)
+    {
+        deltas[statistic] = current.m_Counters[statistic] - previous.m_Counters[statistic];
+    }
+
+    std::cout
+        << std::fixed << std::setprecision(0)
+        << std::setw(10) << owner
+        << std::setw(12) << deltas[static_cast<size_t>(qcDB::STATISTIC::READS)] / seconds
+        << std::setw(12) << deltas[static_cast<size_t>(qcDB::STATISTIC::WRITES)] / seconds
+        << std::setw(12) << deltas[static_cast<size_t>(qcDB::STATISTIC::DELETES)] / seconds
+        << std::setw(12) << deltas[static_cast<size_t>(qcDB::STATISTIC::SCANS)] / seconds
+        << std::setw(14) << deltas[static_cast<size_t>(qcDB::STATISTIC::RECORDS_SCANNED)] / seconds
+        << std::setprecision(2)
+        << std::setw(10) << deltas[static_cast<size_t>(qcDB::STATISTIC::BYTES_COPIED)] / seconds / (1024 * 1024)
+        << std::setprecision(0)
+        << std::setw(12) << deltas[static_cast<size_t>(qcDB::STATISTIC::LOCK_ACQUISITIONS)] / seconds
+        << " ";
+
+    for (size_t failure = 0; failure < qcDB::NUM_RETCODES; failure++)
+    {
+        uint64_t delta = current.m_Failures[failure] - previous.m_Failures[failure];
+        if (delta)
+        {
+            std::cout << " 0x" << std::hex << std::setw(4) << std::setfill('0') << (1u << failure)
+                << std::dec << std::setfill(' ') << ":" << delta;
+        }
+    }
+
+    std::cout << "\n";
+}
+
+static void PrintLockHistograms(const char* title, const qcDB::LockHistogram* histograms)
+{
+    std::cout
+        << title << " (ns)\n"
+        << std::setw(14) << "operation"
+        << std::setw(12) << "count"
+        << std::setw(12) << "mean"
+        << std::setw(12) << "p50"
+        << std::setw(12) << "p90"
+        << std::setw(12) << "p99"
+        << std::setw(12) << "p999"
+        << std::setw(14) << "max"
+        << "\n";
+
+    for (size_t operation = 0; operation < qcDB::NUM_DB_OPERATIONS; operation++)
+    {
+        const qcDB::LockHistogram& histogram = histograms[operation];
+        if (0 == histogram.m_TotalCount)
+        {
+            continue;
+        }
+
+        std::cout
+            << std::fixed << std::setprecision(0)
+            << std::setw(14) << qcDB::OperationName(operation)
+            << std::setw(12) << histogram.m_TotalCount
+            << std::setw(12) << histogram.Mean()
+            << std::setw(12) << histogram.Percentile(50.0)
+            << std::setw(12) << histogram.Percentile(90.0)
+            << std::setw(12) << histogram.Percentile(99.0)
+            << std::setw(12) << histogram.Percentile(99.9)
+            << std::setw(14) << histogram.m_Max
+            << "\n";
+    }
+
+    std::cout << std::endl;
+}
+
+static void AddSlot(qcDB::DBStatsSlot& total, const qcDB::DBStatsSlot& slot)
+{
+    for (size_t statistic = 0; statistic < qcDB::NUM_STATISTICS; statistic++)
+    {
+        total.m_Counters[statistic] += slot.m_Counters[statistic];
+    }
+
+    for (size_t failure = 0; failure < qcDB::NUM_RETCODES; failure++)
+    {
+        total.m_Failures[failure] += slot.m_Failures[failure];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    CLI_StringArgument dbPathArg("-d", "The path to the database file", true);
+    CLI_IntArgument intervalArg("-i", "Seconds between samples (default 1)");
+    CLI_IntArgument countArg("-c", "Number of samples to print (default forever)");
+    CLI_FlagArgument lockArg("-l", "Print lock wait and hold time histograms (needs QCDB_LOCK_TIMING) and exit");
+
+    Parser parser("dbStats", "Print operation rates of every process using a qcDB file");
+
+    parser
+        .AddArg(dbPathArg)
+        .AddArg(intervalArg)
+        .AddArg(countArg)
+        .AddArg(lockArg);
+
+    RETCODE retcode = parser.ParseCommandLineArguments(argc, argv);
+    if (RTN_OK != retcode)
+    {
+        parser.Usage();
+        return retcode;
+    }
+
+    int interval = intervalArg.IsInUse() ? intervalArg.GetValue() : 1;
+    int count = countArg.IsInUse() ? countArg.GetValue() : 0;
+    if (0 >= interval)
+    {
+        parser.Usage();
+        return RTN_BAD_ARG;
+    }
+
+    qcDB::dbStatistics statistics;
+    retcode = statistics.Attach(dbPathArg.GetValue(), false);
+    if (RTN_OK != retcode)
+    {
+        LOG_FATAL("Could not attach to statistics of: ", dbPathArg.GetValue(), " with error: ", retcode);
+        return retcode;
+    }
+
+    const qcDB::DBStats* stats = statistics.Stats();
+    if (lockArg.IsInUse())
+    {
+        PrintLockHistograms("Lock wait", stats->m_LockWait);
+        PrintLockHistograms("Lock hold", stats->m_LockHold);
+        return RTN_OK;
+    }
+
+    qcDB::DBStats previous = *stats;
+    std::chrono::steady_clock::time_point previousTime = std::chrono::steady_clock::now();
+
+    for (int sample = 0; 0 == count || sample < count; sample++)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(interval));
+
+        qcDB::DBStats current = *stats;
+        std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(currentTime - previousTime).count();
+
+        PrintHeader();
+
+        qcDB::DBStatsSlot total = { 0 };
+        qcDB::DBStatsSlot totalPrevious = { 0 };
+        for (size_t slot = 0; slot < qcDB::NUM_STATS_SLOTS; slot++)
+        {
+            const qcDB::DBStatsSlot& currentSlot = current.m_Slots[slot];
+            const qcDB::DBStatsSlot& previousSlot = previous.m_Slots[slot];
+            if (0 == currentSlot.m_ProcessID)
+            {
+                continue;
+            }
+
+            // A new owner took the slot, its counters started from 0
+            qcDB::DBStatsSlot empty = { 0 };
+            const qcDB::DBStatsSlot& baseline = currentSlot.m_ProcessID == previousSlot.m_ProcessID ? previousSlot : empty;
+            PrintRates(std::to_string(currentSlot.m_ProcessID), baseline, currentSlot, seconds);
+
+            AddSlot(total, currentSlot);
+            AddSlot(totalPrevious, baseline);
+        }
+
+        // Counters of processes that exited and whose slot was reused
+        PrintRates("exited", previous.m_Retired, current.m_Retired, seconds);
+        AddSlot(total, current.m_Retired);
+        AddSlot(totalPrevious, previous.m_Retired);
+
+        PrintRates("total", totalPrevious, total, seconds);
+        std::cout << std::endl;
+
+        previous = current;
+        previousTime = currentTime;
+    }
+
+    return RTN_OK;
+}
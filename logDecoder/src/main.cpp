@@ -0,0 +1,190 @@
+#include <common/Retcode.hh>
+#include <common/Logger.hh>
+#include <common/CLI.hh>
+#include <common/LogEncoding.hh>
+
+#include <fstream>
+#include <vector>
+#include <string>
+
+/*
+ * Call site definitions seen so far, indexed by site id.
+ */
+struct DECODED_SITE
+{
+    bool isDefined;
+    Logger::LogLevel level;
+    int lineNum;
+    std::string debugLevel;
+    std::string fileName;
+    uint64_t literals;
+    std::vector<std::string> literalTexts;
+    std::vector<const char*> texts;
+};
+
+template <typename T>
+static bool ReadRecord(std::istream& input, T& record)
+{
+    return static_cast<bool>(input.read(reinterpret_cast<char*>(&record), sizeof(record)));
+}
+
+static bool ReadString(std::istream& input, uint32_t length, std::string& out_string)
+{
+    out_string.resize(length);
+    return 0 == length || static_cast<bool>(input.read(&out_string[0], length));
+}
+
+static RETCODE DecodeLog(std::istream& input, std::ostream& output)
+{
+    LogEncoding::BINARY_LOG_HEADER header = { 0 };
+    if (!ReadRecord(input, header) || 0 != memcmp(header.magic, LogEncoding::BINARY_LOG_MAGIC, sizeof(header.magic)))
+    {
+        LOG_WARN("Not a binary log file");
+        return RTN_BAD_ARG;
+    }
+
+    if (LogEncoding::BINARY_LOG_VERSION != header.version)
+    {
+        LOG_WARN("Unsupported binary log version: ", header.version);
+        return RTN_BAD_ARG;
+    }
+
+    std::vector<DECODED_SITE> sites;
+    std::vector<char> arguments;
+    uint32_t type = 0;
+
+    // Every record starts with its type
+    while (input.read(reinterpret_cast<char*>(&type), sizeof(type)))
+    {
+        input.seekg(-static_cast<std::streamoff>(sizeof(type)), std::ios::cur);
+
+        if (static_cast<uint32_t>(LogEncoding::BINARY_RECORD_TYPE::SITE) == type)
+        {
+            LogEncoding::BINARY_SITE_RECORD record = { 0 };
+            DECODED_SITE site;
+            if (!ReadRecord(input, record) ||
+                !ReadString(input, record.debugLevelLength, site.debugLevel) ||
+                !ReadString(input, record.fileNameLength, site.fileName))
+            {
+                LOG_WARN("Truncated site record");
+                return RTN_FAIL;
+            }
+
+            site.literals = record.literals;
+            site.literalTexts.resize(64);
+            for (size_t index = 0; index < 64; index++)
+            {
+                uint32_t length = 0;
+                if ((record.literals >> index) & 1 &&
+                    (!ReadRecord(input, length) || !ReadString(input, length, site.literalTexts[index])))
+                {
+                    LOG_WARN("Truncated site record");
+                    return RTN_FAIL;
+                }
+            }
+
+            site.isDefined = true;
+            site.level = static_cast<Logger::LogLevel>(record.level);
+            site.lineNum = record.lineNum;
+            if (record.siteID >= sites.size())
+            {
+                sites.resize(record.siteID + 1, DECODED_SITE{ false, Logger::INFO, 0, "", "", 0, {}, {} });
+            }
+
+            // The texts point into the stored copy
+            DECODED_SITE& storedSite = sites[record.siteID];
+            storedSite = site;
+            storedSite.texts.assign(64, nullptr);
+            for (size_t index = 0; index < 64; index++)
+            {
+                storedSite.texts[index] = storedSite.literalTexts[index].c_str();
+            }
+        }
+        else if (static_cast<uint32_t>(LogEncoding::BINARY_RECORD_TYPE::MESSAGE) == type)
+        {
+            LogEncoding::BINARY_MESSAGE_RECORD record = { 0 };
+            if (!ReadRecord(input, record))
+            {
+                LOG_WARN("Truncated message record");
+                return RTN_FAIL;
+            }
+
+            arguments.resize(record.argumentsSize);
+            if (record.argumentsSize && !input.read(arguments.data(), record.argumentsSize))
+            {
+                LOG_WARN("Truncated message arguments");
+                return RTN_FAIL;
+            }
+
+            if (record.siteID >= sites.size() || !sites[record.siteID].isDefined)
+            {
+                LOG_WARN("Message refers to unknown site: ", record.siteID);
+                return RTN_FAIL;
+            }
+
+            const DECODED_SITE& site = sites[record.siteID];
+            if (Logger::INFO != site.level)
+            {
+                std::chrono::system_clock::time_point systemTime{std::chrono::microseconds(record.timestamp)};
+                Logger::WriteDecoration(output, systemTime, site.debugLevel.c_str(), record.processID,
+                    record.threadID, site.fileName.c_str(), site.lineNum);
+            }
+
+            if (!LogEncoding::Decode(output, arguments.data(), arguments.data() + arguments.size(), site.literals, site.texts.data()))
+            {
+                LOG_WARN("Malformed arguments from: ", site.fileName, ":", site.lineNum);
+                return RTN_FAIL;
+            }
+
+            output << "\n";
+        }
+        else
+        {
+            LOG_WARN("Unknown record type: ", type);
+            return RTN_FAIL;
+        }
+    }
+
+    output.flush();
+    return RTN_OK;
+}
+
+int main(int argc, char* argv[])
+{
+    CLI_StringArgument logPathArg("-f", "The binary log written by Logger::StartBinary", true);
+    CLI_StringArgument outputPathArg("-o", "Write the text log to this file instead of stdout");
+
+    Parser parser("logDecoder", "Turn a binary qcDB log into text");
+
+    parser
+        .AddArg(logPathArg)
+        .AddArg(outputPathArg);
+
+    RETCODE retcode = parser.ParseCommandLineArguments(argc, argv);
+    if (RTN_OK != retcode)
+    {
+        parser.Usage();
+        return retcode;
+    }
+
+    std::ifstream input(logPathArg.GetValue(), std::ios::binary);
+    if (!input)
+    {
+        LOG_FATAL("Could not open: ", logPathArg.GetValue());
+        return RTN_NOT_FOUND;
+    }
+
+    if (outputPathArg.IsInUse())
+    {
+        std::ofstream output(outputPathArg.GetValue());
+        if (!output)
+        {
+            LOG_FATAL("Could not open: ", outputPathArg.GetValue());
+            return RTN_NOT_FOUND;
+        }
+
+        return DecodeLog(input, output);
+    }
+
+    return DecodeLog(input, std::cout);
+}
@@ -0,0 +1,382 @@
+#ifndef __QC_DB_ASYNC_HH
+#define __QC_DB_ASYNC_HH
+
+#if !defined(__cpp_impl_coroutine)
+#error "qcDB/Async.hh needs C++20 coroutines, compile with -std=c++20"
+#endif
+
+#include <common/Retcode.hh>
+#include <qcDB/qcDB.hh>
+
+#include <coroutine>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+namespace qcDB
+{
+    /*
+     * Awaitable versions of the dbInterface calls for coroutine based code.
+     *
+     *     RETCODE retcode = co_await asyncDB.ReadObject(4, person);
+     *
+     * Awaiting an operation queues it for the executor thread of dbAsync and
+     * suspends the coroutine. The executor takes everything queued since it
+     * last woke up and runs the reads, writes and deletes under a single lock
+     * acquisition, a read lock if the batch only reads. Once the lock is
+     * released every coroutine of the batch is resumed, in the order they
+     * were queued, on the executor thread or through the resumer given to the
+     * constructor (for example one that posts the handle to an event loop).
+     *
+     * Arguments are referenced, not copied, they must live until the
+     * co_await completes which is always true for locals of the coroutine.
+     * Finds lock on their own and run between batches.
+     */
+    template <class object, class LockPolicy = ProcessSharedLock, class BoundsPolicy = BoundsChecked>
+    class dbAsync
+    {
+    public:
+
+        using DBType = dbInterface<object, LockPolicy, BoundsPolicy>;
+        using Predicate = typename DBType::Predicate;
+        using Resumer = std::function<void(std::coroutine_handle<>)>;
+
+        class Operation;
+
+        explicit dbAsync(DBType& db, Resumer resumer = nullptr) :
+            m_DB(db), m_Resumer(std::move(resumer)), m_IsStopping(false)
+        {
+            m_Executor = std::thread(&dbAsync::Execute, this);
+        }
+
+        /*
+         * Runs everything already queued before returning.
+         */
+        ~dbAsync(void)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_IsStopping = true;
+            }
+
+            m_Ready.notify_one();
+            m_Executor.join();
+        }
+
+        dbAsync(dbAsync const&) = delete;
+        void operator = (dbAsync const&) = delete;
+
+        Operation ReadObject(size_t record, object& out_object)
+        {
+            return Operation(this, OPERATION_TYPE::READ, record, &out_object);
+        }
+
+        Operation ReadObject(size_t record, object& out_object, RECORD_VERSION& out_version)
+        {
+            Operation operation(this, OPERATION_TYPE::READ, record, &out_object);
+            operation.m_Version = &out_version;
+            return operation;
+        }
+
+        Operation WriteObject(size_t record, const object& objectWrite)
+        {
+            Operation operation(this, OPERATION_TYPE::WRITE, record, nullptr);
+            operation.m_Image = &objectWrite;
+            return operation;
+        }
+
+        Operation CompareAndWrite(size_t record, RECORD_VERSION expectedVersion, const object& objectWrite)
+        {
+            Operation operation(this, OPERATION_TYPE::COMPARE_AND_WRITE, record, nullptr);
+            operation.m_Image = &objectWrite;
+            operation.m_ExpectedVersion = expectedVersion;
+            return operation;
+        }
+
+        Operation DeleteObject(size_t record)
+        {
+            return Operation(this, OPERATION_TYPE::DELETE_RECORD, record, nullptr);
+        }
+
+        Operation FindFirstOf(Predicate predicate, size_t& out_Record)
+        {
+            Operation operation(this, OPERATION_TYPE::FIND_FIRST, 0, nullptr);
+            operation.m_Predicate = std::move(predicate);
+            operation.m_Record = &out_Record;
+            return operation;
+        }
+
+        Operation FindObjects(Predicate predicate, std::vector<object>& out_MatchingObjects)
+        {
+            Operation operation(this, OPERATION_TYPE::FIND, 0, nullptr);
+            operation.m_Predicate = std::move(predicate);
+            operation.m_Matches = &out_MatchingObjects;
+            return operation;
+        }
+
+    private:
+
+        enum class OPERATION_TYPE
+        {
+            READ,
+            WRITE,
+            COMPARE_AND_WRITE,
+            DELETE_RECORD,
+            FIND_FIRST,
+            FIND
+        };
+
+    public:
+
+        /*
+         * The awaitable returned by every call, co_await gives its RETCODE.
+         * It lives in the awaiting coroutine's frame while it is queued.
+         */
+        class Operation
+        {
+        public:
+
+            bool await_ready(void) const noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                m_Handle = handle;
+                m_Async->Submit(this);
+            }
+
+            RETCODE await_resume(void) const noexcept
+            {
+                return m_Retcode;
+            }
+
+        private:
+
+            friend class dbAsync;
+
+            Operation(dbAsync* async, OPERATION_TYPE type, size_t record, object* p_object) :
+                m_Async(async), m_Type(type), m_Record(nullptr), m_Object(p_object), m_Image(nullptr), m_Version(nullptr),
+                m_Matches(nullptr), m_RecordNumber(record), m_ExpectedVersion(0), m_Retcode(RTN_OK)
+            {
+            }
+
+            dbAsync* m_Async;
+            OPERATION_TYPE m_Type;
+            size_t* m_Record;
+            object* m_Object;
+            const object* m_Image;
+            RECORD_VERSION* m_Version;
+            std::vector<object>* m_Matches;
+            Predicate m_Predicate;
+            size_t m_RecordNumber;
+            RECORD_VERSION m_ExpectedVersion;
+            RETCODE m_Retcode;
+            std::coroutine_handle<> m_Handle;
+        };
+
+    private:
+
+        void Submit(Operation* operation)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Queue.push_back(operation);
+            }
+
+            m_Ready.notify_one();
+        }
+
+        void Execute(void)
+        {
+            std::vector<Operation*> batch;
+            std::vector<std::coroutine_handle<>> handles;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_Mutex);
+                    m_Ready.wait(lock, [this] { return m_IsStopping || !m_Queue.empty(); });
+                    if (m_Queue.empty())
+                    {
+                        return;
+                    }
+
+                    batch.swap(m_Queue);
+                }
+
+                // Runs of record operations share a lock, finds lock themselves
+                size_t first = 0;
+                while (first < batch.size())
+                {
+                    size_t last = first;
+                    while (last < batch.size() && !IsFind(batch[last]->m_Type))
+                    {
+                        last++;
+                    }
+
+                    if (first == last)
+                    {
+                        RunFind(*batch[first]);
+                        first++;
+                        continue;
+                    }
+
+                    RunRecordOperations(batch, first, last);
+                    first = last;
+                }
+
+                // A resumed coroutine may free its operation, take the handles first
+                handles.clear();
+                for (Operation* operation : batch)
+                {
+                    handles.push_back(operation->m_Handle);
+                }
+
+                batch.clear();
+                for (std::coroutine_handle<> handle : handles)
+                {
+                    if (m_Resumer)
+                    {
+                        m_Resumer(handle);
+                    }
+                    else
+                    {
+                        handle.resume();
+                    }
+                }
+            }
+        }
+
+        void RunRecordOperations(std::vector<Operation*>& batch, size_t first, size_t last)
+        {
+            bool isRead = true;
+            for (size_t operation = first; operation < last; operation++)
+            {
+                isRead = isRead && OPERATION_TYPE::READ == batch[operation]->m_Type;
+            }
+
+            DB_OPERATION lockOperation = isRead ? DB_OPERATION::READ_BATCH : DB_OPERATION::WRITE_BATCH;
+            RETCODE retcode = m_DB.LockDB(lockOperation);
+            if (RTN_OK != retcode)
+            {
+                for (size_t operation = first; operation < last; operation++)
+                {
+                    batch[operation]->m_Retcode = m_DB.m_Statistics.Failure(retcode);
+                }
+
+                return;
+            }
+
+            size_t numReads = 0;
+            size_t numWrites = 0;
+            size_t numDeletes = 0;
+            for (size_t index = first; index < last; index++)
+            {
+                Operation& operation = *batch[index];
+                char* p_object = m_DB.Get(operation.m_RecordNumber);
+                if (nullptr == p_object)
+                {
+                    operation.m_Retcode = RTN_NULL_OBJ;
+                    continue;
+                }
+
+                switch (operation.m_Type)
+                {
+                    case OPERATION_TYPE::READ:
+                    {
+                        // The version before the record, as ReadObject does
+                        if (operation.m_Version)
+                        {
+                            *operation.m_Version = __atomic_load_n(&m_DB.m_Store.Versions()[operation.m_RecordNumber], __ATOMIC_ACQUIRE);
+                        }
+
+                        memcpy(operation.m_Object, p_object, sizeof(object));
+
+                        if (!m_DB.IsIntact(p_object, sizeof(object)))
+                        {
+                            operation.m_Retcode = RTN_CORRUPT;
+                            break;
+                        }
+
+                        numReads++;
+                        break;
+                    }
+                    case OPERATION_TYPE::COMPARE_AND_WRITE:
+                    {
+                        if (operation.m_ExpectedVersion != m_DB.m_Store.Versions()[operation.m_RecordNumber])
+                        {
+                            operation.m_Retcode = RTN_CONFLICT;
+                            break;
+                        }
+
+                        m_DB.WriteRecord(p_object, operation.m_RecordNumber, *operation.m_Image);
+                        numWrites++;
+                        break;
+                    }
+                    case OPERATION_TYPE::WRITE:
+                    {
+                        m_DB.WriteRecord(p_object, operation.m_RecordNumber, *operation.m_Image);
+                        numWrites++;
+                        break;
+                    }
+                    default:
+                    {
+                        m_DB.DeleteRecord(p_object, operation.m_RecordNumber);
+                        numDeletes++;
+                        break;
+                    }
+                }
+            }
+
+            retcode = m_DB.UnlockDB(lockOperation);
+            for (size_t index = first; index < last; index++)
+            {
+                Operation& operation = *batch[index];
+                if (RTN_OK != retcode && RTN_OK == operation.m_Retcode)
+                {
+                    operation.m_Retcode = retcode;
+                }
+
+                if (RTN_OK != operation.m_Retcode)
+                {
+                    m_DB.m_Statistics.Failure(operation.m_Retcode);
+                }
+            }
+
+            m_DB.m_Statistics.Count(STATISTIC::READS, numReads);
+            m_DB.m_Statistics.Count(STATISTIC::WRITES, numWrites);
+            m_DB.m_Statistics.Count(STATISTIC::DELETES, numDeletes);
+            m_DB.m_Statistics.Count(STATISTIC::BYTES_COPIED, (numReads + numWrites) * sizeof(object));
+        }
+
+        void RunFind(Operation& operation)
+        {
+            if (OPERATION_TYPE::FIND_FIRST == operation.m_Type)
+            {
+                operation.m_Retcode = m_DB.FindFirstOf(operation.m_Predicate, *operation.m_Record);
+            }
+            else
+            {
+                operation.m_Retcode = m_DB.FindObjects(operation.m_Predicate, *operation.m_Matches);
+            }
+        }
+
+        static bool IsFind(OPERATION_TYPE type)
+        {
+            return OPERATION_TYPE::FIND_FIRST == type || OPERATION_TYPE::FIND == type;
+        }
+
+        DBType& m_DB;
+        Resumer m_Resumer;
+        std::vector<Operation*> m_Queue;
+        std::mutex m_Mutex;
+        std::condition_variable m_Ready;
+        bool m_IsStopping;
+        std::thread m_Executor;
+    };
+}
+
+#endif
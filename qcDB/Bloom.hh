@@ -0,0 +1,82 @@
+#ifndef __QC_DB_BLOOM_HH
+#define __QC_DB_BLOOM_HH
+
+#include <common/DBHeader.hh>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Blocked Bloom filter: a value picks one cache line sized block and sets
+ * one bit in each of its words, so adding or checking a value touches a
+ * single cache line. Filters live in the database file, see DBHeader.hh.
+ */
+namespace qcDB
+{
+    constexpr size_t BLOOM_WORDS = sizeof(BLOOM_BLOCK) / sizeof(uint64_t);
+
+    // Odd constants picking the bit of each word from one hash
+    constexpr uint32_t BLOOM_SALTS[] =
+    {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+
+    static_assert(sizeof(BLOOM_SALTS) / sizeof(BLOOM_SALTS[0]) >= BLOOM_WORDS, "A salt is needed for every word of a block");
+
+    /*
+     * Field hashes of integers are the value itself, mix every bit in.
+     */
+    inline uint64_t BloomHash(size_t hash)
+    {
+        uint64_t mixed = hash;
+        mixed ^= mixed >> 33;
+        mixed *= 0xff51afd7ed558ccdULL;
+        mixed ^= mixed >> 33;
+        mixed *= 0xc4ceb9fe1a85ec53ULL;
+        mixed ^= mixed >> 33;
+        return mixed;
+    }
+
+    inline size_t BloomBlock(uint64_t mixed, size_t numBlocks)
+    {
+        return static_cast<size_t>(((mixed >> 32) * numBlocks) >> 32);
+    }
+
+    inline uint64_t BloomBit(uint64_t mixed, size_t word)
+    {
+        return 1ULL << ((static_cast<uint32_t>(mixed) * BLOOM_SALTS[word]) >> 26);
+    }
+
+    /*
+     * Atomic so writers that do not hold the table lock can add values.
+     */
+    inline void BloomAdd(BLOOM_BLOCK* filter, size_t numBlocks, size_t hash)
+    {
+        uint64_t mixed = BloomHash(hash);
+        BLOOM_BLOCK& block = filter[BloomBlock(mixed, numBlocks)];
+        for (size_t word = 0; word < BLOOM_WORDS; word++)
+        {
+            __atomic_fetch_or(&block.m_Words[word], BloomBit(mixed, word), __ATOMIC_RELAXED);
+        }
+    }
+
+    /*
+     * False if the value was never added, true if it may have been.
+     */
+    inline bool BloomMayContain(const BLOOM_BLOCK* filter, size_t numBlocks, size_t hash)
+    {
+        uint64_t mixed = BloomHash(hash);
+        const BLOOM_BLOCK& block = filter[BloomBlock(mixed, numBlocks)];
+        bool mayContain = true;
+        for (size_t word = 0; word < BLOOM_WORDS; word++)
+        {
+            uint64_t bit = BloomBit(mixed, word);
+            mayContain = mayContain && bit == (__atomic_load_n(&block.m_Words[word], __ATOMIC_RELAXED) & bit);
+        }
+
+        return mayContain;
+    }
+}
+
+#endif
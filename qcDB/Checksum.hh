@@ -0,0 +1,217 @@
+#ifndef __QC_DB_CHECKSUM_HH
+#define __QC_DB_CHECKSUM_HH
+
+#include <common/OSdefines.hh>
+#include <common/DBHeader.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define QCDB_CRC32_INSTRUCTION
+#include <nmmintrin.h>
+#ifdef WINDOWS_PLATFORM
+#include <intrin.h>
+#endif
+#endif
+
+/*
+ * Block checksums are CRC32C started from zero instead of all ones, so a
+ * zeroed block, like every block of a freshly generated file, has a
+ * checksum of zero. Started from zero the CRC is linear in the data:
+ * changing bytes changes the checksum of their block by the CRC of old XOR
+ * new bytes moved to their place in the block. Writers update checksums
+ * from the bytes they change without reading the rest of the block.
+ *
+ * Uses the SSE4.2 crc32 instruction when the CPU has it.
+ */
+namespace qcDB
+{
+    // CRC32C polynomial with its bits reversed
+    constexpr uint32_t CRC32C_POLYNOMIAL = 0x82f63b78U;
+
+    /*
+     * Product of two polynomials modulo the CRC32C polynomial, bit 31 being
+     * the coefficient of x^0.
+     */
+    inline uint32_t Crc32cMultiply(uint32_t left, uint32_t right)
+    {
+        uint32_t product = 0;
+        for (uint32_t bit = 1U << 31; bit; bit >>= 1)
+        {
+            if (left & bit)
+            {
+                product ^= right;
+            }
+
+            right = (right & 1) ? (right >> 1) ^ CRC32C_POLYNOMIAL : right >> 1;
+        }
+
+        return product;
+    }
+
+    struct CRC32C_TABLES
+    {
+        CRC32C_TABLES(void)
+        {
+            for (uint32_t byte = 0; byte < 256; byte++)
+            {
+                uint32_t crc = byte;
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+                }
+
+                m_Bytes[byte] = crc;
+            }
+
+            // x^(8 * n), appending n zero bytes multiplies a CRC by it
+            m_Zeroes[0] = 1U << 31;
+            for (size_t numBytes = 1; numBytes <= CHECKSUM_BLOCK_SIZE; numBytes++)
+            {
+                m_Zeroes[numBytes] = Crc32cMultiply(m_Zeroes[numBytes - 1], 1U << 23);
+            }
+        }
+
+        uint32_t m_Bytes[256];
+        uint32_t m_Zeroes[CHECKSUM_BLOCK_SIZE + 1];
+    };
+
+    inline const CRC32C_TABLES& Crc32cTables(void)
+    {
+        static const CRC32C_TABLES tables;
+        return tables;
+    }
+
+    inline bool HasCrc32Instruction(void)
+    {
+#if !defined(QCDB_CRC32_INSTRUCTION)
+        return false;
+#elif defined(WINDOWS_PLATFORM)
+        int info[4];
+        __cpuid(info, 1);
+        return 0 != (info[2] & (1 << 20));
+#else
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+
+#ifdef QCDB_CRC32_INSTRUCTION
+#ifndef WINDOWS_PLATFORM
+    __attribute__((target("sse4.2")))
+#endif
+    inline uint32_t Crc32cInstruction(uint32_t crc, const unsigned char* data, size_t length)
+    {
+        uint64_t wideCrc = crc;
+        for (; 8 <= length; length -= 8, data += 8)
+        {
+            uint64_t word;
+            memcpy(&word, data, sizeof(word));
+            wideCrc = _mm_crc32_u64(wideCrc, word);
+        }
+
+        crc = static_cast<uint32_t>(wideCrc);
+        for (; length; length--, data++)
+        {
+            crc = _mm_crc32_u8(crc, *data);
+        }
+
+        return crc;
+    }
+#endif
+
+    /*
+     * Continue a CRC32C over more data, without the usual final inversion.
+     */
+    inline uint32_t Crc32c(uint32_t crc, const void* data, size_t length)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+#ifdef QCDB_CRC32_INSTRUCTION
+        static const bool isInstruction = HasCrc32Instruction();
+        if (isInstruction)
+        {
+            return Crc32cInstruction(crc, bytes, length);
+        }
+#endif
+
+        const CRC32C_TABLES& tables = Crc32cTables();
+        for (; length; length--, bytes++)
+        {
+            crc = (crc >> 8) ^ tables.m_Bytes[(crc ^ *bytes) & 0xff];
+        }
+
+        return crc;
+    }
+
+    /*
+     * The CRC of data followed by numBytes zero bytes, numBytes up to a block.
+     */
+    inline uint32_t Crc32cAppendZeroes(uint32_t crc, size_t numBytes)
+    {
+        return Crc32cMultiply(Crc32cTables().m_Zeroes[numBytes], crc);
+    }
+
+    /*
+     * CRC of old XOR new bytes, a null p_new stands for zeroes.
+     */
+    inline uint32_t Crc32cDelta(const unsigned char* p_old, const unsigned char* p_new, size_t length)
+    {
+        unsigned char delta[256];
+        uint32_t crc = 0;
+        while (length)
+        {
+            size_t chunk = std::min(length, sizeof(delta));
+            for (size_t byte = 0; byte < chunk; byte++)
+            {
+                delta[byte] = p_old[byte] ^ (p_new ? p_new[byte] : 0);
+            }
+
+            crc = Crc32c(crc, delta, chunk);
+            p_old += chunk;
+            p_new = p_new ? p_new + chunk : nullptr;
+            length -= chunk;
+        }
+
+        return crc;
+    }
+
+    /*
+     * Checksum of a whole block of the records, the last one may be short.
+     */
+    inline BLOCK_CHECKSUM BlockChecksum(const char* records, size_t recordsLength, size_t block)
+    {
+        size_t first = block * CHECKSUM_BLOCK_SIZE;
+        return Crc32c(0, records + first, std::min(CHECKSUM_BLOCK_SIZE, recordsLength - first));
+    }
+
+    /*
+     * Update the checksums of the blocks holding [offset, offset + length)
+     * of the records for bytes changing from p_old to p_new, a null p_new
+     * for zeroes. Call before the bytes are written, p_old may be the bytes
+     * in place. The table must be locked for writing.
+     */
+    inline void UpdateBlockChecksums(BLOCK_CHECKSUM* checksums, size_t recordsLength, size_t offset,
+        const void* p_old, const void* p_new, size_t length)
+    {
+        const unsigned char* oldBytes = static_cast<const unsigned char*>(p_old);
+        const unsigned char* newBytes = static_cast<const unsigned char*>(p_new);
+        while (length)
+        {
+            size_t block = offset / CHECKSUM_BLOCK_SIZE;
+            size_t blockEnd = std::min((block + 1) * CHECKSUM_BLOCK_SIZE, recordsLength);
+            size_t partLength = std::min(length, blockEnd - offset);
+
+            uint32_t delta = Crc32cDelta(oldBytes, newBytes, partLength);
+            checksums[block] ^= Crc32cAppendZeroes(delta, blockEnd - offset - partLength);
+
+            offset += partLength;
+            oldBytes += partLength;
+            newBytes = newBytes ? newBytes + partLength : nullptr;
+            length -= partLength;
+        }
+    }
+}
+
+#endif
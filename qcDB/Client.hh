@@ -0,0 +1,327 @@
+#ifndef __QC_DB_CLIENT_HH
+#define __QC_DB_CLIENT_HH
+
+#include <common/Retcode.hh>
+#include <common/DBHeader.hh>
+#include <qcDB/Protocol.hh>
+#include <qcDB/Reflection.hh>
+
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <tuple>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace qcDB
+{
+    /*
+     * Access to a table served by dbServer. Mirrors the dbInterface calls
+     * but every call is a request over the socket instead of a memcpy on a
+     * mapping, so it suits processes that should not map the file.
+     *
+     * ReadObjects and WriteObjects pipeline their requests: up to
+     * MAX_PIPELINED_BYTES of them are sent before their responses are read,
+     * and the server runs everything that arrived together in one lock
+     * section. Bigger batches take a round trip per window, since the server
+     * stops reading a client that does not take its responses.
+     *
+     * A dbClient must only be used by one thread at a time.
+     */
+    template <class object>
+    class dbClient
+    {
+    public:
+
+        /*
+         * Connect to the server and open the table of object, found by the
+         * object name of its generated header.
+         */
+        dbClient(const std::string& socketPath) :
+            m_IsOpen(false), m_FD(-1), m_Table(0), m_NumRecords(0), m_NextRequestID(0)
+        {
+            sockaddr_un address;
+            memset(&address, 0, sizeof(address));
+            if (socketPath.size() >= sizeof(address.sun_path))
+            {
+                return;
+            }
+
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+            m_FD = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (0 > m_FD)
+            {
+                return;
+            }
+
+            if (0 > connect(m_FD, reinterpret_cast<sockaddr*>(&address), sizeof(address)))
+            {
+                close(m_FD);
+                m_FD = -1;
+                return;
+            }
+
+            const char* objectName = Reflection<object>::OBJECT_NAME;
+            TABLE_INFO info;
+            RESPONSE_HEADER response;
+            if (RTN_OK != Send(OPCODE::OPEN, 0, 0, objectName, strlen(objectName)) ||
+                RTN_OK != Receive(response, &info, sizeof(info)) ||
+                RTN_OK != response.retcode ||
+                sizeof(object) != info.recordSize)
+            {
+                close(m_FD);
+                m_FD = -1;
+                return;
+            }
+
+            m_Table = static_cast<uint16_t>(info.table);
+            m_NumRecords = info.numRecords;
+            m_IsOpen = true;
+        }
+
+        ~dbClient(void)
+        {
+            if (0 <= m_FD)
+            {
+                close(m_FD);
+            }
+        }
+
+        dbClient(dbClient const&) = delete;
+        void operator = (dbClient const&) = delete;
+
+        bool IsOpen(void) const
+        {
+            return m_IsOpen;
+        }
+
+        size_t NumberOfRecords(void) const
+        {
+            return m_NumRecords;
+        }
+
+        RETCODE ReadObject(size_t record, object& out_object)
+        {
+            RECORD_VERSION version = 0;
+            return ReadObject(record, out_object, version);
+        }
+
+        /*
+         * Read object at given record along with its version, which can be
+         * passed to CompareAndWrite.
+         */
+        RETCODE ReadObject(size_t record, object& out_object, RECORD_VERSION& out_version)
+        {
+            RETCODE retcode = Send(OPCODE::READ, record, 0, nullptr, 0);
+            if (RTN_OK != retcode)
+            {
+                return retcode;
+            }
+
+            RESPONSE_HEADER response;
+            retcode = Receive(response, &out_object, sizeof(object));
+            out_version = response.version;
+            return RTN_OK == retcode ? response.retcode : retcode;
+        }
+
+        RETCODE WriteObject(size_t record, const object& objectWrite)
+        {
+            return Request(OPCODE::WRITE, record, 0, &objectWrite);
+        }
+
+        /*
+         * Write only if the record is still at expectedVersion, see
+         * dbInterface::CompareAndWrite. Returns RTN_CONFLICT otherwise.
+         */
+        RETCODE CompareAndWrite(size_t record, RECORD_VERSION expectedVersion, const object& objectWrite)
+        {
+            return Request(OPCODE::COMPARE_AND_WRITE, record, expectedVersion, &objectWrite);
+        }
+
+        RETCODE DeleteObject(size_t record)
+        {
+            return Request(OPCODE::DELETE_RECORD, record, 0, nullptr);
+        }
+
+        /*
+         * Read several objects given a vector of tuples <record, empty object>,
+         * pipelined. Returns the first failure.
+         */
+        RETCODE ReadObjects(std::vector<std::tuple<size_t, object>>& objects)
+        {
+            return Pipeline(objects, true);
+        }
+
+        /*
+         * Write several objects given a vector of tuples <record, object data>,
+         * pipelined. Returns the first failure. Unlike dbInterface the writes
+         * are not all or nothing, every valid record is written.
+         */
+        RETCODE WriteObjects(std::vector<std::tuple<size_t, object>>& objects)
+        {
+            return Pipeline(objects, false);
+        }
+
+    private:
+
+        RETCODE Request(OPCODE opcode, size_t record, RECORD_VERSION version, const object* p_object)
+        {
+            RETCODE retcode = Send(opcode, record, version, p_object, p_object ? sizeof(object) : 0);
+            if (RTN_OK != retcode)
+            {
+                return retcode;
+            }
+
+            RESPONSE_HEADER response;
+            retcode = Receive(response, nullptr, 0);
+            return RTN_OK == retcode ? response.retcode : retcode;
+        }
+
+        /*
+         * Send the requests for objects a window at a time and read the
+         * responses of a window before sending the next. Responses on one
+         * table come back in the order the requests were sent, so the nth
+         * response belongs to the nth object.
+         */
+        RETCODE Pipeline(std::vector<std::tuple<size_t, object>>& objects, bool isRead)
+        {
+            RETCODE firstFailure = RTN_OK;
+            size_t requestSize = sizeof(REQUEST_HEADER) + (isRead ? 0 : sizeof(object));
+            size_t responseSize = sizeof(RESPONSE_HEADER) + (isRead ? sizeof(object) : 0);
+            size_t windowSize = std::max<size_t>(MAX_PIPELINED_BYTES / std::max(requestSize, responseSize), 1);
+
+            for (size_t first = 0; first < objects.size(); first += windowSize)
+            {
+                size_t last = std::min(first + windowSize, objects.size());
+                for (size_t index = first; index < last; index++)
+                {
+                    std::tuple<size_t, object>& entry = objects[index];
+                    RETCODE retcode = isRead ?
+                        Send(OPCODE::READ, std::get<0>(entry), 0, nullptr, 0) :
+                        Send(OPCODE::WRITE, std::get<0>(entry), 0, &std::get<1>(entry), sizeof(object));
+                    if (RTN_OK != retcode)
+                    {
+                        return retcode;
+                    }
+                }
+
+                for (size_t index = first; index < last; index++)
+                {
+                    RESPONSE_HEADER response;
+                    RETCODE retcode = Receive(response, isRead ? &std::get<1>(objects[index]) : nullptr, isRead ? sizeof(object) : 0);
+                    if (RTN_OK != retcode)
+                    {
+                        return retcode;
+                    }
+
+                    if (RTN_OK == firstFailure)
+                    {
+                        firstFailure = response.retcode;
+                    }
+                }
+            }
+
+            return firstFailure;
+        }
+
+        RETCODE Send(OPCODE opcode, size_t record, RECORD_VERSION version, const void* payload, size_t length)
+        {
+            REQUEST_HEADER request;
+            memset(&request, 0, sizeof(request));
+            request.length = static_cast<uint32_t>(length);
+            request.requestID = m_NextRequestID++;
+            request.opcode = static_cast<uint16_t>(opcode);
+            request.table = m_Table;
+            request.record = record;
+            request.version = version;
+
+            RETCODE retcode = SendAll(&request, sizeof(request));
+            if (RTN_OK == retcode && length)
+            {
+                retcode = SendAll(payload, length);
+            }
+
+            return retcode;
+        }
+
+        /*
+         * Read one response. A payload is copied to out_payload only if it
+         * is exactly payloadSize bytes, anything else is skipped.
+         */
+        RETCODE Receive(RESPONSE_HEADER& out_response, void* out_payload, size_t payloadSize)
+        {
+            RETCODE retcode = ReceiveAll(&out_response, sizeof(out_response));
+            if (RTN_OK != retcode || 0 == out_response.length)
+            {
+                return retcode;
+            }
+
+            if (out_response.length == payloadSize)
+            {
+                return ReceiveAll(out_payload, payloadSize);
+            }
+
+            std::vector<char> skipped(out_response.length);
+            return ReceiveAll(skipped.data(), skipped.size());
+        }
+
+        RETCODE SendAll(const void* data, size_t length)
+        {
+            const char* cursor = static_cast<const char*>(data);
+            while (length)
+            {
+                ssize_t numSent = send(m_FD, cursor, length, MSG_NOSIGNAL);
+                if (0 > numSent && EINTR == errno)
+                {
+                    continue;
+                }
+
+                if (0 >= numSent)
+                {
+                    return RTN_CONNECTION_FAIL;
+                }
+
+                cursor += numSent;
+                length -= numSent;
+            }
+
+            return RTN_OK;
+        }
+
+        RETCODE ReceiveAll(void* out_data, size_t length)
+        {
+            char* cursor = static_cast<char*>(out_data);
+            while (length)
+            {
+                ssize_t numRead = recv(m_FD, cursor, length, 0);
+                if (0 > numRead && EINTR == errno)
+                {
+                    continue;
+                }
+
+                if (0 >= numRead)
+                {
+                    return RTN_CONNECTION_FAIL;
+                }
+
+                cursor += numRead;
+                length -= numRead;
+            }
+
+            return RTN_OK;
+        }
+
+        bool m_IsOpen;
+        int m_FD;
+        uint16_t m_Table;
+        size_t m_NumRecords;
+        uint32_t m_NextRequestID;
+    };
+}
+
+#endif
@@ -0,0 +1,738 @@
+#ifndef __QC_DB_COLD_READER_HH
+#define __QC_DB_COLD_READER_HH
+
+#include <common/Retcode.hh>
+#include <common/DBHeader.hh>
+#include <qcDB/qcDB.hh>
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <vector>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define QCDB_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+namespace qcDB
+{
+    // Reads a dbColdReader keeps in flight by default
+    constexpr size_t COLD_READ_QUEUE_DEPTH = 64;
+
+    struct COLD_READ_OPTIONS
+    {
+        // Reads in flight at a time
+        size_t queueDepth;
+        // Read with O_DIRECT through a pool of aligned buffers, past the page cache
+        bool isDirect;
+    };
+
+#ifdef QCDB_IO_URING
+    /*
+     * The little of io_uring dbColdReader needs, reads queued and reaped by
+     * one thread, set up with the raw system calls.
+     */
+    class IoRing
+    {
+    public:
+
+        IoRing(void) :
+            m_FD(-1), m_SqRing(nullptr), m_SqRingSize(0), m_CqRing(nullptr), m_CqRingSize(0),
+            m_Sqes(nullptr), m_SqesSize(0), m_NumQueued(0)
+        {
+        }
+
+        ~IoRing(void)
+        {
+            Close();
+        }
+
+        IoRing(IoRing const&) = delete;
+        void operator = (IoRing const&) = delete;
+
+        /*
+         * False if the kernel has no io_uring or does not allow it.
+         */
+        bool Open(unsigned numEntries)
+        {
+            io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            m_FD = static_cast<int>(syscall(__NR_io_uring_setup, numEntries, &params));
+            if (0 > m_FD)
+            {
+                return false;
+            }
+
+            m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+            {
+                m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+            }
+
+            m_SqRing = MapRing(m_SqRingSize, IORING_OFF_SQ_RING);
+            m_CqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? m_SqRing : MapRing(m_CqRingSize, IORING_OFF_CQ_RING);
+            m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            m_Sqes = static_cast<io_uring_sqe*>(MapRing(m_SqesSize, IORING_OFF_SQES));
+            if (nullptr == m_SqRing || nullptr == m_CqRing || nullptr == m_Sqes)
+            {
+                return false;
+            }
+
+            char* sq = static_cast<char*>(m_SqRing);
+            m_SqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            m_SqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            m_SqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            m_SqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            m_SqEntries = params.sq_entries;
+
+            char* cq = static_cast<char*>(m_CqRing);
+            m_CqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            m_CqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            m_CqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            m_Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            return true;
+        }
+
+        bool IsOpen(void) const
+        {
+            return nullptr != m_Sqes;
+        }
+
+        void Close(void)
+        {
+            if (nullptr != m_Sqes)
+            {
+                munmap(m_Sqes, m_SqesSize);
+            }
+
+            if (nullptr != m_CqRing && m_CqRing != m_SqRing)
+            {
+                munmap(m_CqRing, m_CqRingSize);
+            }
+
+            if (nullptr != m_SqRing)
+            {
+                munmap(m_SqRing, m_SqRingSize);
+            }
+
+            if (0 <= m_FD)
+            {
+                close(m_FD);
+            }
+
+            m_FD = -1;
+            m_SqRing = m_CqRing = nullptr;
+            m_Sqes = nullptr;
+            m_NumQueued = 0;
+        }
+
+        /*
+         * Queue a read to be submitted, false if the submission queue is full.
+         */
+        bool QueueRead(int fd, void* buffer, uint32_t length, uint64_t offset, uint64_t userData)
+        {
+            unsigned tail = *m_SqTail;
+            if (tail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE) >= m_SqEntries)
+            {
+                return false;
+            }
+
+            unsigned index = tail & m_SqMask;
+            io_uring_sqe& sqe = m_Sqes[index];
+            memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<uint64_t>(buffer);
+            sqe.len = length;
+            sqe.off = offset;
+            sqe.user_data = userData;
+            m_SqArray[index] = index;
+
+            __atomic_store_n(m_SqTail, tail + 1, __ATOMIC_RELEASE);
+            m_NumQueued++;
+            return true;
+        }
+
+        /*
+         * Submit the queued reads and wait until at least minComplete
+         * completions can be reaped.
+         */
+        bool Submit(unsigned minComplete)
+        {
+            for (;;)
+            {
+                int numSubmitted = static_cast<int>(syscall(__NR_io_uring_enter, m_FD, m_NumQueued, minComplete,
+                    minComplete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+                if (0 > numSubmitted && (EINTR == errno || EAGAIN == errno || EBUSY == errno))
+                {
+                    continue;
+                }
+
+                if (0 > numSubmitted)
+                {
+                    return false;
+                }
+
+                m_NumQueued -= numSubmitted;
+                return true;
+            }
+        }
+
+        /*
+         * Drop the queued reads that were not submitted and return how many.
+         */
+        unsigned DiscardQueued(void)
+        {
+            unsigned numDiscarded = m_NumQueued;
+            __atomic_store_n(m_SqTail, *m_SqTail - numDiscarded, __ATOMIC_RELEASE);
+            m_NumQueued = 0;
+            return numDiscarded;
+        }
+
+        /*
+         * Reap a completion, false if there is none.
+         */
+        bool Complete(uint64_t& out_userData, int32_t& out_result)
+        {
+            unsigned head = *m_CqHead;
+            if (head == __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE))
+            {
+                return false;
+            }
+
+            const io_uring_cqe& cqe = m_Cqes[head & m_CqMask];
+            out_userData = cqe.user_data;
+            out_result = cqe.res;
+            __atomic_store_n(m_CqHead, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+
+    private:
+
+        void* MapRing(size_t size, off_t offset)
+        {
+            void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_FD, offset);
+            return MAP_FAILED == address ? nullptr : address;
+        }
+
+        int m_FD;
+        void* m_SqRing;
+        size_t m_SqRingSize;
+        void* m_CqRing;
+        size_t m_CqRingSize;
+        io_uring_sqe* m_Sqes;
+        size_t m_SqesSize;
+        unsigned* m_SqHead;
+        unsigned* m_SqTail;
+        unsigned m_SqMask;
+        unsigned* m_SqArray;
+        unsigned m_SqEntries;
+        unsigned* m_CqHead;
+        unsigned* m_CqTail;
+        unsigned m_CqMask;
+        io_uring_cqe* m_Cqes;
+        unsigned m_NumQueued;
+    };
+#endif
+
+    /*
+     * Batch lookups for tables mostly not in memory.
+     *
+     * dbInterface::ReadObjects copies from the mapping, so every record not
+     * in the page cache is a page fault waited for before the next one is
+     * taken. ReadObjects here asks the kernel which records are resident,
+     * copies those from the mapping like dbInterface does and reads the rest
+     * from the file with queueDepth reads in flight, through io_uring where
+     * the kernel has it and parallel preads otherwise.
+     *
+     *     qcDB::dbColdReader<PERSON> coldPeople(people, "PERSON.qcdb");
+     *     coldPeople.ReadObjects(lookups);
+     *
+     * With isDirect the reads bypass the page cache so cold lookups do not
+     * evict hot records, falling back to cached reads on file systems
+     * without O_DIRECT. The read lock is held for the whole batch like
+     * dbInterface::ReadObjects. QCDB_VERIFY_CHECKSUMS only checks the
+     * records copied from the mapping.
+     *
+     * dbPath must name the file db maps, through any link, else the
+     * reader does not open. A dbColdReader must only be used by one thread
+     * at a time.
+     */
+    template <class object, class LockPolicy = ProcessSharedLock, class BoundsPolicy = BoundsChecked>
+    class dbColdReader
+    {
+    public:
+
+        using DBType = dbInterface<object, LockPolicy, BoundsPolicy>;
+
+        dbColdReader(DBType& db, const std::string& dbPath, const COLD_READ_OPTIONS& options = COLD_READ_OPTIONS{ COLD_READ_QUEUE_DEPTH, false }) :
+            m_DB(db), m_FD(-1), m_QueueDepth(std::max<size_t>(options.queueDepth, 1)), m_IsDirect(options.isDirect),
+            m_PageSize(sysconf(_SC_PAGESIZE)), m_BufferSize(0), m_Buffers(nullptr, &free), m_NumResidentReads(0), m_NumColdReads(0),
+            m_Objects(nullptr), m_ColdObjects(nullptr), m_NextCold(0), m_Batch(0), m_NumBusy(0), m_IsStopping(false)
+        {
+            m_FD = open(dbPath.c_str(), O_RDONLY | (m_IsDirect ? O_DIRECT : 0));
+            if (0 > m_FD && m_IsDirect)
+            {
+                m_IsDirect = false;
+                m_FD = open(dbPath.c_str(), O_RDONLY);
+            }
+
+            // Records read from another file than the one db maps would pass for its own
+            struct stat statbuf;
+            if (0 <= m_FD && (0 != fstat(m_FD, &statbuf) ||
+                !(m_DB.m_FileIdentity == FILE_IDENTITY{ static_cast<uint64_t>(statbuf.st_dev), static_cast<uint64_t>(statbuf.st_ino) })))
+            {
+                close(m_FD);
+                m_FD = -1;
+                return;
+            }
+
+            if (m_IsDirect)
+            {
+                // Enough whole pages for an object starting anywhere in the first one
+                m_BufferSize = (m_PageSize - 1 + sizeof(object) + m_PageSize - 1) / m_PageSize * m_PageSize;
+                void* buffers = nullptr;
+                if (0 != posix_memalign(&buffers, m_PageSize, m_BufferSize * m_QueueDepth))
+                {
+                    close(m_FD);
+                    m_FD = -1;
+                    return;
+                }
+
+                m_Buffers.reset(static_cast<char*>(buffers));
+            }
+
+#ifdef QCDB_IO_URING
+            m_Ring.Open(static_cast<unsigned>(m_QueueDepth));
+#endif
+        }
+
+        ~dbColdReader(void)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_IsStopping = true;
+            }
+
+            m_Ready.notify_all();
+            for (std::thread& reader : m_Readers)
+            {
+                reader.join();
+            }
+
+            if (0 <= m_FD)
+            {
+                close(m_FD);
+            }
+        }
+
+        dbColdReader(dbColdReader const&) = delete;
+        void operator = (dbColdReader const&) = delete;
+
+        bool IsOpen(void) const
+        {
+            return 0 <= m_FD;
+        }
+
+        /*
+         * Read several objects given a vector of tuples <record, empty object>,
+         * sorted by record like dbInterface::ReadObjects.
+         */
+        RETCODE ReadObjects(std::vector<std::tuple<size_t, object>>& objects)
+        {
+            RETCODE retcode = RTN_OK;
+            if (!IsOpen())
+            {
+                return m_DB.m_Statistics.Failure(RTN_NOT_FOUND);
+            }
+
+            std::sort(objects.begin(), objects.end(),
+                [](const std::tuple<size_t, object>& a, const std::tuple<size_t, object>& b) {
+                return std::get<0>(a) < std::get<0>(b);
+                });
+
+            for (const std::tuple<size_t, object>& readObject : objects)
+            {
+                if (m_DB.NumberOfRecords() <= std::get<0>(readObject))
+                {
+                    return m_DB.m_Statistics.Failure(RTN_NULL_OBJ);
+                }
+            }
+
+            retcode = m_DB.LockDB(DB_OPERATION::READ_BATCH);
+            if (RTN_OK != retcode)
+            {
+                return m_DB.m_Statistics.Failure(retcode);
+            }
+
+            bool isIntact = true;
+            std::vector<size_t> coldObjects;
+            for (size_t index = 0; index < objects.size(); index++)
+            {
+                size_t record = std::get<0>(objects[index]);
+                const char* p_object = m_DB.m_DBAddress + sizeof(DBHeader) + record * sizeof(object);
+                if (!IsResident(p_object))
+                {
+                    coldObjects.push_back(index);
+                    continue;
+                }
+
+                m_DB.UseRecords(record, 1);
+                memcpy(&std::get<1>(objects[index]), p_object, sizeof(object));
+                isIntact = m_DB.IsIntact(p_object, sizeof(object)) && isIntact;
+            }
+
+            if (!coldObjects.empty())
+            {
+                retcode = ReadCold(objects, coldObjects);
+            }
+
+            RETCODE unlockRetcode = m_DB.UnlockDB(DB_OPERATION::READ_BATCH);
+            retcode = RTN_OK == retcode ? unlockRetcode : retcode;
+            if (RTN_OK != retcode)
+            {
+                return m_DB.m_Statistics.Failure(retcode);
+            }
+
+            if (!isIntact)
+            {
+                return m_DB.m_Statistics.Failure(RTN_CORRUPT);
+            }
+
+            m_NumResidentReads += objects.size() - coldObjects.size();
+            m_NumColdReads += coldObjects.size();
+            m_DB.m_Statistics.Count(STATISTIC::READS, objects.size());
+            m_DB.m_Statistics.Count(STATISTIC::BYTES_COPIED, objects.size() * sizeof(object));
+
+            return RTN_OK;
+        }
+
+        /*
+         * Objects copied from the mapping and read from the file so far.
+         */
+        size_t NumberOfResidentReads(void) const
+        {
+            return m_NumResidentReads;
+        }
+
+        size_t NumberOfColdReads(void) const
+        {
+            return m_NumColdReads;
+        }
+
+    private:
+
+        /*
+         * Where a read of a record goes in the file, and where the record
+         * starts in what was read.
+         */
+        struct READ_SPAN
+        {
+            uint64_t offset;
+            size_t length;
+            size_t skip;
+        };
+
+        READ_SPAN Span(size_t record) const
+        {
+            uint64_t offset = sizeof(DBHeader) + record * sizeof(object);
+            if (!m_IsDirect)
+            {
+                return READ_SPAN{ offset, sizeof(object), 0 };
+            }
+
+            uint64_t alignedOffset = offset / m_PageSize * m_PageSize;
+            size_t skip = offset - alignedOffset;
+            return READ_SPAN{ alignedOffset, (skip + sizeof(object) + m_PageSize - 1) / m_PageSize * m_PageSize, skip };
+        }
+
+        void* Target(std::vector<std::tuple<size_t, object>>& objects, size_t index, size_t slot)
+        {
+            return m_IsDirect ? static_cast<void*>(m_Buffers.get() + slot * m_BufferSize) : static_cast<void*>(&std::get<1>(objects[index]));
+        }
+
+        /*
+         * Whether every page of a record is in the page cache. Records over
+         * RESIDENCY_CHECK_PAGES pages are always read from the file.
+         */
+        bool IsResident(const char* p_object) const
+        {
+            unsigned char residency[RESIDENCY_CHECK_PAGES];
+            uintptr_t first = reinterpret_cast<uintptr_t>(p_object) / m_PageSize * m_PageSize;
+            uintptr_t end = reinterpret_cast<uintptr_t>(p_object) + sizeof(object);
+            size_t numPages = (end - first + m_PageSize - 1) / m_PageSize;
+            if (RESIDENCY_CHECK_PAGES < numPages)
+            {
+                return false;
+            }
+
+            // When the kernel cannot tell, copying from the mapping is what dbInterface does
+            if (0 != mincore(reinterpret_cast<void*>(first), end - first, residency))
+            {
+                return true;
+            }
+
+            for (size_t page = 0; page < numPages; page++)
+            {
+                if (0 == (residency[page] & 1))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        RETCODE ReadCold(std::vector<std::tuple<size_t, object>>& objects, const std::vector<size_t>& coldObjects)
+        {
+#ifdef QCDB_IO_URING
+            if (m_Ring.IsOpen())
+            {
+                return ReadWithRing(objects, coldObjects);
+            }
+#endif
+
+            return ReadWithThreads(objects, coldObjects);
+        }
+
+#ifdef QCDB_IO_URING
+        /*
+         * Keep the ring full, a slot is an index into the buffer pool and
+         * the user data of its read.
+         */
+        RETCODE ReadWithRing(std::vector<std::tuple<size_t, object>>& objects, const std::vector<size_t>& coldObjects)
+        {
+            RETCODE retcode = RTN_OK;
+            std::vector<size_t> freeSlots;
+            std::vector<size_t> slotObjects(m_QueueDepth);
+            for (size_t slot = m_QueueDepth; slot > 0; slot--)
+            {
+                freeSlots.push_back(slot - 1);
+            }
+
+            size_t next = 0;
+            size_t numInFlight = 0;
+            while (next < coldObjects.size() || numInFlight)
+            {
+                while (next < coldObjects.size() && !freeSlots.empty())
+                {
+                    size_t slot = freeSlots.back();
+                    size_t index = coldObjects[next];
+                    READ_SPAN span = Span(std::get<0>(objects[index]));
+                    if (!m_Ring.QueueRead(m_FD, Target(objects, index, slot), static_cast<uint32_t>(span.length), span.offset, slot))
+                    {
+                        break;
+                    }
+
+                    freeSlots.pop_back();
+                    slotObjects[slot] = index;
+                    next++;
+                    numInFlight++;
+                }
+
+                if (!m_Ring.Submit(1))
+                {
+                    AbandonRing(numInFlight);
+                    return RTN_FAIL;
+                }
+
+                uint64_t slot = 0;
+                int32_t result = 0;
+                while (m_Ring.Complete(slot, result))
+                {
+                    size_t index = slotObjects[slot];
+                    RETCODE readRetcode = RTN_OK;
+                    if (0 > result || static_cast<size_t>(result) < Span(std::get<0>(objects[index])).skip + sizeof(object))
+                    {
+                        // Short reads and kernels without IORING_OP_READ read again the simple way
+                        readRetcode = ReadOne(objects, index, slot);
+                    }
+                    else if (m_IsDirect)
+                    {
+                        memcpy(&std::get<1>(objects[index]), m_Buffers.get() + slot * m_BufferSize + Span(std::get<0>(objects[index])).skip, sizeof(object));
+                    }
+
+                    retcode = RTN_OK == retcode ? readRetcode : retcode;
+                    freeSlots.push_back(slot);
+                    numInFlight--;
+                }
+            }
+
+            return retcode;
+        }
+
+        /*
+         * After a failed submission, wait for the reads the kernel took, they
+         * still write into the buffers and objects. A ring that cannot even
+         * be waited on is replaced, closing it cancels what is in flight.
+         */
+        void AbandonRing(size_t numInFlight)
+        {
+            numInFlight -= m_Ring.DiscardQueued();
+            while (numInFlight)
+            {
+                uint64_t slot = 0;
+                int32_t result = 0;
+                if (m_Ring.Complete(slot, result))
+                {
+                    numInFlight--;
+                }
+                else if (!m_Ring.Submit(1))
+                {
+                    m_Ring.Close();
+                    m_Ring.Open(static_cast<unsigned>(m_QueueDepth));
+                    return;
+                }
+            }
+        }
+#endif
+
+        /*
+         * Without io_uring every thread has one pread in flight. The reading
+         * threads are started the first time they are needed and wait for
+         * the next batch in between, the calling thread reads as slot 0.
+         */
+        RETCODE ReadWithThreads(std::vector<std::tuple<size_t, object>>& objects, const std::vector<size_t>& coldObjects)
+        {
+            size_t numThreads = std::min(m_QueueDepth, coldObjects.size());
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                while (m_Readers.size() + 1 < numThreads)
+                {
+                    m_Readers.emplace_back(&dbColdReader::Reader, this, m_Readers.size() + 1, m_Batch);
+                }
+
+                m_Objects = &objects;
+                m_ColdObjects = &coldObjects;
+                m_NextCold.store(0);
+                m_Retcodes.assign(m_Readers.size() + 1, RTN_OK);
+                m_NumBusy = m_Readers.size();
+                m_Batch++;
+            }
+
+            m_Ready.notify_all();
+            ReadBatch(0);
+
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Done.wait(lock, [this] { return 0 == m_NumBusy; });
+            for (RETCODE retcode : m_Retcodes)
+            {
+                if (RTN_OK != retcode)
+                {
+                    return retcode;
+                }
+            }
+
+            return RTN_OK;
+        }
+
+        void Reader(size_t slot, uint64_t batch)
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            for (;;)
+            {
+                m_Ready.wait(lock, [this, batch] { return m_IsStopping || batch != m_Batch; });
+                if (m_IsStopping)
+                {
+                    return;
+                }
+
+                batch = m_Batch;
+                lock.unlock();
+                ReadBatch(slot);
+                lock.lock();
+                if (0 == --m_NumBusy)
+                {
+                    m_Done.notify_one();
+                }
+            }
+        }
+
+        /*
+         * Take cold objects of the current batch until there are none left.
+         */
+        void ReadBatch(size_t slot)
+        {
+            for (size_t cold = m_NextCold.fetch_add(1); cold < m_ColdObjects->size(); cold = m_NextCold.fetch_add(1))
+            {
+                RETCODE retcode = ReadOne(*m_Objects, (*m_ColdObjects)[cold], slot);
+                m_Retcodes[slot] = RTN_OK == m_Retcodes[slot] ? retcode : m_Retcodes[slot];
+            }
+        }
+
+        RETCODE ReadOne(std::vector<std::tuple<size_t, object>>& objects, size_t index, size_t slot)
+        {
+            READ_SPAN span = Span(std::get<0>(objects[index]));
+            char* target = static_cast<char*>(Target(objects, index, slot));
+            size_t numRead = 0;
+            while (numRead < span.skip + sizeof(object))
+            {
+                ssize_t result = pread(m_FD, target + numRead, span.length - numRead, span.offset + numRead);
+                if (0 > result && EINTR == errno)
+                {
+                    continue;
+                }
+
+                if (0 >= result)
+                {
+                    return RTN_EOF;
+                }
+
+                numRead += result;
+            }
+
+            if (m_IsDirect)
+            {
+                memcpy(&std::get<1>(objects[index]), target + span.skip, sizeof(object));
+            }
+
+            return RTN_OK;
+        }
+
+        // Pages of a record checked for residency, bigger records are always read
+        static constexpr size_t RESIDENCY_CHECK_PAGES = 16;
+
+        DBType& m_DB;
+        int m_FD;
+        size_t m_QueueDepth;
+        bool m_IsDirect;
+        size_t m_PageSize;
+        size_t m_BufferSize;
+        std::unique_ptr<char, decltype(&free)> m_Buffers;
+#ifdef QCDB_IO_URING
+        IoRing m_Ring;
+#endif
+        size_t m_NumResidentReads;
+        size_t m_NumColdReads;
+
+        // The batch the reading threads work on, guarded by m_Mutex
+        std::vector<std::thread> m_Readers;
+        std::mutex m_Mutex;
+        std::condition_variable m_Ready;
+        std::condition_variable m_Done;
+        std::vector<std::tuple<size_t, object>>* m_Objects;
+        const std::vector<size_t>* m_ColdObjects;
+        std::atomic<size_t> m_NextCold;
+        std::vector<RETCODE> m_Retcodes;
+        uint64_t m_Batch;
+        size_t m_NumBusy;
+        bool m_IsStopping;
+    };
+}
+
+#endif
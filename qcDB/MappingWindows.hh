@@ -0,0 +1,265 @@
+#ifndef __QC_DB_MAPPING_WINDOWS_HH
+#define __QC_DB_MAPPING_WINDOWS_HH
+
+#include <common/OSdefines.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#ifndef WINDOWS_PLATFORM
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace qcDB
+{
+    /*
+     * How much of a table stays resident, see MappingWindows.
+     */
+    struct WINDOWED_MAPPING
+    {
+        // Bytes per window, rounded up to whole pages, 0 keeps the whole file resident
+        size_t windowSize;
+        // Windows kept resident before the least recently used one is released
+        size_t maxWindows;
+    };
+
+    /*
+     * Keeps a table that does not fit the memory it may use resident a
+     * window at a time.
+     *
+     * The file stays mapped at one address so records can be handed out as
+     * pointers, but it is not populated up front. The records are split in
+     * fixed size windows, every access tells which window it uses and once
+     * more than maxWindows were used the least recently used one that is not
+     * pinned is released. Releasing drops the pages from the process, changes
+     * stay in the page cache, and a later access faults them back in, so a
+     * thread still reading a released window only pays the faults again.
+     *
+     * Recency is counted in windows used, not accesses, so using a window
+     * that is already resident costs two relaxed loads. Pages touched
+     * outside the accesses that report themselves, such as views, are not
+     * released until their window is.
+     */
+    class MappingWindows
+    {
+    public:
+
+        MappingWindows(void) :
+            m_Address(nullptr), m_Length(0), m_WindowSize(0), m_MaxWindows(0), m_NumWindows(0),
+            m_Clock(0), m_NumResident(0)
+        {
+        }
+
+        MappingWindows(MappingWindows const&) = delete;
+        void operator = (MappingWindows const&) = delete;
+
+        /*
+         * Manage the first length bytes of the mapping at address.
+         */
+        void Attach(char* address, size_t length, const WINDOWED_MAPPING& mapping)
+        {
+#ifndef WINDOWS_PLATFORM
+            if (0 == mapping.windowSize || 0 == length)
+            {
+                return;
+            }
+
+            size_t pageSize = sysconf(_SC_PAGESIZE);
+            m_Address = address;
+            m_Length = length;
+            m_WindowSize = (mapping.windowSize + pageSize - 1) / pageSize * pageSize;
+            m_MaxWindows = std::max<size_t>(mapping.maxWindows, 1);
+            m_NumWindows = (length + m_WindowSize - 1) / m_WindowSize;
+            m_Windows.reset(new WINDOW[m_NumWindows]);
+#endif
+        }
+
+        bool IsWindowed(void) const
+        {
+            return 0 != m_WindowSize;
+        }
+
+        /*
+         * The offset just past the window holding offset, the whole mapping
+         * is one window when it is not windowed.
+         */
+        size_t WindowEnd(size_t offset) const
+        {
+            return 0 == m_WindowSize ? SIZE_MAX : std::min((offset / m_WindowSize + 1) * m_WindowSize, m_Length);
+        }
+
+        /*
+         * An access to length bytes at offset of the mapping.
+         */
+        void Use(size_t offset, size_t length)
+        {
+            if (0 == m_WindowSize || 0 == length)
+            {
+                return;
+            }
+
+            size_t last = std::min((offset + length - 1) / m_WindowSize, m_NumWindows - 1);
+            for (size_t window = offset / m_WindowSize; window <= last; window++)
+            {
+                UseWindow(window);
+            }
+        }
+
+        /*
+         * Keep the windows holding length bytes at offset resident until
+         * they are unpinned as often as they were pinned. Pinned windows
+         * count against maxWindows but are never released.
+         */
+        void Pin(size_t offset, size_t length)
+        {
+            if (0 == m_WindowSize || 0 == length)
+            {
+                return;
+            }
+
+            size_t last = std::min((offset + length - 1) / m_WindowSize, m_NumWindows - 1);
+            for (size_t window = offset / m_WindowSize; window <= last; window++)
+            {
+                m_Windows[window].numPins.fetch_add(1, std::memory_order_relaxed);
+                UseWindow(window);
+#ifndef WINDOWS_PLATFORM
+                madvise(m_Address + window * m_WindowSize, WindowLength(window), MADV_WILLNEED);
+#endif
+            }
+        }
+
+        void Unpin(size_t offset, size_t length)
+        {
+            if (0 == m_WindowSize || 0 == length)
+            {
+                return;
+            }
+
+            size_t last = std::min((offset + length - 1) / m_WindowSize, m_NumWindows - 1);
+            for (size_t window = offset / m_WindowSize; window <= last; window++)
+            {
+                uint32_t numPins = m_Windows[window].numPins.load(std::memory_order_relaxed);
+                while (numPins && !m_Windows[window].numPins.compare_exchange_weak(numPins, numPins - 1, std::memory_order_relaxed))
+                {
+                }
+            }
+        }
+
+        /*
+         * Release every window that is not pinned, after something touched
+         * the whole table.
+         */
+        void ReleaseAll(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (size_t window = 0; window < m_NumWindows; window++)
+            {
+                if (0 == m_Windows[window].numPins.load(std::memory_order_relaxed))
+                {
+                    Release(window);
+                }
+            }
+        }
+
+        size_t NumberOfResidentWindows(void) const
+        {
+            return m_NumResident.load(std::memory_order_relaxed);
+        }
+
+    private:
+
+        struct WINDOW
+        {
+            std::atomic<uint64_t> lastUsed{ 0 };
+            std::atomic<uint32_t> numPins{ 0 };
+            std::atomic<bool> isResident{ false };
+        };
+
+        void UseWindow(size_t window)
+        {
+            WINDOW& entry = m_Windows[window];
+            uint64_t now = m_Clock.load(std::memory_order_relaxed);
+            if (now != entry.lastUsed.load(std::memory_order_relaxed))
+            {
+                entry.lastUsed.store(now, std::memory_order_relaxed);
+            }
+
+            if (entry.isResident.load(std::memory_order_relaxed) || entry.isResident.exchange(true))
+            {
+                return;
+            }
+
+            entry.lastUsed.store(m_Clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (m_NumResident.fetch_add(1, std::memory_order_relaxed) + 1 > m_MaxWindows)
+            {
+                ReleaseLeastRecentlyUsed(window);
+            }
+        }
+
+        void ReleaseLeastRecentlyUsed(size_t windowInUse)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            while (m_NumResident.load(std::memory_order_relaxed) > m_MaxWindows)
+            {
+                size_t oldest = m_NumWindows;
+                uint64_t oldestUse = UINT64_MAX;
+                for (size_t window = 0; window < m_NumWindows; window++)
+                {
+                    const WINDOW& entry = m_Windows[window];
+                    if (window != windowInUse && entry.isResident.load(std::memory_order_relaxed) &&
+                        0 == entry.numPins.load(std::memory_order_relaxed) && entry.lastUsed.load(std::memory_order_relaxed) < oldestUse)
+                    {
+                        oldest = window;
+                        oldestUse = entry.lastUsed.load(std::memory_order_relaxed);
+                    }
+                }
+
+                // Everything else is pinned
+                if (m_NumWindows == oldest)
+                {
+                    return;
+                }
+
+                Release(oldest);
+            }
+        }
+
+        /*
+         * The mutex must be held.
+         */
+        void Release(size_t window)
+        {
+            if (m_Windows[window].isResident.exchange(false))
+            {
+                m_NumResident.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+#ifndef WINDOWS_PLATFORM
+            // Shared file pages keep their contents, only the process drops them
+            madvise(m_Address + window * m_WindowSize, WindowLength(window), MADV_DONTNEED);
+#endif
+        }
+
+        size_t WindowLength(size_t window) const
+        {
+            return std::min(m_WindowSize, m_Length - window * m_WindowSize);
+        }
+
+        char* m_Address;
+        size_t m_Length;
+        size_t m_WindowSize;
+        size_t m_MaxWindows;
+        size_t m_NumWindows;
+        std::unique_ptr<WINDOW[]> m_Windows;
+        std::atomic<uint64_t> m_Clock;
+        std::atomic<size_t> m_NumResident;
+        std::mutex m_Mutex;
+    };
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef __QC_DB_NUMA_HH
+#define __QC_DB_NUMA_HH
+
+#include <common/OSdefines.hh>
+#include <common/Retcode.hh>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+#ifndef WINDOWS_PLATFORM
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+namespace qcDB
+{
+    /*
+     * Where the records of a table are placed across NUMA nodes at open.
+     *
+     * INTERLEAVE: pages round robin across every node, for tables read from
+     *             everywhere.
+     * BIND: the records are split in one range per node and each range is
+     *       moved to its node, scans run each range on its node's CPUs.
+     *
+     * Both need a machine with more than one node and do nothing otherwise.
+     */
+    enum class NUMA_PLACEMENT
+    {
+        NONE = 0,
+        INTERLEAVE,
+        BIND
+    };
+
+    /*
+     * NUMA nodes and their CPUs as the kernel reports them in sysfs.
+     * Uses the system calls directly so nothing has to link libnuma.
+     */
+    class NumaTopology
+    {
+    public:
+
+        static const NumaTopology& Get(void)
+        {
+            static const NumaTopology topology;
+            return topology;
+        }
+
+        size_t NumNodes(void) const
+        {
+            return m_Nodes.empty() ? 1 : m_Nodes.size();
+        }
+
+        bool IsNuma(void) const
+        {
+            return 1 < m_Nodes.size();
+        }
+
+        /*
+         * Spread the pages of [address, address + length) across every node.
+         * address must be page aligned.
+         */
+        RETCODE Interleave(void* address, size_t length) const
+        {
+            std::vector<unsigned long> mask;
+            for (const NUMA_NODE& node : m_Nodes)
+            {
+                AddToMask(mask, node.id);
+            }
+
+            return SetPolicy(address, length, MPOL_INTERLEAVE, mask);
+        }
+
+        /*
+         * Move the pages of [address, address + length) to one node and keep
+         * them there. address must be page aligned.
+         */
+        RETCODE Bind(void* address, size_t length, size_t node) const
+        {
+            if (NumNodes() <= node)
+            {
+                return RTN_BAD_ARG;
+            }
+
+            std::vector<unsigned long> mask;
+            AddToMask(mask, m_Nodes.empty() ? 0 : m_Nodes[node].id);
+            return SetPolicy(address, length, MPOL_BIND, mask);
+        }
+
+        /*
+         * Run the calling thread on the CPUs of a node only.
+         */
+        RETCODE PinThread(size_t node) const
+        {
+#ifdef WINDOWS_PLATFORM
+            return RTN_OK;
+#else
+            if (m_Nodes.size() <= node)
+            {
+                return RTN_BAD_ARG;
+            }
+
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            for (int cpu : m_Nodes[node].cpus)
+            {
+                if (cpu < CPU_SETSIZE)
+                {
+                    CPU_SET(cpu, &cpus);
+                }
+            }
+
+            return 0 == sched_setaffinity(0, sizeof(cpus), &cpus) ? RTN_OK : RTN_FAIL;
+#endif
+        }
+
+    private:
+
+        struct NUMA_NODE
+        {
+            int id;
+            std::vector<int> cpus;
+        };
+
+        NumaTopology(void)
+        {
+#ifndef WINDOWS_PLATFORM
+            static const std::string NODE_DIRECTORY = "/sys/devices/system/node/";
+
+            for (int id : ReadList(NODE_DIRECTORY + "online"))
+            {
+                NUMA_NODE node = { id, ReadList(NODE_DIRECTORY + "node" + std::to_string(id) + "/cpulist") };
+                if (!node.cpus.empty())
+                {
+                    m_Nodes.push_back(node);
+                }
+            }
+#endif
+        }
+
+        /*
+         * Read a sysfs list such as "0-3,8,10-11".
+         */
+        static std::vector<int> ReadList(const std::string& path)
+        {
+            std::vector<int> values;
+            std::ifstream file(path);
+            std::string range;
+            while (std::getline(file, range, ','))
+            {
+                int first = 0;
+                int last = 0;
+                char separator = 0;
+                std::istringstream rangeStream(range);
+                if (!(rangeStream >> first))
+                {
+                    continue;
+                }
+
+                last = (rangeStream >> separator >> last) ? last : first;
+                for (int value = first; value <= last; value++)
+                {
+                    values.push_back(value);
+                }
+            }
+
+            return values;
+        }
+
+        static void AddToMask(std::vector<unsigned long>& mask, int id)
+        {
+            static constexpr size_t BITS_PER_WORD = sizeof(unsigned long) * 8;
+            if (mask.size() <= id / BITS_PER_WORD)
+            {
+                mask.resize(id / BITS_PER_WORD + 1, 0);
+            }
+
+            mask[id / BITS_PER_WORD] |= 1UL << (id % BITS_PER_WORD);
+        }
+
+        static RETCODE SetPolicy(void* address, size_t length, int mode, const std::vector<unsigned long>& mask)
+        {
+#ifdef WINDOWS_PLATFORM
+            return RTN_OK;
+#else
+            // Pages the mapping already populated are moved, not just new ones
+            long error = syscall(SYS_mbind, address, length, mode, mask.data(),
+                mask.size() * sizeof(unsigned long) * 8 + 1, MPOL_MF_MOVE);
+            return 0 == error ? RTN_OK : RTN_FAIL;
+#endif
+        }
+
+        std::vector<NUMA_NODE> m_Nodes;
+    };
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef __QC_DB_POLICIES_HH
+#define __QC_DB_POLICIES_HH
+
+#include <common/OSdefines.hh>
+#include <common/Retcode.hh>
+#include <common/DBHeader.hh>
+
+#include <shared_mutex>
+
+#ifdef WINDOWS_PLATFORM
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/*
+ * Policies for dbInterface. Each one is a small class the interface owns a
+ * copy of, so a policy that does nothing costs nothing once inlined.
+ *
+ * Lock policies provide:
+ *   static constexpr bool IS_LOCKING
+ *   RETCODE Lock(DBHeader* header, bool isRead)
+ *   RETCODE Unlock(DBHeader* header, bool isRead)
+ *
+ * Bounds policies provide:
+ *   static constexpr bool IS_CHECKED
+ */
+namespace qcDB
+{
+    /*
+     * The rwlock stored in the file, shared by every process that maps it.
+     * This is the default.
+     */
+    class ProcessSharedLock
+    {
+    public:
+
+        static constexpr bool IS_LOCKING = true;
+
+#ifdef WINDOWS_PLATFORM
+        ProcessSharedLock(void) :
+            m_Mutex(INVALID_HANDLE_VALUE)
+        {
+        }
+#endif
+
+        RETCODE Lock(DBHeader* header, bool isRead)
+        {
+#ifdef WINDOWS_PLATFORM
+            m_Mutex = CreateMutexA(NULL, FALSE, "MutexForFileLock");
+            if (nullptr == m_Mutex)
+            {
+                return RTN_LOCK_ERROR;
+            }
+#else
+            int lockError = 0;
+            if (isRead)
+            {
+                lockError = pthread_rwlock_rdlock(&header->m_DBLock);
+            }
+            else
+            {
+                lockError = pthread_rwlock_wrlock(&header->m_DBLock);
+            }
+
+            if (0 != lockError)
+            {
+                return RTN_LOCK_ERROR;
+            }
+#endif
+
+            return RTN_OK;
+        }
+
+        RETCODE Unlock(DBHeader* header, bool /* isRead */)
+        {
+#ifdef WINDOWS_PLATFORM
+            if (ReleaseMutex(m_Mutex))
+            {
+                return RTN_LOCK_ERROR;
+            }
+#else
+            if (0 != pthread_rwlock_unlock(&header->m_DBLock))
+            {
+                return RTN_LOCK_ERROR;
+            }
+#endif
+
+            return RTN_OK;
+        }
+
+    private:
+
+#ifdef WINDOWS_PLATFORM
+        HANDLE m_Mutex;
+#endif
+    };
+
+    /*
+     * Single writer, multiple readers within this process only. For tables
+     * one process owns, no other process may open the file while it is used.
+     */
+    class ThreadSharedLock
+    {
+    public:
+
+        static constexpr bool IS_LOCKING = true;
+
+        RETCODE Lock(DBHeader* /* header */, bool isRead)
+        {
+            if (isRead)
+            {
+                m_Lock.lock_shared();
+            }
+            else
+            {
+                m_Lock.lock();
+            }
+
+            return RTN_OK;
+        }
+
+        RETCODE Unlock(DBHeader* /* header */, bool isRead)
+        {
+            if (isRead)
+            {
+                m_Lock.unlock_shared();
+            }
+            else
+            {
+                m_Lock.unlock();
+            }
+
+            return RTN_OK;
+        }
+
+    private:
+
+        std::shared_mutex m_Lock;
+    };
+
+    /*
+     * No locking at all, only one thread of one process may use the table.
+     * FindObjects still scans in parallel but only while the caller waits.
+     */
+    class NoLock
+    {
+    public:
+
+        static constexpr bool IS_LOCKING = false;
+
+        RETCODE Lock(DBHeader* /* header */, bool /* isRead */)
+        {
+            return RTN_OK;
+        }
+
+        RETCODE Unlock(DBHeader* /* header */, bool /* isRead */)
+        {
+            return RTN_OK;
+        }
+    };
+
+    /*
+     * Reject records past the end of the database. This is the default.
+     */
+    struct BoundsChecked
+    {
+        static constexpr bool IS_CHECKED = true;
+    };
+
+    /*
+     * Trust the caller to pass valid records.
+     */
+    struct Unchecked
+    {
+        static constexpr bool IS_CHECKED = false;
+    };
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef __QC_DB_PROTOCOL_HH
+#define __QC_DB_PROTOCOL_HH
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Binary protocol between dbServer and dbClient over a Unix domain socket.
+ *
+ * Every request is a REQUEST_HEADER followed by length payload bytes and
+ * every response a RESPONSE_HEADER followed by length payload bytes. A client
+ * may send any number of requests before reading the responses, responses
+ * to requests on the same table come back in the order they were sent.
+ */
+namespace qcDB
+{
+    enum class OPCODE : uint16_t
+    {
+        // payload: object name, response payload: TABLE_INFO
+        OPEN = 1,
+        // response payload: the record, version: its version
+        READ,
+        // payload: the record, response version: its new version
+        WRITE,
+        DELETE_RECORD,
+        // version: expected version, payload: the record
+        COMPARE_AND_WRITE,
+        // response payload: TABLE_INFO
+        INFO
+    };
+
+    struct REQUEST_HEADER
+    {
+        uint32_t length;
+        uint32_t requestID;
+        uint16_t opcode;
+        uint16_t table;
+        uint32_t reserved;
+        uint64_t record;
+        uint64_t version;
+    };
+
+    struct RESPONSE_HEADER
+    {
+        uint32_t length;
+        uint32_t requestID;
+        uint32_t retcode;
+        uint32_t reserved;
+        uint64_t version;
+    };
+
+    struct TABLE_INFO
+    {
+        uint64_t table;
+        uint64_t numRecords;
+        uint64_t recordSize;
+        uint64_t lastWritten;
+    };
+
+    // Requests with bigger payloads close the connection
+    constexpr uint32_t MAX_PAYLOAD_SIZE = 1024 * 1024;
+
+    // Bytes of requests, and of their responses, a client keeps in flight.
+    // The server buffers more than this per client, so a client sending a
+    // batch never waits on a server that waits for the client to read.
+    constexpr size_t MAX_PIPELINED_BYTES = 1024 * 1024;
+}
+
+#endif
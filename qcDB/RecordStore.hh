@@ -0,0 +1,206 @@
+#ifndef __QC_DB_RECORD_STORE_HH
+#define __QC_DB_RECORD_STORE_HH
+
+#include <common/DBHeader.hh>
+#include <qcDB/Checksum.hh>
+#include <qcDB/MappingWindows.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace qcDB
+{
+    /*
+     * The byte level write path of a database file, shared by dbInterface
+     * and dbServer, which only knows the record size at run time.
+     *
+     * Writes keep the size and last written record in the DBHeader, the
+     * record versions, the block checksums and the change generations
+     * current. Bloom filters and change handlers are up to the caller, they
+     * need the object type. Everything but BumpVersion and MarkChanged must
+     * be called with the DB locked for writing.
+     */
+    class RecordStore
+    {
+    public:
+
+        RecordStore(void) :
+            m_DBAddress(nullptr), m_RecordSize(0), m_NumRecords(0), m_Versions(nullptr),
+            m_Checksums(nullptr), m_Generations(nullptr), m_Windows(nullptr)
+        {
+        }
+
+        /*
+         * Find the regions of a mapped database file. A windowed mapping is
+         * told about the records Delete looks at.
+         */
+        void Attach(char* dbAddress, MappingWindows* windows = nullptr)
+        {
+            const DBHeader* header = reinterpret_cast<const DBHeader*>(dbAddress);
+            size_t numBloomFilters = __builtin_popcountll(header->m_BloomFields);
+
+            m_DBAddress = dbAddress;
+            m_RecordSize = header->m_RecordSize;
+            m_NumRecords = header->m_NumRecords;
+            m_Versions = reinterpret_cast<RECORD_VERSION*>(dbAddress + VersionsOffset(m_NumRecords, m_RecordSize));
+            if (header->m_Checksums)
+            {
+                m_Checksums = reinterpret_cast<BLOCK_CHECKSUM*>(dbAddress + ChecksumsOffset(m_NumRecords, m_RecordSize, numBloomFilters));
+            }
+
+            if (header->m_Generation)
+            {
+                size_t generationsOffset = GenerationsOffset(m_NumRecords, m_RecordSize, numBloomFilters, nullptr != m_Checksums);
+                m_Generations = reinterpret_cast<BLOCK_GENERATION*>(dbAddress + generationsOffset);
+            }
+
+            m_Windows = windows;
+        }
+
+        RECORD_VERSION* Versions(void) const
+        {
+            return m_Versions;
+        }
+
+        BLOCK_CHECKSUM* Checksums(void) const
+        {
+            return m_Checksums;
+        }
+
+        BLOCK_GENERATION* Generations(void) const
+        {
+            return m_Generations;
+        }
+
+        /*
+         * Overwrite a record and return its new version.
+         */
+        RECORD_VERSION WriteRecord(char* p_record, size_t record, const void* p_source)
+        {
+            DBHeader* header = Header();
+            header->m_LastWritten = record;
+            if (header->m_Size < record)
+            {
+                header->m_Size = record;
+            }
+
+            StoreBytes(p_record, p_source, m_RecordSize);
+            return BumpVersion(record);
+        }
+
+        /*
+         * Zero a record and return its new version. If it was the last
+         * record the one before the next record that is not zero becomes
+         * the last.
+         */
+        RECORD_VERSION DeleteRecord(char* p_record, size_t record)
+        {
+            DBHeader* header = Header();
+            StoreBytes(p_record, nullptr, m_RecordSize);
+            RECORD_VERSION version = BumpVersion(record);
+
+            if (header->m_Size == record)
+            {
+                const char* p_current = p_record;
+                while (0 < record)
+                {
+                    --record;
+                    p_current -= m_RecordSize;
+                    if (nullptr != m_Windows)
+                    {
+                        m_Windows->Use(sizeof(DBHeader) + record * m_RecordSize, m_RecordSize);
+                    }
+
+                    if (!IsZero(p_current, m_RecordSize))
+                    {
+                        break;
+                    }
+                }
+
+                header->m_Size = record;
+            }
+
+            return version;
+        }
+
+        /*
+         * Copy bytes into the records, nullptr zeroes them, keeping the
+         * block checksums and generations current.
+         */
+        void StoreBytes(char* p_destination, const void* p_source, size_t length)
+        {
+            UpdateChecksums(p_destination, p_destination, p_source, length);
+            if (p_source)
+            {
+                memcpy(p_destination, p_source, length);
+            }
+            else
+            {
+                memset(p_destination, 0, length);
+            }
+
+            MarkChanged(p_destination, length);
+        }
+
+        /*
+         * Atomic since the field operations bump versions under the read lock.
+         */
+        RECORD_VERSION BumpVersion(size_t record)
+        {
+            return __atomic_add_fetch(&m_Versions[record], 1, __ATOMIC_RELEASE);
+        }
+
+        /*
+         * Update the block checksums for length bytes at p_destination in the
+         * records changing from p_old to p_new, nullptr for zeroes.
+         */
+        void UpdateChecksums(const char* p_destination, const void* p_old, const void* p_new, size_t length)
+        {
+            if (m_Checksums)
+            {
+                size_t offset = p_destination - (m_DBAddress + sizeof(DBHeader));
+                UpdateBlockChecksums(m_Checksums, m_NumRecords * m_RecordSize, offset, p_old, p_new, length);
+            }
+        }
+
+        /*
+         * Stamp the blocks holding length bytes at p_destination in the records
+         * with the current generation for incremental backups. Called after
+         * the bytes changed, the field operations change them under the read
+         * lock so the generation is read in order with them: a stamp of the
+         * old generation means the backup starting the new one sees the change.
+         */
+        void MarkChanged(const char* p_destination, size_t length)
+        {
+            if (m_Generations)
+            {
+                size_t offset = p_destination - (m_DBAddress + sizeof(DBHeader));
+                StampBlocks(m_Generations, __atomic_load_n(&Header()->m_Generation, __ATOMIC_SEQ_CST), offset, length);
+            }
+        }
+
+    private:
+
+        DBHeader* Header(void) const
+        {
+            return reinterpret_cast<DBHeader*>(m_DBAddress);
+        }
+
+        static bool IsZero(const char* p_bytes, size_t length)
+        {
+            // Zero if the first byte is and every byte equals the one before it
+            return 0 == p_bytes[0] && 0 == memcmp(p_bytes, p_bytes + 1, length - 1);
+        }
+
+        char* m_DBAddress;
+        size_t m_RecordSize;
+        size_t m_NumRecords;
+        RECORD_VERSION* m_Versions;
+        BLOCK_CHECKSUM* m_Checksums;
+        BLOCK_GENERATION* m_Generations;
+        MappingWindows* m_Windows;
+    };
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef __QC_DB_REFLECTION_HH
+#define __QC_DB_REFLECTION_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <initializer_list>
+#include <functional>
+#include <type_traits>
+
+/*
+ * Compile time description of the objects generated by dbGenerator.
+ *
+ * Every generated header specializes qcDB::Reflection for its object with
+ * the field descriptors and a tuple of Field types, one per schema field.
+ * Generic code can walk the fields with ForEachField and get a compile time
+ * Field type for each one, so nothing has to look up the layout at runtime.
+ */
+namespace qcDB
+{
+    struct FIELD_DESCRIPTOR
+    {
+        const char* name;
+        char type;
+        size_t offset;
+        size_t size;
+        size_t count;
+    };
+
+    /*
+     * Specialized by every generated header with:
+     *   OBJECT_NAME, OBJECT_NUMBER, NUM_RECORDS, NUM_FIELDS,
+     *   FIELDS (FIELD_DESCRIPTOR array) and Fields (tuple of Field types)
+     */
+    template <typename Object>
+    struct Reflection;
+
+    /*
+     * Hash, equality and ordering of a single field value.
+     * Character arrays are compared as strings up to their first null, other
+     * arrays element by element.
+     */
+    template <typename Type, typename Enable = void>
+    struct FieldTraits
+    {
+        static size_t Hash(const Type& value)
+        {
+            return std::hash<Type>()(value);
+        }
+
+        static bool Equal(const Type& left, const Type& right)
+        {
+            return left == right;
+        }
+
+        static int Compare(const Type& left, const Type& right)
+        {
+            return left < right ? -1 : (right < left ? 1 : 0);
+        }
+    };
+
+    template <size_t N>
+    struct FieldTraits<char[N]>
+    {
+        static size_t Hash(const char (&value)[N])
+        {
+            // FNV-1a
+            size_t hash = 14695981039346656037ULL;
+            for (size_t character = 0; character < N && value[character]; character++)
+            {
+                hash ^= static_cast<unsigned char>(value[character]);
+                hash *= 1099511628211ULL;
+            }
+
+            return hash;
+        }
+
+        static bool Equal(const char (&left)[N], const char (&right)[N])
+        {
+            return 0 == strncmp(left, right, N);
+        }
+
+        static int Compare(const char (&left)[N], const char (&right)[N])
+        {
+            int result = strncmp(left, right, N);
+            return result < 0 ? -1 : (result > 0 ? 1 : 0);
+        }
+    };
+
+    template <typename Type, size_t N>
+    struct FieldTraits<Type[N], typename std::enable_if<!std::is_same<Type, char>::value>::type>
+    {
+        static size_t Hash(const Type (&value)[N])
+        {
+            size_t hash = 0;
+            for (size_t element = 0; element < N; element++)
+            {
+                hash = CombineHash(hash, FieldTraits<Type>::Hash(value[element]));
+            }
+
+            return hash;
+        }
+
+        static bool Equal(const Type (&left)[N], const Type (&right)[N])
+        {
+            for (size_t element = 0; element < N; element++)
+            {
+                if (!FieldTraits<Type>::Equal(left[element], right[element]))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        static int Compare(const Type (&left)[N], const Type (&right)[N])
+        {
+            for (size_t element = 0; element < N; element++)
+            {
+                int result = FieldTraits<Type>::Compare(left[element], right[element]);
+                if (result)
+                {
+                    return result;
+                }
+            }
+
+            return 0;
+        }
+
+    private:
+
+        static size_t CombineHash(size_t seed, size_t hash)
+        {
+            return seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+        }
+    };
+
+    /*
+     * One field of a generated object, everything about it is a compile
+     * time constant.
+     */
+    template <typename Object, size_t Index, typename Type, Type Object::* Member>
+    struct Field
+    {
+        using ObjectType = Object;
+        using ValueType = Type;
+
+        static constexpr size_t INDEX = Index;
+
+        static constexpr const FIELD_DESCRIPTOR& Descriptor(void)
+        {
+            return Reflection<Object>::FIELDS[Index];
+        }
+
+        static Type& Get(Object& object)
+        {
+            return object.*Member;
+        }
+
+        static const Type& Get(const Object& object)
+        {
+            return object.*Member;
+        }
+
+        static size_t Hash(const Object& object)
+        {
+            return FieldTraits<Type>::Hash(object.*Member);
+        }
+
+        static bool Equal(const Object& left, const Object& right)
+        {
+            return FieldTraits<Type>::Equal(left.*Member, right.*Member);
+        }
+
+        static int Compare(const Object& left, const Object& right)
+        {
+            return FieldTraits<Type>::Compare(left.*Member, right.*Member);
+        }
+
+        static bool Less(const Object& left, const Object& right)
+        {
+            return Compare(left, right) < 0;
+        }
+    };
+
+    template <typename Object, typename Visitor, size_t... Indexes>
+    inline void ForEachField(Object& object, Visitor&& visitor, std::index_sequence<Indexes...>)
+    {
+        using Fields = typename Reflection<typename std::remove_const<Object>::type>::Fields;
+        (void)std::initializer_list<int>{ (visitor(typename std::tuple_element<Indexes, Fields>::type(),
+            std::tuple_element<Indexes, Fields>::type::Get(object)), 0)... };
+    }
+
+    /*
+     * Call visitor(field, value) for every field in schema order, where field
+     * is a default constructed Field type and value references the member.
+     */
+    template <typename Object, typename Visitor>
+    inline void ForEachField(Object& object, Visitor&& visitor)
+    {
+        using Fields = typename Reflection<typename std::remove_const<Object>::type>::Fields;
+        ForEachField(object, std::forward<Visitor>(visitor), std::make_index_sequence<std::tuple_size<Fields>::value>());
+    }
+
+    /*
+     * Index of the field with the given name, or NUM_FIELDS if there is none.
+     */
+    template <typename Object>
+    constexpr size_t FieldIndex(const char* name)
+    {
+        for (size_t field = 0; field < Reflection<Object>::NUM_FIELDS; field++)
+        {
+            const char* fieldName = Reflection<Object>::FIELDS[field].name;
+            size_t character = 0;
+            while (fieldName[character] && fieldName[character] == name[character])
+            {
+                character++;
+            }
+
+            if (fieldName[character] == name[character])
+            {
+                return field;
+            }
+        }
+
+        return Reflection<Object>::NUM_FIELDS;
+    }
+
+    template <typename Object>
+    inline size_t HashObject(const Object& object)
+    {
+        size_t hash = 0;
+        ForEachField(object, [&](auto field, const auto&)
+        {
+            hash ^= decltype(field)::Hash(object) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        });
+
+        return hash;
+    }
+
+    template <typename Object>
+    inline bool EqualObjects(const Object& left, const Object& right)
+    {
+        bool isEqual = true;
+        ForEachField(left, [&](auto field, const auto&)
+        {
+            isEqual = isEqual && decltype(field)::Equal(left, right);
+        });
+
+        return isEqual;
+    }
+
+    /*
+     * Lexicographic ordering by the fields in schema order.
+     */
+    template <typename Object>
+    inline int CompareObjects(const Object& left, const Object& right)
+    {
+        int result = 0;
+        ForEachField(left, [&](auto field, const auto&)
+        {
+            if (0 == result)
+            {
+                result = decltype(field)::Compare(left, right);
+            }
+        });
+
+        return result;
+    }
+}
+
+#endif
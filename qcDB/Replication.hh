@@ -0,0 +1,746 @@
+#ifndef __QC_DB_REPLICATION_HH
+#define __QC_DB_REPLICATION_HH
+
+#include <common/Retcode.hh>
+#include <common/DBHeader.hh>
+#include <qcDB/qcDB.hh>
+#include <qcDB/Reflection.hh>
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*
+ * Hot standby copies of a table fed by a stream of its changes.
+ *
+ * A dbReplicationSource attached to the dbInterface of the primary writes
+ * every change made through it to a pipe or stream socket, and a dbReplica
+ * applies them to its own database file in the same order:
+ *
+ *     qcDB::dbReplicationSource<PERSON> source(people, socketFD);
+ *     ...
+ *     qcDB::dbReplica<PERSON> replica(standbyPeople, socketFD);
+ *     replica.Status().lagSeconds;
+ *
+ * The stream is a STREAM_HEADER followed by CHANGE_HEADERs, changes carry
+ * the records they touched as they are after the change, so applying the
+ * last change of a record gives it the value it has on the primary.
+ */
+namespace qcDB
+{
+    struct STREAM_HEADER
+    {
+        char objectName[sizeof(DBHeader::m_ObjectName)];
+        uint64_t numRecords;
+        uint64_t recordSize;
+    };
+
+    enum class CHANGE_TYPE : uint32_t
+    {
+        // payload: numRecords records from firstRecord
+        RECORDS = 1,
+        // every record was zeroed
+        CLEAR,
+        // the changes so far bring a replica to the whole table
+        SYNCHRONIZED,
+        // nothing changed lately, sent so the replica can tell its lag
+        HEARTBEAT
+    };
+
+    struct CHANGE_HEADER
+    {
+        // RECORDS and CLEAR count up from 1, the others repeat the last one
+        uint64_t sequence;
+        // When the source queued the change, nanoseconds since the epoch
+        int64_t timestamp;
+        uint64_t firstRecord;
+        uint32_t numRecords;
+        uint32_t type;
+    };
+
+    struct REPLICATION_STATUS
+    {
+        uint64_t receivedSequence;
+        uint64_t appliedSequence;
+        // Since the source queued the newest change or heartbeat applied,
+        // across hosts this includes the difference of their clocks
+        double lagSeconds;
+        // The snapshot the source starts with has been applied
+        bool isSynchronized;
+    };
+
+    inline int64_t ReplicationTimestamp(void)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /*
+     * Streams the changes made through a dbInterface to fd, a pipe or a
+     * connected stream socket that stays owned by the caller.
+     *
+     * The stream starts with a snapshot of the table, sent a batch at a time
+     * under the read lock while writers keep going. Every change after that
+     * is queued by the writer that made it, in the order of the changes, and
+     * written to fd by a thread of the source, with a heartbeat when nothing
+     * changed for HEARTBEAT_INTERVAL. Writers wait when MAX_PENDING_BYTES are
+     * queued so a slow replica cannot grow the queue without bound. If fd
+     * fails the stream stops, Retcode tells why, and the table works on.
+     *
+     * Only changes made through this dbInterface are streamed, not those of
+     * other processes mapping the file. Ignore SIGPIPE when fd is a pipe.
+     */
+    template <class object, class LockPolicy = ProcessSharedLock, class BoundsPolicy = BoundsChecked>
+    class dbReplicationSource
+    {
+    public:
+
+        using DBType = dbInterface<object, LockPolicy, BoundsPolicy>;
+
+        dbReplicationSource(DBType& db, int fd) :
+            m_DB(db), m_FD(fd), m_Sequence(0), m_Retcode(RTN_OK), m_IsStopping(false)
+        {
+            STREAM_HEADER streamHeader;
+            memset(&streamHeader, 0, sizeof(streamHeader));
+            strncpy(streamHeader.objectName, Reflection<object>::OBJECT_NAME, sizeof(streamHeader.objectName) - 1);
+            streamHeader.numRecords = m_DB.NumberOfRecords();
+            streamHeader.recordSize = sizeof(object);
+            m_Pending.insert(m_Pending.end(), reinterpret_cast<const char*>(&streamHeader),
+                reinterpret_cast<const char*>(&streamHeader) + sizeof(streamHeader));
+
+            m_Sender = std::thread(&dbReplicationSource::Send, this);
+
+            RETCODE retcode = Attach();
+            retcode = RTN_OK == retcode ? SendSnapshot() : retcode;
+            if (RTN_OK != retcode)
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Retcode = RTN_OK == m_Retcode ? retcode : m_Retcode;
+            }
+        }
+
+        /*
+         * Sends everything queued before returning. The write lock waits for
+         * the changes still running.
+         */
+        ~dbReplicationSource(void)
+        {
+            if (RTN_OK == m_DB.LockDB(DB_OPERATION::WRITE))
+            {
+                m_DB.m_ChangeHandler = nullptr;
+                m_DB.UnlockDB(DB_OPERATION::WRITE);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_IsStopping = true;
+            }
+
+            m_Queued.notify_one();
+            m_Sender.join();
+        }
+
+        dbReplicationSource(dbReplicationSource const&) = delete;
+        void operator = (dbReplicationSource const&) = delete;
+
+        /*
+         * Sequence of the last change queued.
+         */
+        uint64_t Sequence(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Sequence;
+        }
+
+        /*
+         * RTN_OK while the stream works, why it stopped otherwise.
+         */
+        RETCODE Retcode(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Retcode;
+        }
+
+    private:
+
+        /*
+         * The handler is set under the write lock together with the clear
+         * that starts the snapshot, so no change falls between them.
+         */
+        RETCODE Attach(void)
+        {
+            RETCODE retcode = m_DB.LockDB(DB_OPERATION::WRITE);
+            if (RTN_OK != retcode)
+            {
+                return retcode;
+            }
+
+            m_DB.m_ChangeHandler = [this](size_t firstRecord, size_t numRecords, const object* p_records)
+            {
+                Queue(p_records ? CHANGE_TYPE::RECORDS : CHANGE_TYPE::CLEAR, firstRecord, numRecords, p_records);
+            };
+
+            Queue(CHANGE_TYPE::CLEAR, 0, m_DB.NumberOfRecords(), nullptr);
+            return m_DB.UnlockDB(DB_OPERATION::WRITE);
+        }
+
+        /*
+         * Changes made between two batches are queued between them, a record
+         * changed after its batch is sent again with the change.
+         */
+        RETCODE SendSnapshot(void)
+        {
+            static const object deletedObject = { 0 };
+            for (size_t first = 0;; first += SNAPSHOT_BATCH_RECORDS)
+            {
+                RETCODE retcode = m_DB.LockDB(DB_OPERATION::READ_BATCH);
+                if (RTN_OK != retcode)
+                {
+                    return retcode;
+                }
+
+                size_t scanSize = m_DB.ScanSize();
+                if (first >= scanSize)
+                {
+                    Queue(CHANGE_TYPE::SYNCHRONIZED, 0, 0, nullptr);
+                    return m_DB.UnlockDB(DB_OPERATION::READ_BATCH);
+                }
+
+                // The replica starts cleared, runs of deleted records need not be sent
+                const object* records = reinterpret_cast<const object*>(m_DB.m_DBAddress + sizeof(DBHeader));
+                size_t last = std::min(first + SNAPSHOT_BATCH_RECORDS, scanSize);
+                size_t runStart = first;
+                size_t windowEnd = first;
+                for (size_t record = first; record <= last; record++)
+                {
+                    // Runs are sent a window at a time, a windowed table may release the window before
+                    if (record < last && windowEnd == record)
+                    {
+                        if (runStart < record)
+                        {
+                            Queue(CHANGE_TYPE::RECORDS, runStart, record - runStart, records + runStart);
+                            runStart = record;
+                        }
+
+                        windowEnd = m_DB.UseWindowOf(record, last);
+                    }
+
+                    if (record < last && 0 != memcmp(&records[record], &deletedObject, sizeof(object)))
+                    {
+                        continue;
+                    }
+
+                    if (runStart < record)
+                    {
+                        Queue(CHANGE_TYPE::RECORDS, runStart, record - runStart, records + runStart);
+                    }
+
+                    runStart = record + 1;
+                }
+
+                retcode = m_DB.UnlockDB(DB_OPERATION::READ_BATCH);
+                if (RTN_OK != retcode)
+                {
+                    return retcode;
+                }
+            }
+        }
+
+        /*
+         * Changes are serialized here, a field operation racing another one
+         * on its record copies the record after both.
+         */
+        void Queue(CHANGE_TYPE type, size_t firstRecord, size_t numRecords, const object* p_records)
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Sent.wait(lock, [this] { return MAX_PENDING_BYTES > m_Pending.size() || RTN_OK != m_Retcode; });
+            if (RTN_OK != m_Retcode)
+            {
+                return;
+            }
+
+            if (CHANGE_TYPE::RECORDS == type || CHANGE_TYPE::CLEAR == type)
+            {
+                m_Sequence++;
+            }
+
+            AppendChange(type, firstRecord, numRecords, p_records);
+            m_Queued.notify_one();
+        }
+
+        /*
+         * The mutex must be held.
+         */
+        void AppendChange(CHANGE_TYPE type, size_t firstRecord, size_t numRecords, const object* p_records)
+        {
+            CHANGE_HEADER change = { m_Sequence, ReplicationTimestamp(), firstRecord, static_cast<uint32_t>(numRecords), static_cast<uint32_t>(type) };
+            m_Pending.insert(m_Pending.end(), reinterpret_cast<const char*>(&change), reinterpret_cast<const char*>(&change) + sizeof(change));
+            if (CHANGE_TYPE::RECORDS == type)
+            {
+                m_Pending.insert(m_Pending.end(), reinterpret_cast<const char*>(p_records),
+                    reinterpret_cast<const char*>(p_records + numRecords));
+            }
+        }
+
+        void Send(void)
+        {
+            std::vector<char> sending;
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            for (;;)
+            {
+                m_Queued.wait_for(lock, HEARTBEAT_INTERVAL, [this] { return !m_Pending.empty() || m_IsStopping; });
+                if (m_Pending.empty())
+                {
+                    if (m_IsStopping)
+                    {
+                        return;
+                    }
+
+                    AppendChange(CHANGE_TYPE::HEARTBEAT, 0, 0, nullptr);
+                }
+
+                sending.clear();
+                sending.swap(m_Pending);
+                m_Sent.notify_all();
+                lock.unlock();
+
+                RETCODE retcode = WriteAll(sending.data(), sending.size());
+
+                lock.lock();
+                if (RTN_OK != retcode)
+                {
+                    m_Retcode = retcode;
+                    m_Pending.clear();
+                    m_Sent.notify_all();
+                    return;
+                }
+            }
+        }
+
+        RETCODE WriteAll(const char* data, size_t length)
+        {
+            bool isSocket = true;
+            while (length)
+            {
+                ssize_t numWritten = isSocket ? send(m_FD, data, length, MSG_NOSIGNAL) : write(m_FD, data, length);
+                if (0 > numWritten && ENOTSOCK == errno && isSocket)
+                {
+                    isSocket = false;
+                    continue;
+                }
+
+                if (0 > numWritten && EINTR == errno)
+                {
+                    continue;
+                }
+
+                if (0 >= numWritten)
+                {
+                    return RTN_CONNECTION_FAIL;
+                }
+
+                data += numWritten;
+                length -= numWritten;
+            }
+
+            return RTN_OK;
+        }
+
+        // Records per read lock acquisition of the snapshot
+        static constexpr size_t SNAPSHOT_BATCH_RECORDS = 4096;
+
+        // Queued bytes writers wait on
+        static constexpr size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+        static constexpr std::chrono::milliseconds HEARTBEAT_INTERVAL = std::chrono::milliseconds(100);
+
+        DBType& m_DB;
+        int m_FD;
+        uint64_t m_Sequence;
+        std::vector<char> m_Pending;
+        RETCODE m_Retcode;
+        std::mutex m_Mutex;
+        std::condition_variable m_Queued;
+        std::condition_variable m_Sent;
+        bool m_IsStopping;
+        std::thread m_Sender;
+    };
+
+    /*
+     * Applies the stream of a dbReplicationSource from fd to a table of its
+     * own on a thread of the replica.
+     *
+     * The changes that arrived together are applied under one write lock
+     * acquisition, up to APPLY_BATCH_BYTES, so the table stays readable
+     * through the same dbInterface or any process mapping the file. Records
+     * the primary zeroed are deleted. The table must have as many records
+     * as the primary, it is cleared when the stream starts.
+     *
+     * If the stream ends or breaks the replica stops applying, Retcode tells
+     * why and the table keeps the changes applied so far.
+     */
+    template <class object, class LockPolicy = ProcessSharedLock, class BoundsPolicy = BoundsChecked>
+    class dbReplica
+    {
+    public:
+
+        using DBType = dbInterface<object, LockPolicy, BoundsPolicy>;
+
+        dbReplica(DBType& db, int fd) :
+            m_DB(db), m_FD(fd), m_Retcode(RTN_OK), m_IsStopping(false)
+        {
+            memset(&m_Status, 0, sizeof(m_Status));
+            m_LastTimestamp = 0;
+            m_Applier = std::thread(&dbReplica::Apply, this);
+        }
+
+        ~dbReplica(void)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_IsStopping = true;
+            }
+
+            m_Applier.join();
+        }
+
+        dbReplica(dbReplica const&) = delete;
+        void operator = (dbReplica const&) = delete;
+
+        REPLICATION_STATUS Status(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            REPLICATION_STATUS status = m_Status;
+            if (m_LastTimestamp)
+            {
+                status.lagSeconds = (ReplicationTimestamp() - m_LastTimestamp) / 1e9;
+            }
+
+            return status;
+        }
+
+        /*
+         * RTN_OK while applying, RTN_EOF once the source closed the stream,
+         * RTN_BAD_ARG if it is of another table, RTN_CORRUPT if changes are
+         * missing or out of range.
+         */
+        RETCODE Retcode(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Retcode;
+        }
+
+    private:
+
+        void Apply(void)
+        {
+            std::vector<char> buffer(APPLY_BATCH_BYTES);
+            size_t numBuffered = 0;
+            bool isStarted = false;
+            for (;;)
+            {
+                RETCODE retcode = Receive(buffer, numBuffered);
+                if (RTN_OK == retcode && !isStarted && sizeof(STREAM_HEADER) <= numBuffered)
+                {
+                    retcode = Start(buffer, numBuffered);
+                    isStarted = RTN_OK == retcode;
+                }
+
+                if (RTN_OK == retcode && isStarted)
+                {
+                    retcode = ApplyChanges(buffer, numBuffered);
+                }
+
+                if (RTN_OK != retcode)
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    m_Retcode = RTN_TIMEOUT == retcode ? RTN_OK : retcode;
+                    return;
+                }
+            }
+        }
+
+        /*
+         * Read what arrived into the buffer. Returns RTN_TIMEOUT once the
+         * replica is stopping.
+         */
+        RETCODE Receive(std::vector<char>& buffer, size_t& numBuffered)
+        {
+            for (;;)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    if (m_IsStopping)
+                    {
+                        return RTN_TIMEOUT;
+                    }
+                }
+
+                pollfd pollFD = { m_FD, POLLIN, 0 };
+                int numReady = poll(&pollFD, 1, static_cast<int>(STOP_CHECK_INTERVAL.count()));
+                if (0 > numReady && EINTR != errno)
+                {
+                    return RTN_CONNECTION_FAIL;
+                }
+
+                if (0 >= numReady)
+                {
+                    continue;
+                }
+
+                ssize_t numRead = read(m_FD, buffer.data() + numBuffered, buffer.size() - numBuffered);
+                if (0 > numRead && EINTR == errno)
+                {
+                    continue;
+                }
+
+                if (0 == numRead)
+                {
+                    return RTN_EOF;
+                }
+
+                if (0 > numRead)
+                {
+                    return RTN_CONNECTION_FAIL;
+                }
+
+                numBuffered += numRead;
+                return RTN_OK;
+            }
+        }
+
+        RETCODE Start(std::vector<char>& buffer, size_t& numBuffered)
+        {
+            STREAM_HEADER streamHeader;
+            memcpy(&streamHeader, buffer.data(), sizeof(streamHeader));
+            if (0 != strncmp(streamHeader.objectName, Reflection<object>::OBJECT_NAME, sizeof(streamHeader.objectName)) ||
+                sizeof(object) != streamHeader.recordSize ||
+                m_DB.NumberOfRecords() != streamHeader.numRecords)
+            {
+                return RTN_BAD_ARG;
+            }
+
+            numBuffered -= sizeof(streamHeader);
+            memmove(buffer.data(), buffer.data() + sizeof(streamHeader), numBuffered);
+            return RTN_OK;
+        }
+
+        /*
+         * Apply every whole change in the buffer and keep the rest, growing
+         * the buffer if a single change does not fit.
+         */
+        RETCODE ApplyChanges(std::vector<char>& buffer, size_t& numBuffered)
+        {
+            size_t end = 0;
+            uint64_t receivedSequence = 0;
+            while (sizeof(CHANGE_HEADER) <= numBuffered - end)
+            {
+                CHANGE_HEADER change;
+                memcpy(&change, buffer.data() + end, sizeof(change));
+                if (!IsValid(change))
+                {
+                    return RTN_CORRUPT;
+                }
+
+                size_t changeSize = ChangeSize(change);
+                if (changeSize > numBuffered - end)
+                {
+                    break;
+                }
+
+                receivedSequence = change.sequence;
+                end += changeSize;
+            }
+
+            if (end)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    m_Status.receivedSequence = receivedSequence;
+                }
+
+                RETCODE retcode = ApplyBatch(buffer.data(), end);
+                if (RTN_OK != retcode)
+                {
+                    return retcode;
+                }
+
+                numBuffered -= end;
+                memmove(buffer.data(), buffer.data() + end, numBuffered);
+            }
+
+            if (sizeof(CHANGE_HEADER) <= numBuffered)
+            {
+                CHANGE_HEADER change;
+                memcpy(&change, buffer.data(), sizeof(change));
+                if (!IsValid(change))
+                {
+                    return RTN_CORRUPT;
+                }
+
+                size_t changeSize = ChangeSize(change);
+                if (changeSize > buffer.size())
+                {
+                    buffer.resize(changeSize);
+                }
+            }
+
+            return RTN_OK;
+        }
+
+        /*
+         * Whether a change from the source is of a known type and its records
+         * are in the table, checked before the buffer grows to hold it.
+         */
+        bool IsValid(const CHANGE_HEADER& change)
+        {
+            switch (static_cast<CHANGE_TYPE>(change.type))
+            {
+                case CHANGE_TYPE::RECORDS:
+                {
+                    size_t numRecords = m_DB.NumberOfRecords();
+                    return change.firstRecord <= numRecords && change.numRecords <= numRecords - change.firstRecord;
+                }
+                case CHANGE_TYPE::CLEAR:
+                case CHANGE_TYPE::SYNCHRONIZED:
+                case CHANGE_TYPE::HEARTBEAT:
+                {
+                    return true;
+                }
+                default:
+                {
+                    return false;
+                }
+            }
+        }
+
+        static size_t ChangeSize(const CHANGE_HEADER& change)
+        {
+            return sizeof(change) + (static_cast<uint32_t>(CHANGE_TYPE::RECORDS) == change.type ? change.numRecords * sizeof(object) : 0);
+        }
+
+        RETCODE ApplyBatch(const char* p_changes, size_t length)
+        {
+            static const object deletedObject = { 0 };
+            uint64_t sequence = AppliedSequence();
+            int64_t timestamp = 0;
+            bool isSynchronized = false;
+            size_t numWrites = 0;
+            size_t numDeletes = 0;
+
+            RETCODE retcode = m_DB.LockDB(DB_OPERATION::WRITE_BATCH);
+            if (RTN_OK != retcode)
+            {
+                return retcode;
+            }
+
+            for (size_t offset = 0; offset < length && RTN_OK == retcode;)
+            {
+                CHANGE_HEADER change;
+                memcpy(&change, p_changes + offset, sizeof(change));
+                offset += sizeof(change);
+                timestamp = change.timestamp;
+
+                CHANGE_TYPE type = static_cast<CHANGE_TYPE>(change.type);
+                if (CHANGE_TYPE::RECORDS == type || CHANGE_TYPE::CLEAR == type)
+                {
+                    if (sequence + 1 != change.sequence)
+                    {
+                        retcode = RTN_CORRUPT;
+                        break;
+                    }
+
+                    sequence = change.sequence;
+                }
+
+                if (CHANGE_TYPE::RECORDS == type)
+                {
+                    if (!IsValid(change))
+                    {
+                        retcode = RTN_CORRUPT;
+                        break;
+                    }
+
+                    for (size_t record = change.firstRecord; record < change.firstRecord + change.numRecords; record++)
+                    {
+                        // The payload is not aligned for object
+                        object image;
+                        memcpy(&image, p_changes + offset, sizeof(object));
+                        offset += sizeof(object);
+
+                        if (0 == memcmp(&image, &deletedObject, sizeof(object)))
+                        {
+                            m_DB.DeleteRecord(m_DB.Get(record), record);
+                            numDeletes++;
+                        }
+                        else
+                        {
+                            m_DB.WriteRecord(m_DB.Get(record), record, image);
+                            numWrites++;
+                        }
+                    }
+                }
+                else if (CHANGE_TYPE::CLEAR == type)
+                {
+                    // Clear takes the lock itself
+                    retcode = m_DB.UnlockDB(DB_OPERATION::WRITE_BATCH);
+                    retcode = RTN_OK == retcode ? m_DB.Clear() : retcode;
+                    retcode = RTN_OK == retcode ? m_DB.LockDB(DB_OPERATION::WRITE_BATCH) : retcode;
+                    if (RTN_OK != retcode)
+                    {
+                        return retcode;
+                    }
+                }
+                else if (CHANGE_TYPE::SYNCHRONIZED == type)
+                {
+                    isSynchronized = true;
+                }
+                else if (CHANGE_TYPE::HEARTBEAT != type)
+                {
+                    retcode = RTN_CORRUPT;
+                }
+            }
+
+            RETCODE unlockRetcode = m_DB.UnlockDB(DB_OPERATION::WRITE_BATCH);
+            retcode = RTN_OK == retcode ? unlockRetcode : retcode;
+
+            m_DB.m_Statistics.Count(STATISTIC::WRITES, numWrites);
+            m_DB.m_Statistics.Count(STATISTIC::DELETES, numDeletes);
+            m_DB.m_Statistics.Count(STATISTIC::BYTES_COPIED, numWrites * sizeof(object));
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Status.appliedSequence = sequence;
+            m_Status.isSynchronized = m_Status.isSynchronized || isSynchronized;
+            m_LastTimestamp = timestamp;
+            return retcode;
+        }
+
+        uint64_t AppliedSequence(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Status.appliedSequence;
+        }
+
+        // Bytes of changes applied per write lock acquisition, bigger changes grow it
+        static constexpr size_t APPLY_BATCH_BYTES = 1024 * 1024;
+
+        static constexpr std::chrono::milliseconds STOP_CHECK_INTERVAL = std::chrono::milliseconds(100);
+
+        DBType& m_DB;
+        int m_FD;
+        REPLICATION_STATUS m_Status;
+        int64_t m_LastTimestamp;
+        RETCODE m_Retcode;
+        std::mutex m_Mutex;
+        bool m_IsStopping;
+        std::thread m_Applier;
+    };
+}
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef __QC_DB_SCRUBBER_HH
+#define __QC_DB_SCRUBBER_HH
+
+#include <common/OSdefines.hh>
+#include <common/Retcode.hh>
+#include <qcDB/qcDB.hh>
+
+#include <vector>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+#ifndef WINDOWS_PLATFORM
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace qcDB
+{
+    /*
+     * Checks a table generated with checksums against them in the
+     * background, pass after pass, to find silent corruption early.
+     *
+     *     qcDB::dbScrubber scrubber(people, 64 * 1024 * 1024);
+     *
+     * The thread runs at idle priority and reads at most bytesPerSecond of
+     * records, 0 for no limit. It takes the read lock for SCRUB_BATCH_BLOCKS
+     * blocks at a time so writers only wait for one batch. Corrupt blocks
+     * are kept in CorruptBlocks and passed to the handler, once per pass
+     * they are found in, on the scrubber thread.
+     */
+    template <class object, class LockPolicy = ProcessSharedLock, class BoundsPolicy = BoundsChecked>
+    class dbScrubber
+    {
+    public:
+
+        using DBType = dbInterface<object, LockPolicy, BoundsPolicy>;
+        using CorruptionHandler = std::function<void(size_t block)>;
+
+        dbScrubber(DBType& db, size_t bytesPerSecond, CorruptionHandler handler = nullptr) :
+            m_DB(db), m_BytesPerSecond(bytesPerSecond), m_Handler(std::move(handler)),
+            m_NumPasses(0), m_Retcode(RTN_OK), m_IsStopping(false)
+        {
+            m_Scrubber = std::thread(&dbScrubber::Scrub, this);
+        }
+
+        ~dbScrubber(void)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_IsStopping = true;
+            }
+
+            m_Stop.notify_one();
+            m_Scrubber.join();
+        }
+
+        dbScrubber(dbScrubber const&) = delete;
+        void operator = (dbScrubber const&) = delete;
+
+        /*
+         * Complete passes over the table so far.
+         */
+        size_t NumberOfPasses(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_NumPasses;
+        }
+
+        /*
+         * Every block found corrupt so far, in block order.
+         */
+        std::vector<size_t> CorruptBlocks(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return std::vector<size_t>(m_CorruptBlocks.begin(), m_CorruptBlocks.end());
+        }
+
+        /*
+         * RTN_NOT_FOUND if the table has no checksums, the last failure to
+         * verify otherwise.
+         */
+        RETCODE Retcode(void)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Retcode;
+        }
+
+    private:
+
+        void Scrub(void)
+        {
+            LowerPriority();
+
+            size_t numBlocks = m_DB.NumberOfChecksumBlocks();
+            if (0 == numBlocks)
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Retcode = RTN_NOT_FOUND;
+                return;
+            }
+
+            std::chrono::duration<double> batchTime(0);
+            if (m_BytesPerSecond)
+            {
+                batchTime = std::chrono::duration<double>(static_cast<double>(SCRUB_BATCH_BLOCKS * CHECKSUM_BLOCK_SIZE) / m_BytesPerSecond);
+            }
+
+            std::vector<size_t> corruptBlocks;
+            size_t block = 0;
+            std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+            for (;;)
+            {
+                corruptBlocks.clear();
+                RETCODE retcode = m_DB.VerifyChecksums(block, SCRUB_BATCH_BLOCKS, corruptBlocks);
+                for (size_t corruptBlock : corruptBlocks)
+                {
+                    if (m_Handler)
+                    {
+                        m_Handler(corruptBlock);
+                    }
+                }
+
+                block += SCRUB_BATCH_BLOCKS;
+
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_CorruptBlocks.insert(corruptBlocks.begin(), corruptBlocks.end());
+                m_Retcode = RTN_OK == retcode ? m_Retcode : retcode;
+                if (numBlocks <= block)
+                {
+                    block = 0;
+                    m_NumPasses++;
+                }
+
+                // Time lost to other threads is not made up in a burst
+                next = std::max(next + std::chrono::duration_cast<std::chrono::steady_clock::duration>(batchTime),
+                    std::chrono::steady_clock::now());
+                if (m_Stop.wait_until(lock, next, [this] { return m_IsStopping; }))
+                {
+                    return;
+                }
+            }
+        }
+
+        static void LowerPriority(void)
+        {
+#ifdef WINDOWS_PLATFORM
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+#else
+            sched_param parameters = { 0 };
+            pthread_setschedparam(pthread_self(), SCHED_IDLE, &parameters);
+#endif
+        }
+
+        // Blocks verified per lock acquisition
+        static constexpr size_t SCRUB_BATCH_BLOCKS = 64;
+
+        DBType& m_DB;
+        size_t m_BytesPerSecond;
+        CorruptionHandler m_Handler;
+        size_t m_NumPasses;
+        std::set<size_t> m_CorruptBlocks;
+        RETCODE m_Retcode;
+        std::mutex m_Mutex;
+        std::condition_variable m_Stop;
+        bool m_IsStopping;
+        std::thread m_Scrubber;
+    };
+}
+
+#endif
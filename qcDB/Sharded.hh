@@ -0,0 +1,360 @@
+#ifndef __QC_DB_SHARDED_HH
+#define __QC_DB_SHARDED_HH
+
+#include <common/Retcode.hh>
+#include <common/DBHeader.hh>
+#include <qcDB/qcDB.hh>
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <memory>
+#include <thread>
+
+namespace qcDB
+{
+    /*
+     * Where a record of a sharded table lives.
+     */
+    struct SHARD_RECORD
+    {
+        size_t shard;
+        size_t record;
+    };
+
+    /*
+     * Shard policies map a table record to a shard and a record in it and back.
+     * Every shard has shardRecords records, the last records of some shards
+     * are padding when the table does not split evenly.
+     */
+
+    /*
+     * Consecutive blocks of records per shard, scans of a record range stay
+     * on few shards.
+     */
+    struct RangeSharding
+    {
+        static SHARD_RECORD Locate(size_t record, size_t numShards, size_t shardRecords)
+        {
+            return SHARD_RECORD{ record / shardRecords, record % shardRecords };
+        }
+
+        static size_t Record(const SHARD_RECORD& location, size_t numShards, size_t shardRecords)
+        {
+            return location.shard * shardRecords + location.record;
+        }
+    };
+
+    /*
+     * Records spread by their record number modulo the number of shards, so
+     * neighbouring hot records contend on different locks.
+     */
+    struct HashSharding
+    {
+        static SHARD_RECORD Locate(size_t record, size_t numShards, size_t shardRecords)
+        {
+            return SHARD_RECORD{ record % numShards, record / numShards };
+        }
+
+        static size_t Record(const SHARD_RECORD& location, size_t numShards, size_t shardRecords)
+        {
+            return location.record * numShards + location.shard;
+        }
+    };
+
+    /*
+     * One table split across several files generated with dbGenerator --shards.
+     * Each shard is a dbInterface with its own mapping and lock, so writers
+     * to different shards do not contend and shards can live on different
+     * disks. Record operations go to the one shard owning the record, finds
+     * run on every shard in parallel.
+     *
+     * Batches are only atomic per shard.
+     */
+    template <class object, class ShardPolicy = RangeSharding, class LockPolicy = ProcessSharedLock, class BoundsPolicy = BoundsChecked>
+    class dbShardedInterface
+    {
+    public:
+
+        using ShardType = dbInterface<object, LockPolicy, BoundsPolicy>;
+        using Predicate = typename ShardType::Predicate;
+
+        /*
+         * Open the shards dbGenerator created for dbPath, see ShardFilePath.
+         */
+        dbShardedInterface(const std::string& dbPath, size_t numShards) :
+            dbShardedInterface(ShardFilePaths(dbPath, numShards))
+        {
+        }
+
+        /*
+         * Open shards moved to other places, in shard order. The shards must
+         * split the number of records of the schema, see ShardNumRecords.
+         */
+        explicit dbShardedInterface(const std::vector<std::string>& shardPaths) :
+            m_IsOpen(false), m_NumRecords(Reflection<object>::NUM_RECORDS), m_ShardRecords(0)
+        {
+            for (const std::string& shardPath : shardPaths)
+            {
+                m_Shards.emplace_back(new ShardType(shardPath));
+                size_t numRecords = m_Shards.back()->NumberOfRecords();
+                if (0 == numRecords || (m_ShardRecords && m_ShardRecords != numRecords))
+                {
+                    return;
+                }
+
+                m_ShardRecords = numRecords;
+            }
+
+            m_IsOpen = !m_Shards.empty() && ShardNumRecords(m_NumRecords, m_Shards.size()) == m_ShardRecords;
+        }
+
+        dbShardedInterface(dbShardedInterface const&) = delete;
+        void operator = (dbShardedInterface const&) = delete;
+
+        RETCODE ReadObject(size_t record, object& out_object)
+        {
+            SHARD_RECORD location;
+            return Locate(record, location) ? m_Shards[location.shard]->ReadObject(location.record, out_object) : RTN_NULL_OBJ;
+        }
+
+        RETCODE ReadObject(size_t record, object& out_object, RECORD_VERSION& out_version)
+        {
+            SHARD_RECORD location;
+            return Locate(record, location) ? m_Shards[location.shard]->ReadObject(location.record, out_object, out_version) : RTN_NULL_OBJ;
+        }
+
+        RETCODE WriteObject(size_t record, object& objectWrite)
+        {
+            SHARD_RECORD location;
+            return Locate(record, location) ? m_Shards[location.shard]->WriteObject(location.record, objectWrite) : RTN_NULL_OBJ;
+        }
+
+        RETCODE CompareAndWrite(size_t record, RECORD_VERSION expectedVersion, const object& objectWrite)
+        {
+            SHARD_RECORD location;
+            return Locate(record, location) ? m_Shards[location.shard]->CompareAndWrite(location.record, expectedVersion, objectWrite) : RTN_NULL_OBJ;
+        }
+
+        RETCODE ReadVersion(size_t record, RECORD_VERSION& out_version)
+        {
+            SHARD_RECORD location;
+            return Locate(record, location) ? m_Shards[location.shard]->ReadVersion(location.record, out_version) : RTN_NULL_OBJ;
+        }
+
+        RETCODE DeleteObject(size_t record)
+        {
+            SHARD_RECORD location;
+            return Locate(record, location) ? m_Shards[location.shard]->DeleteObject(location.record) : RTN_NULL_OBJ;
+        }
+
+        /*
+         * Read several objects given a vector of tuples <record, empty object>,
+         * one batch per shard.
+         */
+        RETCODE ReadObjects(std::vector<std::tuple<size_t, object>>& objects)
+        {
+            return RunPerShard(objects, true);
+        }
+
+        /*
+         * Write several objects given a vector of tuples <record, object data>,
+         * one batch per shard. A bad record fails before anything is written.
+         */
+        RETCODE WriteObjects(std::vector<std::tuple<size_t, object>>& objects)
+        {
+            return RunPerShard(objects, false);
+        }
+
+        /*
+         * The lowest record matching the predicate, every shard is searched
+         * in parallel.
+         */
+        RETCODE FindFirstOf(Predicate predicate, size_t& out_Record)
+        {
+            std::vector<size_t> records(m_Shards.size(), 0);
+            std::vector<RETCODE> retcodes(m_Shards.size(), RTN_NOT_FOUND);
+            ForEachShard([&](size_t shard)
+            {
+                retcodes[shard] = m_Shards[shard]->FindFirstOf(predicate, records[shard]);
+            });
+
+            bool isFound = false;
+            for (size_t shard = 0; shard < m_Shards.size(); shard++)
+            {
+                if (RTN_OK == retcodes[shard])
+                {
+                    size_t record = ShardPolicy::Record(SHARD_RECORD{ shard, records[shard] }, m_Shards.size(), m_ShardRecords);
+                    out_Record = isFound ? std::min(out_Record, record) : record;
+                    isFound = true;
+                }
+                else if (RTN_NOT_FOUND != retcodes[shard])
+                {
+                    return retcodes[shard];
+                }
+            }
+
+            return isFound ? RTN_OK : RTN_NOT_FOUND;
+        }
+
+        /*
+         * Objects matching the predicate from every shard, searched in
+         * parallel and appended in shard order.
+         */
+        RETCODE FindObjects(Predicate predicate, std::vector<object>& out_MatchingObjects)
+        {
+            std::vector<std::vector<object>> matches(m_Shards.size());
+            std::vector<RETCODE> retcodes(m_Shards.size(), RTN_OK);
+            ForEachShard([&](size_t shard)
+            {
+                retcodes[shard] = m_Shards[shard]->FindObjects(predicate, matches[shard]);
+            });
+
+            for (size_t shard = 0; shard < m_Shards.size(); shard++)
+            {
+                if (RTN_OK != retcodes[shard])
+                {
+                    return retcodes[shard];
+                }
+
+                out_MatchingObjects.insert(out_MatchingObjects.end(), matches[shard].begin(), matches[shard].end());
+            }
+
+            return RTN_OK;
+        }
+
+        RETCODE Clear(void)
+        {
+            RETCODE retcode = RTN_OK;
+            for (std::unique_ptr<ShardType>& shard : m_Shards)
+            {
+                RETCODE shardRetcode = shard->Clear();
+                retcode = RTN_OK == retcode ? shardRetcode : retcode;
+            }
+
+            return retcode;
+        }
+
+        /*
+         * Number of records of the table, without the padding of the shards.
+         */
+        inline size_t NumberOfRecords(void)
+        {
+            return m_IsOpen ? m_NumRecords : 0;
+        }
+
+        inline size_t NumberOfShards(void)
+        {
+            return m_IsOpen ? m_Shards.size() : 0;
+        }
+
+        /*
+         * Direct access to one shard, records are shard records.
+         */
+        ShardType& Shard(size_t shard)
+        {
+            return *m_Shards.at(shard);
+        }
+
+    private:
+
+        static std::vector<std::string> ShardFilePaths(const std::string& dbPath, size_t numShards)
+        {
+            std::vector<std::string> shardPaths;
+            for (size_t shard = 0; shard < numShards; shard++)
+            {
+                shardPaths.push_back(ShardFilePath(dbPath, shard));
+            }
+
+            return shardPaths;
+        }
+
+        bool Locate(size_t record, SHARD_RECORD& out_location)
+        {
+            if (!m_IsOpen || NumberOfRecords() <= record)
+            {
+                return false;
+            }
+
+            out_location = ShardPolicy::Locate(record, m_Shards.size(), m_ShardRecords);
+            return true;
+        }
+
+        template <typename Function>
+        void ForEachShard(Function&& function)
+        {
+            if (!m_IsOpen)
+            {
+                return;
+            }
+
+            std::vector<std::thread> threads;
+            for (size_t shard = 1; shard < m_Shards.size(); shard++)
+            {
+                threads.emplace_back(function, shard);
+            }
+
+            function(0);
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        RETCODE RunPerShard(std::vector<std::tuple<size_t, object>>& objects, bool isRead)
+        {
+            std::vector<std::vector<std::tuple<size_t, object>>> shardObjects(m_Shards.size());
+            std::vector<std::vector<size_t>> positions(m_Shards.size());
+            for (size_t position = 0; position < objects.size(); position++)
+            {
+                SHARD_RECORD location;
+                if (!Locate(std::get<0>(objects[position]), location))
+                {
+                    return RTN_NULL_OBJ;
+                }
+
+                shardObjects[location.shard].emplace_back(location.record, std::get<1>(objects[position]));
+                positions[location.shard].push_back(position);
+            }
+
+            for (size_t shard = 0; shard < m_Shards.size(); shard++)
+            {
+                if (shardObjects[shard].empty())
+                {
+                    continue;
+                }
+
+                RETCODE retcode = isRead ? m_Shards[shard]->ReadObjects(shardObjects[shard]) : m_Shards[shard]->WriteObjects(shardObjects[shard]);
+                if (RTN_OK != retcode)
+                {
+                    return retcode;
+                }
+
+                if (!isRead)
+                {
+                    continue;
+                }
+
+                // ReadObjects sorts by record, match the results back by record
+                std::sort(positions[shard].begin(), positions[shard].end(), [&](size_t left, size_t right)
+                {
+                    return std::get<0>(objects[left]) < std::get<0>(objects[right]);
+                });
+
+                for (size_t result = 0; result < positions[shard].size(); result++)
+                {
+                    std::get<1>(objects[positions[shard][result]]) = std::get<1>(shardObjects[shard][result]);
+                }
+            }
+
+            return RTN_OK;
+        }
+
+        bool m_IsOpen;
+        size_t m_NumRecords;
+        size_t m_ShardRecords;
+        std::vector<std::unique_ptr<ShardType>> m_Shards;
+    };
+}
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef __QC_DB_STATISTICS_HH
+#define __QC_DB_STATISTICS_HH
+
+#include <common/OSdefines.hh>
+#include <common/Retcode.hh>
+#include <common/Constants.hh>
+#include <common/Logger.hh>
+#include <common/Histogram.hh>
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <atomic>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifndef WINDOWS_PLATFORM
+#include <sys/mman.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace qcDB
+{
+    /*
+     * Operation counters kept for every database.
+     */
+    enum class STATISTIC : size_t
+    {
+        READS = 0,
+        WRITES,
+        DELETES,
+        SCANS,
+        RECORDS_SCANNED,
+        BYTES_COPIED,
+        LOCK_ACQUISITIONS,
+        NUM_STATISTICS
+    };
+
+    constexpr size_t NUM_STATISTICS = static_cast<size_t>(STATISTIC::NUM_STATISTICS);
+
+    /*
+     * dbInterface operations that take the DB lock.
+     */
+    enum class DB_OPERATION : size_t
+    {
+        READ = 0,
+        READ_BATCH,
+        WRITE,
+        APPEND,
+        WRITE_BATCH,
+        APPEND_BATCH,
+        DELETE_RECORD,
+        CLEAR,
+        FIND_FIRST,
+        FIND,
+        LAST_WRITTEN,
+        COMPACT,
+        REBUILD_BLOOM,
+        VERIFY,
+        // The field operations, exclusive on tables with checksums
+        FIELD,
+        // The field operations on tables without checksums, they only keep out writes
+        FIELD_SHARED,
+        NUM_DB_OPERATIONS
+    };
+
+    constexpr size_t NUM_DB_OPERATIONS = static_cast<size_t>(DB_OPERATION::NUM_DB_OPERATIONS);
+
+    /*
+     * Operations that only need the shared (read) side of the DB lock.
+     */
+    inline bool IsReadOperation(DB_OPERATION operation)
+    {
+        switch (operation)
+        {
+            case DB_OPERATION::READ:
+            case DB_OPERATION::READ_BATCH:
+            case DB_OPERATION::FIND_FIRST:
+            case DB_OPERATION::FIND:
+            case DB_OPERATION::LAST_WRITTEN:
+            case DB_OPERATION::VERIFY:
+            case DB_OPERATION::FIELD_SHARED:
+            {
+                return true;
+            }
+            default:
+            {
+                return false;
+            }
+        }
+    }
+
+    /*
+     * Lock wait and hold times in nanoseconds. Four sub-buckets per power
+     * of two keeps the whole set of histograms small enough for the sidecar.
+     */
+    using LockHistogram = Histogram<2>;
+
+    // One failure counter per RETCODE bit, RTN_FAIL through RTN_CORRUPT
+    constexpr size_t NUM_RETCODES = 11;
+
+    constexpr size_t NUM_STATS_SLOTS = 64;
+
+    constexpr uint64_t STATS_MAGIC = 0x5354415453424451; // "QDBSTATS"
+
+    /*
+     * Counters of a single process. Padded to a cache line so processes
+     * never write to the same line.
+     */
+    struct alignas(CONSTANTS::CACHE_LINE_SIZE) DBStatsSlot
+    {
+        int64_t m_ProcessID;
+        uint64_t m_Counters[NUM_STATISTICS];
+        uint64_t m_Failures[NUM_RETCODES];
+    };
+
+    /*
+     * Layout of the <database>.stats sidecar file. A zero filled file is a
+     * valid empty region so it needs no initialization beyond the magic.
+     */
+    struct DBStats
+    {
+        alignas(CONSTANTS::CACHE_LINE_SIZE) uint64_t m_Magic;
+        uint64_t m_NumSlots;
+
+        // Counters folded in from processes that have exited
+        DBStatsSlot m_Retired;
+        DBStatsSlot m_Slots[NUM_STATS_SLOTS];
+
+        // Only recorded when built with QCDB_LOCK_TIMING
+        alignas(CONSTANTS::CACHE_LINE_SIZE) LockHistogram m_LockWait[NUM_DB_OPERATIONS];
+        alignas(CONSTANTS::CACHE_LINE_SIZE) LockHistogram m_LockHold[NUM_DB_OPERATIONS];
+    };
+
+    inline const char* StatisticName(size_t statistic)
+    {
+        static const char* STATISTIC_NAMES[NUM_STATISTICS] =
+        {
+            "reads",
+            "writes",
+            "deletes",
+            "scans",
+            "recordsScanned",
+            "bytesCopied",
+            "lockAcquisitions"
+        };
+
+        return STATISTIC_NAMES[statistic];
+    }
+
+    inline const char* OperationName(size_t operation)
+    {
+        static const char* OPERATION_NAMES[NUM_DB_OPERATIONS] =
+        {
+            "read",
+            "readBatch",
+            "write",
+            "append",
+            "writeBatch",
+            "appendBatch",
+            "delete",
+            "clear",
+            "findFirst",
+            "find",
+            "lastWritten",
+            "compact",
+            "rebuildBloom",
+            "verify",
+            "field",
+            "fieldShared"
+        };
+
+        return OPERATION_NAMES[operation];
+    }
+
+    /*
+     * Bit position of a failing RETCODE, used to index m_Failures.
+     */
+    inline size_t RetcodeIndex(RETCODE retcode)
+    {
+        size_t index = 0;
+        while (retcode > 1 && index < NUM_RETCODES - 1)
+        {
+            retcode >>= 1;
+            index++;
+        }
+
+        return index;
+    }
+
+    /*
+     * Counts the forks this process came out of. A slot claimed before it
+     * changed belongs to the parent.
+     */
+    inline std::atomic<uint64_t>& ForkGeneration(void)
+    {
+        static std::atomic<uint64_t> forkGeneration(0);
+        return forkGeneration;
+    }
+
+    /*
+     * Attaches to the statistics sidecar of a database and hands out the
+     * slot owned by this process, claiming another one after a fork.
+     */
+    class dbStatistics
+    {
+public:
+
+        dbStatistics(void) :
+            m_Stats(nullptr), m_Slot(nullptr), m_ForkGeneration(0)
+        {
+        }
+
+        ~dbStatistics(void)
+        {
+#ifndef WINDOWS_PLATFORM
+            if (nullptr != m_Stats)
+            {
+                munmap(m_Stats, sizeof(DBStats));
+            }
+#endif
+        }
+
+        dbStatistics(dbStatistics const&) = delete;
+        void operator = (dbStatistics const&) = delete;
+
+        /*
+         * Map the sidecar of the given database. Writers create it if needed
+         * and claim a slot, readers (e.g. dbStats) only map it.
+         */
+        RETCODE Attach(const std::string& dbPath, bool isWriter)
+        {
+#if defined(WINDOWS_PLATFORM) || defined(QCDB_DISABLE_STATISTICS)
+            return RTN_NOT_FOUND;
+#else
+            std::string statsPath = dbPath + CONSTANTS::STATS_EXT;
+            int fd = -1;
+            if (isWriter)
+            {
+                fd = open(statsPath.c_str(), O_RDWR | O_CREAT, CONSTANTS::RW);
+            }
+            else
+            {
+                fd = open(statsPath.c_str(), O_RDWR);
+            }
+
+            if (0 > fd)
+            {
+                return RTN_NOT_FOUND;
+            }
+
+            struct stat statbuf;
+            if (0 > fstat(fd, &statbuf))
+            {
+                close(fd);
+                return RTN_NOT_FOUND;
+            }
+
+            // Every attaching process truncates to the same size so racing creators agree
+            if (0 == statbuf.st_size && isWriter)
+            {
+                if (ftruncate(fd, sizeof(DBStats)))
+                {
+                    close(fd);
+                    return RTN_MALLOC_FAIL;
+                }
+            }
+            else if (sizeof(DBStats) != static_cast<size_t>(statbuf.st_size))
+            {
+                LOG_WARN("Ignoring ", statsPath, " since it is ", statbuf.st_size, " bytes instead of ", sizeof(DBStats));
+                close(fd);
+                return RTN_BAD_ARG;
+            }
+
+            void* address = mmap(nullptr, sizeof(DBStats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (MAP_FAILED == address)
+            {
+                return RTN_MALLOC_FAIL;
+            }
+
+            m_Stats = static_cast<DBStats*>(address);
+
+            uint64_t expected = 0;
+            __atomic_compare_exchange_n(&m_Stats->m_Magic, &expected, STATS_MAGIC, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+            if (STATS_MAGIC != __atomic_load_n(&m_Stats->m_Magic, __ATOMIC_ACQUIRE))
+            {
+                LOG_WARN("Ignoring ", statsPath, " since it is not a statistics file");
+                munmap(m_Stats, sizeof(DBStats));
+                m_Stats = nullptr;
+                return RTN_BAD_ARG;
+            }
+
+            m_Stats->m_NumSlots = NUM_STATS_SLOTS;
+
+            if (isWriter)
+            {
+                static bool isForkHandlerSet = (0 == pthread_atfork(nullptr, nullptr, &dbStatistics::AfterFork));
+                (void)isForkHandlerSet;
+                m_ForkGeneration.store(ForkGeneration().load(std::memory_order_acquire), std::memory_order_relaxed);
+                m_Slot.store(ClaimSlot(), std::memory_order_release);
+            }
+
+            return RTN_OK;
+#endif
+        }
+
+        inline void Count(STATISTIC statistic, uint64_t amount = 1)
+        {
+            DBStatsSlot* slot = Slot();
+            if (nullptr != slot)
+            {
+                __atomic_fetch_add(&slot->m_Counters[static_cast<size_t>(statistic)], amount, __ATOMIC_RELAXED);
+            }
+        }
+
+        /*
+         * Count a failed operation and pass its RETCODE through.
+         */
+        inline RETCODE Failure(RETCODE retcode)
+        {
+            DBStatsSlot* slot = Slot();
+            if (nullptr != slot && RTN_OK != retcode)
+            {
+                __atomic_fetch_add(&slot->m_Failures[RetcodeIndex(retcode)], 1, __ATOMIC_RELAXED);
+            }
+
+            return retcode;
+        }
+
+        inline void RecordLockWait(DB_OPERATION operation, uint64_t nanoseconds)
+        {
+            if (nullptr != m_Stats)
+            {
+                m_Stats->m_LockWait[static_cast<size_t>(operation)].AtomicRecord(nanoseconds);
+            }
+        }
+
+        inline void RecordLockHold(DB_OPERATION operation, uint64_t nanoseconds)
+        {
+            if (nullptr != m_Stats)
+            {
+                m_Stats->m_LockHold[static_cast<size_t>(operation)].AtomicRecord(nanoseconds);
+            }
+        }
+
+        const DBStats* Stats(void) const
+        {
+            return m_Stats;
+        }
+
+private:
+
+        /*
+         * The slot of this process, a child counting into the slot of its
+         * parent would make both counts wrong.
+         */
+        inline DBStatsSlot* Slot(void)
+        {
+            DBStatsSlot* slot = m_Slot.load(std::memory_order_acquire);
+#ifndef WINDOWS_PLATFORM
+            if (nullptr != slot && m_ForkGeneration.load(std::memory_order_relaxed) != ForkGeneration().load(std::memory_order_relaxed))
+            {
+                std::lock_guard<std::mutex> lock(m_ClaimMutex);
+                uint64_t forkGeneration = ForkGeneration().load(std::memory_order_acquire);
+                if (m_ForkGeneration.load(std::memory_order_relaxed) != forkGeneration)
+                {
+                    m_Slot.store(ClaimSlot(), std::memory_order_release);
+                    m_ForkGeneration.store(forkGeneration, std::memory_order_release);
+                }
+
+                slot = m_Slot.load(std::memory_order_acquire);
+            }
+#endif
+            return slot;
+        }
+
+#ifndef WINDOWS_PLATFORM
+        static void AfterFork(void)
+        {
+            ForkGeneration().fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        /*
+         * Reuse the slot of this process if another dbInterface already has
+         * one, otherwise take a free slot or one left behind by a dead process.
+         */
+        DBStatsSlot* ClaimSlot(void)
+        {
+            int64_t processID = getpid();
+            for (DBStatsSlot& slot : m_Stats->m_Slots)
+            {
+                if (processID == __atomic_load_n(&slot.m_ProcessID, __ATOMIC_ACQUIRE))
+                {
+                    return &slot;
+                }
+            }
+
+            for (DBStatsSlot& slot : m_Stats->m_Slots)
+            {
+                int64_t expected = 0;
+                if (__atomic_compare_exchange_n(&slot.m_ProcessID, &expected, processID, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                    return &slot;
+                }
+            }
+
+            for (DBStatsSlot& slot : m_Stats->m_Slots)
+            {
+                int64_t owner = __atomic_load_n(&slot.m_ProcessID, __ATOMIC_ACQUIRE);
+                if (0 != kill(static_cast<pid_t>(owner), 0) && ESRCH == errno)
+                {
+                    if (__atomic_compare_exchange_n(&slot.m_ProcessID, &owner, processID, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                    {
+                        Retire(slot);
+                        return &slot;
+                    }
+                }
+            }
+
+            // Every slot belongs to a live process, share the retired slot
+            return &m_Stats->m_Retired;
+        }
+
+        void Retire(DBStatsSlot& slot)
+        {
+            for (size_t statistic = 0; statistic < NUM_STATISTICS; statistic++)
+            {
+                uint64_t count = __atomic_exchange_n(&slot.m_Counters[statistic], 0, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&m_Stats->m_Retired.m_Counters[statistic], count, __ATOMIC_RELAXED);
+            }
+
+            for (size_t failure = 0; failure < NUM_RETCODES; failure++)
+            {
+                uint64_t count = __atomic_exchange_n(&slot.m_Failures[failure], 0, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&m_Stats->m_Retired.m_Failures[failure], count, __ATOMIC_RELAXED);
+            }
+        }
+#endif
+
+        DBStats* m_Stats;
+        std::atomic<DBStatsSlot*> m_Slot;
+        std::atomic<uint64_t> m_ForkGeneration;
+        std::mutex m_ClaimMutex;
+    };
+}
+
+#endif
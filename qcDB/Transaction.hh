@@ -0,0 +1,326 @@
+#ifndef __QC_DB_TRANSACTION_HH
+#define __QC_DB_TRANSACTION_HH
+
+#include <common/Retcode.hh>
+#include <common/DBHeader.hh>
+#include <qcDB/qcDB.hh>
+
+#include <vector>
+#include <tuple>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+
+namespace qcDB
+{
+    /*
+     * Staged writes to one table of a transaction.
+     */
+    class TransactionTableBase
+    {
+    public:
+
+        virtual ~TransactionTableBase(void) = default;
+
+        virtual const void* Database(void) const = 0;
+        virtual FILE_IDENTITY FileIdentity(void) const = 0;
+        virtual RETCODE Lock(void) = 0;
+        virtual RETCODE Unlock(void) = 0;
+        virtual RETCODE Apply(void) = 0;
+        virtual void Rollback(void) = 0;
+        virtual void Finish(bool isCommitted) = 0;
+    };
+
+    template <class object, class LockPolicy, class BoundsPolicy>
+    class TransactionTable : public TransactionTableBase
+    {
+    public:
+
+        using DBType = dbInterface<object, LockPolicy, BoundsPolicy>;
+
+        explicit TransactionTable(DBType& db) :
+            m_DB(db), m_LastWritten(0), m_Size(0)
+        {
+        }
+
+        RETCODE Stage(size_t record, const object* p_object)
+        {
+            if (nullptr == m_DB.Get(record))
+            {
+                return RTN_NULL_OBJ;
+            }
+
+            REDO_ENTRY entry = { record, p_object != nullptr, { 0 } };
+            if (entry.isWrite)
+            {
+                memcpy(&entry.image, p_object, sizeof(object));
+            }
+
+            m_Redo.push_back(entry);
+            return RTN_OK;
+        }
+
+        const void* Database(void) const override
+        {
+            return &m_DB;
+        }
+
+        FILE_IDENTITY FileIdentity(void) const override
+        {
+            return m_DB.m_FileIdentity;
+        }
+
+        RETCODE Lock(void) override
+        {
+            return m_DB.LockDB(DB_OPERATION::WRITE_BATCH);
+        }
+
+        RETCODE Unlock(void) override
+        {
+            return m_DB.UnlockDB(DB_OPERATION::WRITE_BATCH);
+        }
+
+        /*
+         * Save the before image of every staged record then write them in
+         * the order they were staged. The table must be locked. Nothing is
+         * written if a record is not valid.
+         */
+        RETCODE Apply(void) override
+        {
+            for (const REDO_ENTRY& entry : m_Redo)
+            {
+                if (nullptr == m_DB.Get(entry.record))
+                {
+                    return RTN_NULL_OBJ;
+                }
+            }
+
+            DBHeader* header = reinterpret_cast<DBHeader*>(m_DB.m_DBAddress);
+            m_LastWritten = header->m_LastWritten;
+            m_Size = header->m_Size;
+
+            m_Undo.clear();
+            m_Undo.reserve(m_Redo.size());
+            for (const REDO_ENTRY& entry : m_Redo)
+            {
+                UNDO_ENTRY undo = { entry.record, { 0 } };
+                memcpy(&undo.image, m_DB.Get(entry.record), sizeof(object));
+                m_Undo.push_back(undo);
+            }
+
+            for (const REDO_ENTRY& entry : m_Redo)
+            {
+                if (entry.isWrite)
+                {
+                    m_DB.WriteRecord(m_DB.Get(entry.record), entry.record, entry.image);
+                }
+                else
+                {
+                    m_DB.DeleteRecord(m_DB.Get(entry.record), entry.record);
+                }
+            }
+
+            return RTN_OK;
+        }
+
+        /*
+         * Put back the before images, newest first. Versions keep counting
+         * up so nothing read from the rolled back state can be written back.
+         */
+        void Rollback(void) override
+        {
+            for (typename std::vector<UNDO_ENTRY>::reverse_iterator undo = m_Undo.rbegin(); undo != m_Undo.rend(); ++undo)
+            {
+                m_DB.StoreBytes(m_DB.Get(undo->record), &undo->image, sizeof(object));
+                m_DB.m_Store.BumpVersion(undo->record);
+            }
+
+            DBHeader* header = reinterpret_cast<DBHeader*>(m_DB.m_DBAddress);
+            header->m_LastWritten = m_LastWritten;
+            header->m_Size = m_Size;
+        }
+
+        void Finish(bool isCommitted) override
+        {
+            if (isCommitted)
+            {
+                size_t numWrites = 0;
+                for (const REDO_ENTRY& entry : m_Redo)
+                {
+                    numWrites += entry.isWrite ? 1 : 0;
+                }
+
+                m_DB.m_Statistics.Count(STATISTIC::WRITES, numWrites);
+                m_DB.m_Statistics.Count(STATISTIC::DELETES, m_Redo.size() - numWrites);
+                m_DB.m_Statistics.Count(STATISTIC::BYTES_COPIED, numWrites * sizeof(object));
+            }
+
+            m_Redo.clear();
+            m_Undo.clear();
+        }
+
+    private:
+
+        struct REDO_ENTRY
+        {
+            size_t record;
+            bool isWrite;
+            object image;
+        };
+
+        struct UNDO_ENTRY
+        {
+            size_t record;
+            object image;
+        };
+
+        DBType& m_DB;
+        std::vector<REDO_ENTRY> m_Redo;
+        std::vector<UNDO_ENTRY> m_Undo;
+        size_t m_LastWritten;
+        size_t m_Size;
+    };
+
+    /*
+     * Writes and deletes across one or more tables that are applied all
+     * together or not at all.
+     *
+     * Nothing touches the tables until Commit, which locks every table for
+     * writing (ordered by the identity of their files, which every process
+     * agrees on, so concurrent transactions can not deadlock), applies the
+     * staged changes while keeping an undo log of the records they replace,
+     * and unlocks every table on every path. Other users of the tables see
+     * all of the changes or none of them.
+     *
+     * The undo log is in memory, a crash in the middle of Commit is not
+     * rolled back. A table must only be opened once per transaction.
+     */
+    class dbTransaction
+    {
+    public:
+
+        /*
+         * Stage a write of object to record. Fails right away if the record
+         * is not valid for the table.
+         */
+        template <class object, class LockPolicy, class BoundsPolicy>
+        RETCODE Write(dbInterface<object, LockPolicy, BoundsPolicy>& db, size_t record, const object& objectWrite)
+        {
+            return Table(db).Stage(record, &objectWrite);
+        }
+
+        /*
+         * Stage a delete of record.
+         */
+        template <class object, class LockPolicy, class BoundsPolicy>
+        RETCODE Delete(dbInterface<object, LockPolicy, BoundsPolicy>& db, size_t record)
+        {
+            return Table(db).Stage(record, nullptr);
+        }
+
+        /*
+         * Apply everything staged, or nothing if a table can not be locked
+         * or a record is no longer valid. The transaction is empty afterwards.
+         */
+        RETCODE Commit(void)
+        {
+            RETCODE retcode = RTN_OK;
+
+            std::sort(m_Tables.begin(), m_Tables.end(),
+                [](const std::unique_ptr<TransactionTableBase>& left, const std::unique_ptr<TransactionTableBase>& right)
+                {
+                    FILE_IDENTITY leftFile = left->FileIdentity();
+                    FILE_IDENTITY rightFile = right->FileIdentity();
+                    return leftFile < rightFile || (leftFile == rightFile && left->Database() < right->Database());
+                });
+
+            size_t numLocked = 0;
+            for (; numLocked < m_Tables.size(); numLocked++)
+            {
+                retcode = m_Tables[numLocked]->Lock();
+                if (RTN_OK != retcode)
+                {
+                    break;
+                }
+            }
+
+            size_t numApplied = 0;
+            for (; RTN_OK == retcode && numApplied < m_Tables.size(); numApplied++)
+            {
+                retcode = m_Tables[numApplied]->Apply();
+                if (RTN_OK != retcode)
+                {
+                    break;
+                }
+            }
+
+            bool isCommitted = RTN_OK == retcode;
+            if (!isCommitted)
+            {
+                for (size_t table = numApplied; 0 < table; table--)
+                {
+                    m_Tables[table - 1]->Rollback();
+                }
+            }
+
+            // Every table that was locked is unlocked, whatever happened
+            for (size_t table = numLocked; 0 < table; table--)
+            {
+                RETCODE unlockRetcode = m_Tables[table - 1]->Unlock();
+                if (RTN_OK == retcode)
+                {
+                    retcode = unlockRetcode;
+                }
+            }
+
+            for (std::unique_ptr<TransactionTableBase>& table : m_Tables)
+            {
+                table->Finish(isCommitted);
+            }
+
+            m_Tables.clear();
+            return retcode;
+        }
+
+        /*
+         * Drop everything staged so far.
+         */
+        void Abort(void)
+        {
+            for (std::unique_ptr<TransactionTableBase>& table : m_Tables)
+            {
+                table->Finish(false);
+            }
+
+            m_Tables.clear();
+        }
+
+        ~dbTransaction(void)
+        {
+            Abort();
+        }
+
+    private:
+
+        template <class object, class LockPolicy, class BoundsPolicy>
+        TransactionTable<object, LockPolicy, BoundsPolicy>& Table(dbInterface<object, LockPolicy, BoundsPolicy>& db)
+        {
+            using Table = TransactionTable<object, LockPolicy, BoundsPolicy>;
+
+            for (std::unique_ptr<TransactionTableBase>& table : m_Tables)
+            {
+                if (table->Database() == &db)
+                {
+                    return static_cast<Table&>(*table);
+                }
+            }
+
+            m_Tables.emplace_back(new Table(db));
+            return static_cast<Table&>(*m_Tables.back());
+        }
+
+        std::vector<std::unique_ptr<TransactionTableBase>> m_Tables;
+    };
+}
+
+#endif
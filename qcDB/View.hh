@@ -0,0 +1,120 @@
+#ifndef __QC_DB_VIEW_HH
+#define __QC_DB_VIEW_HH
+
+#include <common/Retcode.hh>
+#include <qcDB/qcDB.hh>
+
+#include <cstddef>
+#include <utility>
+
+namespace qcDB
+{
+    /*
+     * The records of a table as a range for standard algorithms, held under
+     * the table's read lock for as long as the view lives.
+     *
+     *     qcDB::dbReadView view(people);
+     *     size_t adults = std::count_if(std::execution::par_unseq, view.begin(), view.end(), isAdult);
+     *
+     * The iterators point straight into the mapping, they are contiguous
+     * random access iterators so parallel and vectorized algorithms work
+     * without copying. Like the scans, the view covers every record up to
+     * the last written one, deleted records read as zeroes.
+     *
+     * Writers of the table wait until the view is gone, keep it short. The
+     * thread that made the view must not write the table while it lives.
+     */
+    template <class object, class LockPolicy = ProcessSharedLock, class BoundsPolicy = BoundsChecked>
+    class dbReadView
+    {
+    public:
+
+        using DBType = dbInterface<object, LockPolicy, BoundsPolicy>;
+        using value_type = object;
+        using const_iterator = const object*;
+        using iterator = const_iterator;
+        using size_type = size_t;
+
+        explicit dbReadView(DBType& db) :
+            m_DB(&db), m_Begin(nullptr), m_End(nullptr), m_Retcode(RTN_OK)
+        {
+            m_Retcode = m_DB->LockDB(DB_OPERATION::READ_BATCH);
+            if (RTN_OK != m_Retcode)
+            {
+                m_DB->m_Statistics.Failure(m_Retcode);
+                m_DB = nullptr;
+                return;
+            }
+
+            m_Begin = reinterpret_cast<const object*>(m_DB->m_DBAddress + sizeof(DBHeader));
+            m_End = m_Begin + m_DB->ScanSize();
+            m_DB->m_Statistics.Count(STATISTIC::SCANS);
+        }
+
+        dbReadView(dbReadView&& other) :
+            m_DB(std::exchange(other.m_DB, nullptr)), m_Begin(other.m_Begin), m_End(other.m_End), m_Retcode(other.m_Retcode)
+        {
+        }
+
+        dbReadView(dbReadView const&) = delete;
+        void operator = (dbReadView const&) = delete;
+
+        ~dbReadView(void)
+        {
+            if (nullptr != m_DB)
+            {
+                m_DB->UnlockDB(DB_OPERATION::READ_BATCH);
+            }
+        }
+
+        /*
+         * RTN_OK if the lock was taken, the view is empty otherwise.
+         */
+        RETCODE Retcode(void) const
+        {
+            return m_Retcode;
+        }
+
+        const_iterator begin(void) const
+        {
+            return m_Begin;
+        }
+
+        const_iterator end(void) const
+        {
+            return m_End;
+        }
+
+        size_type size(void) const
+        {
+            return m_End - m_Begin;
+        }
+
+        bool empty(void) const
+        {
+            return m_Begin == m_End;
+        }
+
+        const object& operator [] (size_t record) const
+        {
+            return m_Begin[record];
+        }
+
+        /*
+         * Record number of an element of the view.
+         */
+        size_t Record(const object& element) const
+        {
+            return &element - m_Begin;
+        }
+
+    private:
+
+        DBType* m_DB;
+        const object* m_Begin;
+        const object* m_End;
+        RETCODE m_Retcode;
+    };
+}
+
+#endif
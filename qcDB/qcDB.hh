@@ -4,6 +4,10 @@
 #include <common/OSdefines.hh>
 
 #include <string>
+#include <cstring>
+#include <vector>
+#include <tuple>
+#include <utility>
 #include <fcntl.h>
 #include <sys/stat.h>
 
@@ -11,20 +15,71 @@
 #include <Windows.h>
 #else
 #include <sys/mman.h>
+#include <unistd.h>
 #endif
 #include <iostream>
 #include <algorithm>
 #include <functional>
 #include <thread>
+#include <chrono>
+#include <type_traits>
+#include <atomic>
 
 #include <common/Retcode.hh>
 #include <common/DBHeader.hh>
+#include <qcDB/Statistics.hh>
+#include <qcDB/Policies.hh>
+#include <qcDB/Numa.hh>
+#include <qcDB/Reflection.hh>
+#include <qcDB/Bloom.hh>
+#include <qcDB/Checksum.hh>
+#include <qcDB/MappingWindows.hh>
+#include <qcDB/RecordStore.hh>
 
 namespace qcDB
 {
-    template <class object>
+    /*
+     * A record moved by Compact.
+     */
+    struct RECORD_MOVE
+    {
+        size_t from;
+        size_t to;
+    };
+
+    /*
+     * The file a dbInterface mapped, the same in every process that maps it.
+     */
+    struct FILE_IDENTITY
+    {
+        uint64_t device;
+        uint64_t index;
+
+        bool operator < (const FILE_IDENTITY& other) const
+        {
+            return device < other.device || (device == other.device && index < other.index);
+        }
+
+        bool operator == (const FILE_IDENTITY& other) const
+        {
+            return device == other.device && index == other.index;
+        }
+    };
+
+    /*
+     * LockPolicy: ProcessSharedLock, ThreadSharedLock or NoLock
+     * BoundsPolicy: BoundsChecked or Unchecked
+     * See Policies.hh
+     */
+    template <class object, class LockPolicy = ProcessSharedLock, class BoundsPolicy = BoundsChecked>
     class dbInterface
     {
+        template <class, class, class> friend class TransactionTable;
+        template <class, class, class> friend class dbAsync;
+        template <class, class, class> friend class dbReadView;
+        template <class, class, class> friend class dbReplicationSource;
+        template <class, class, class> friend class dbReplica;
+        template <class, class, class> friend class dbColdReader;
 
 public:
 
@@ -32,28 +87,49 @@ public:
          * Read object at given record.
          */
         RETCODE ReadObject(size_t record, object& out_object)
+        {
+            RECORD_VERSION version = 0;
+            return ReadObject(record, out_object, version);
+        }
+
+        /*
+         * Read object at given record along with its version, which can be
+         * passed to CompareAndWrite.
+         */
+        RETCODE ReadObject(size_t record, object& out_object, RECORD_VERSION& out_version)
         {
             RETCODE retcode = RTN_OK;
             char* p_object = Get(record);
             if(nullptr == p_object)
             {
-                return RTN_NULL_OBJ;
+                return m_Statistics.Failure(RTN_NULL_OBJ);
             }
 
-            retcode = LockDB();
+            retcode = LockDB(DB_OPERATION::READ);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
+            // The version first, a field operation racing the copy then makes CompareAndWrite conflict
+            out_version = __atomic_load_n(&m_Store.Versions()[record], __ATOMIC_ACQUIRE);
             memcpy(&out_object, p_object, sizeof(object));
+            bool isIntact = IsIntact(p_object, sizeof(object));
 
-            retcode = UnlockDB();
+            retcode = UnlockDB(DB_OPERATION::READ);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
+            }
+
+            if (!isIntact)
+            {
+                return m_Statistics.Failure(RTN_CORRUPT);
             }
 
+            m_Statistics.Count(STATISTIC::READS);
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, sizeof(object));
+
             return RTN_OK;
         }
 
@@ -71,28 +147,43 @@ public:
                 return std::get<0>(a) < std::get<0>(b);
                 });
 
-            retcode = LockDB();
+            // Check every record first so a bad one fails before taking the lock
+            for(const std::tuple<size_t, object>& readObject : objects)
+            {
+                if(nullptr == Get(std::get<0>(readObject)))
+                {
+                    return m_Statistics.Failure(RTN_NULL_OBJ);
+                }
+            }
+
+            retcode = LockDB(DB_OPERATION::READ_BATCH);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
-            for(std::tuple<size_t, object> readObject : objects)
+            bool isIntact = true;
+            for(std::tuple<size_t, object>& readObject : objects)
             {
                 char* p_object = Get(std::get<0>(readObject));
-                if(nullptr == p_object)
-                {
-                    return RTN_NULL_OBJ;
-                }
                 memcpy(&std::get<1>(readObject), p_object, sizeof(object));
+                isIntact = IsIntact(p_object, sizeof(object)) && isIntact;
             }
 
-            retcode = UnlockDB();
+            retcode = UnlockDB(DB_OPERATION::READ_BATCH);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
+            }
+
+            if (!isIntact)
+            {
+                return m_Statistics.Failure(RTN_CORRUPT);
             }
 
+            m_Statistics.Count(STATISTIC::READS, objects.size());
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, objects.size() * sizeof(object));
+
             return RTN_OK;
         }
 
@@ -105,13 +196,97 @@ public:
             char* p_object = Get(record);
             if(nullptr == p_object)
             {
-                return RTN_NULL_OBJ;
+                return m_Statistics.Failure(RTN_NULL_OBJ);
+            }
+
+            retcode = LockDB(DB_OPERATION::WRITE);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            WriteRecord(p_object, record, objectWrite);
+
+            retcode = UnlockDB(DB_OPERATION::WRITE);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            m_Statistics.Count(STATISTIC::WRITES);
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, sizeof(object));
+
+            return RTN_OK;
+        }
+
+        /*
+         * Overwrite the object at record only if its version is still
+         * expectedVersion, the version returned by ReadObject. On success the
+         * record's version becomes expectedVersion + 1. Returns RTN_CONFLICT
+         * without taking the lock if the record already changed.
+         */
+        RETCODE CompareAndWrite(size_t record, RECORD_VERSION expectedVersion, const object& objectWrite)
+        {
+            RETCODE retcode = RTN_OK;
+            char* p_object = Get(record);
+            if(nullptr == p_object)
+            {
+                return m_Statistics.Failure(RTN_NULL_OBJ);
+            }
+
+            if (expectedVersion != __atomic_load_n(&m_Store.Versions()[record], __ATOMIC_ACQUIRE))
+            {
+                return m_Statistics.Failure(RTN_CONFLICT);
+            }
+
+            retcode = LockDB(DB_OPERATION::WRITE);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            // Another writer may have won between the check and the lock
+            bool isCurrent = expectedVersion == m_Store.Versions()[record];
+            if (isCurrent)
+            {
+                WriteRecord(p_object, record, objectWrite);
+            }
+
+            retcode = UnlockDB(DB_OPERATION::WRITE);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            if (!isCurrent)
+            {
+                return m_Statistics.Failure(RTN_CONFLICT);
+            }
+
+            m_Statistics.Count(STATISTIC::WRITES);
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, sizeof(object));
+
+            return RTN_OK;
+        }
+
+        /*
+         * Overwrite a single field of a record, the rest of the record is not
+         * touched. The field is a generated type such as PERSON_FIELDS::AGE.
+         */
+        template <typename FieldType>
+        RETCODE UpdateField(size_t record, const typename FieldType::ValueType& value)
+        {
+            RETCODE retcode = RTN_OK;
+            typename FieldType::ValueType* p_field = GetField<FieldType>(record);
+            if (nullptr == p_field)
+            {
+                return m_Statistics.Failure(RTN_NULL_OBJ);
             }
 
-            retcode = LockDB();
+            retcode = LockDB(DB_OPERATION::WRITE);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
             DBHeader* header = reinterpret_cast<DBHeader*>(m_DBAddress);
@@ -121,14 +296,125 @@ public:
                 header->m_Size = record;
             }
 
-            memcpy(p_object, &objectWrite, sizeof(object));
+            StoreBytes(reinterpret_cast<char*>(p_field), &value, sizeof(value));
+            m_Store.BumpVersion(record);
+            AddFieldToBloomFilter<FieldType>(value);
+
+            retcode = UnlockDB(DB_OPERATION::WRITE);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            m_Statistics.Count(STATISTIC::WRITES);
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, sizeof(value));
+
+            return RTN_OK;
+        }
+
+        /*
+         * Atomically add to an integer field under the read lock, so it runs
+         * alongside reads and other field operations but never inside a whole
+         * object write. A later write of the same record still overwrites the
+         * result. Tables with checksums take the write lock to update the
+         * checksum along with the field.
+         */
+        template <typename FieldType>
+        RETCODE FetchAddField(size_t record, typename FieldType::ValueType delta, typename FieldType::ValueType& out_previous)
+        {
+            static_assert(IsAtomicField<FieldType>(), "Only integer fields can be updated atomically");
+
+            typename FieldType::ValueType* p_field = GetField<FieldType>(record);
+            if (nullptr == p_field)
+            {
+                return m_Statistics.Failure(RTN_NULL_OBJ);
+            }
+
+            RETCODE retcode = LockForField();
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            // The version is bumped right after the field so CompareAndWrite of an older copy conflicts
+            out_previous = __atomic_fetch_add(p_field, delta, __ATOMIC_SEQ_CST);
+            m_Store.BumpVersion(record);
+            typename FieldType::ValueType current = out_previous + delta;
+            m_Store.UpdateChecksums(reinterpret_cast<char*>(p_field), &out_previous, &current, sizeof(current));
+            m_Store.MarkChanged(reinterpret_cast<char*>(p_field), sizeof(current));
+            NotifyChanged(reinterpret_cast<char*>(p_field), sizeof(current));
+            AddFieldToBloomFilter<FieldType>(current);
+
+            retcode = UnlockForField();
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            m_Statistics.Count(STATISTIC::WRITES);
+
+            return RTN_OK;
+        }
+
+        /*
+         * Atomically replace an integer field under the read lock if it still
+         * holds expected. Otherwise returns RTN_CONFLICT and expected is set
+         * to the current value. Tables with checksums take the write lock.
+         */
+        template <typename FieldType>
+        RETCODE CompareAndSwapField(size_t record, typename FieldType::ValueType& expected, typename FieldType::ValueType desired)
+        {
+            static_assert(IsAtomicField<FieldType>(), "Only integer fields can be updated atomically");
+
+            typename FieldType::ValueType* p_field = GetField<FieldType>(record);
+            if (nullptr == p_field)
+            {
+                return m_Statistics.Failure(RTN_NULL_OBJ);
+            }
+
+            RETCODE retcode = LockForField();
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            bool isSwapped = __atomic_compare_exchange_n(p_field, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE);
+            if (isSwapped)
+            {
+                m_Store.BumpVersion(record);
+                m_Store.UpdateChecksums(reinterpret_cast<char*>(p_field), &expected, &desired, sizeof(desired));
+                m_Store.MarkChanged(reinterpret_cast<char*>(p_field), sizeof(desired));
+                NotifyChanged(reinterpret_cast<char*>(p_field), sizeof(desired));
+                AddFieldToBloomFilter<FieldType>(desired);
+            }
 
-            retcode = UnlockDB();
+            retcode = UnlockForField();
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
+            }
+
+            if (!isSwapped)
+            {
+                return m_Statistics.Failure(RTN_CONFLICT);
+            }
+
+            m_Statistics.Count(STATISTIC::WRITES);
+
+            return RTN_OK;
+        }
+
+        /*
+         * Current version of a record without taking the lock.
+         */
+        RETCODE ReadVersion(size_t record, RECORD_VERSION& out_version)
+        {
+            if(nullptr == Get(record))
+            {
+                return m_Statistics.Failure(RTN_NULL_OBJ);
             }
 
+            out_version = __atomic_load_n(&m_Store.Versions()[record], __ATOMIC_ACQUIRE);
             return RTN_OK;
         }
 
@@ -139,21 +425,24 @@ public:
         {
             RETCODE retcode = RTN_OK;
             object emptyObject = { 0 };
-            retcode = LockDB();
+            retcode = LockDB(DB_OPERATION::APPEND);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
             DBHeader* header = reinterpret_cast<DBHeader*>(m_DBAddress);
             size_t record = header->m_LastWritten;
+            size_t firstRecord = record;
             object* currentObject = reinterpret_cast<object*>(m_DBAddress + sizeof(DBHeader) + record * sizeof(object));
             for (; record < NumberOfRecords(); record++)
             {
                 if (std::memcmp(currentObject, &emptyObject, sizeof(object)) == 0)
                 {
                     header->m_LastWritten = record;
-                    memcpy(currentObject, &objectWrite, sizeof(object));
+                    StoreBytes(reinterpret_cast<char*>(currentObject), &objectWrite, sizeof(object));
+                    m_Store.BumpVersion(record);
+                    AddToBloomFilters(objectWrite);
 
                     if (header->m_Size < record)
                     {
@@ -166,17 +455,22 @@ public:
                 currentObject++;
             }
 
-            retcode = UnlockDB();
+            retcode = UnlockDB(DB_OPERATION::APPEND);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
+            m_Statistics.Count(STATISTIC::RECORDS_SCANNED, record - firstRecord);
+
             if(NumberOfRecords() == record)
             {
-                return RTN_NOT_FOUND;
+                return m_Statistics.Failure(RTN_NOT_FOUND);
             }
 
+            m_Statistics.Count(STATISTIC::WRITES);
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, sizeof(object));
+
             return RTN_OK;
         }
 
@@ -195,20 +489,31 @@ public:
                 }
             );
 
-            retcode = LockDB();
-            if (RTN_OK != retcode)
+            if (objects.empty())
             {
-                return retcode;
+                return RTN_OK;
             }
 
-            for(std::tuple<size_t, object> writeObject : objects)
+            // Check every record first so nothing is written if one is bad
+            for(const std::tuple<size_t, object>& writeObject : objects)
             {
-                char* p_object = Get(std::get<0>(writeObject));
-                if(nullptr == p_object)
+                if(nullptr == Get(std::get<0>(writeObject)))
                 {
-                    return RTN_NULL_OBJ;
+                    return m_Statistics.Failure(RTN_NULL_OBJ);
                 }
-                memcpy(p_object, &std::get<1>(writeObject), sizeof(object));
+            }
+
+            retcode = LockDB(DB_OPERATION::WRITE_BATCH);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            for(const std::tuple<size_t, object>& writeObject : objects)
+            {
+                StoreBytes(Get(std::get<0>(writeObject)), &std::get<1>(writeObject), sizeof(object));
+                m_Store.BumpVersion(std::get<0>(writeObject));
+                AddToBloomFilters(std::get<1>(writeObject));
             }
 
             DBHeader* header = reinterpret_cast<DBHeader*>(m_DBAddress);
@@ -219,12 +524,15 @@ public:
                 header->m_Size = std::get<0>(objects.back());
             }
 
-            retcode = UnlockDB();
+            retcode = UnlockDB(DB_OPERATION::WRITE_BATCH);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
+            m_Statistics.Count(STATISTIC::WRITES, objects.size());
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, objects.size() * sizeof(object));
+
             return RTN_OK;
         }
 
@@ -237,14 +545,15 @@ public:
             const object emptyObject = { 0 };
             auto objectsIterator = objects.begin();
 
-            retcode = LockDB();
+            retcode = LockDB(DB_OPERATION::APPEND_BATCH);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
             DBHeader* header = reinterpret_cast<DBHeader*>(m_DBAddress);
             size_t record = header->m_LastWritten;
+            size_t firstRecord = record;
             object* currentObject = reinterpret_cast<object*>(m_DBAddress + sizeof(DBHeader) + record * sizeof(object));
             for (; record < NumberOfRecords(); record++)
             {
@@ -256,7 +565,9 @@ public:
                         break;
                     }
 
-                    memcpy(currentObject, &(*objectsIterator), sizeof(object));
+                    StoreBytes(reinterpret_cast<char*>(currentObject), &(*objectsIterator), sizeof(object));
+                    m_Store.BumpVersion(record);
+                    AddToBloomFilters(*objectsIterator);
 
                     ++objectsIterator;
                 }
@@ -269,15 +580,20 @@ public:
                 header->m_Size = record;
             }
 
-            retcode = UnlockDB();
+            retcode = UnlockDB(DB_OPERATION::APPEND_BATCH);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
+            size_t numWritten = std::distance(objects.begin(), objectsIterator);
+            m_Statistics.Count(STATISTIC::RECORDS_SCANNED, record - firstRecord);
+            m_Statistics.Count(STATISTIC::WRITES, numWritten);
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, numWritten * sizeof(object));
+
             if (objectsIterator != objects.end())
             {
-                return RTN_EOF;
+                return m_Statistics.Failure(RTN_EOF);
             }
 
             return RTN_OK;
@@ -289,44 +605,28 @@ public:
         RETCODE DeleteObject(size_t record)
         {
             RETCODE retcode = RTN_OK;
-            object deletedObject = { 0 };
             char* p_object = Get(record);
             if (nullptr == p_object)
             {
-                return RTN_NULL_OBJ;
+                return m_Statistics.Failure(RTN_NULL_OBJ);
             }
 
-            retcode = LockDB();
+            retcode = LockDB(DB_OPERATION::DELETE_RECORD);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
-            DBHeader* header = reinterpret_cast<DBHeader*>(m_DBAddress);
-            size_t size = header->m_Size;
-
-            memset(p_object, 0, sizeof(object));
-
-            // If the deleted record was the last one, find the next last record
-            if (size == record)
-            {
-                for (; p_object != m_DBAddress; p_object -= sizeof(object))
-                {
-                    --record;
-                    if (std::memcmp(p_object, &deletedObject, sizeof(object)) != 0)
-                    {
-                        break;
-                    }
-                }
 
-                header->m_Size = record;
-            }
+            DeleteRecord(p_object, record);
 
-            retcode = UnlockDB();
+            retcode = UnlockDB(DB_OPERATION::DELETE_RECORD);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
+            m_Statistics.Count(STATISTIC::DELETES);
+
             return RTN_OK;
         }
 
@@ -338,10 +638,10 @@ public:
             RETCODE retcode = RTN_OK;
             if (m_IsOpen)
             {
-                retcode = LockDB();
+                retcode = LockDB(DB_OPERATION::CLEAR);
                 if (RTN_OK != retcode)
                 {
-                    return retcode;
+                    return m_Statistics.Failure(retcode);
                 }
 
                 DBHeader* header = reinterpret_cast<DBHeader*>(m_DBAddress);
@@ -349,20 +649,45 @@ public:
                 object* start = reinterpret_cast<object*>(m_DBAddress + sizeof(DBHeader));
 
                 memset(start, 0, dbSize);
+                m_Windows.ReleaseAll();
+
+                // Zeroed blocks have a zero checksum
+                if (m_Store.Checksums())
+                {
+                    memset(m_Store.Checksums(), 0, ChecksumBlocks(header->m_NumRecords, sizeof(object)) * sizeof(BLOCK_CHECKSUM));
+                }
+
+                m_Store.MarkChanged(reinterpret_cast<char*>(start), dbSize);
+                if (m_ChangeHandler)
+                {
+                    m_ChangeHandler(0, header->m_NumRecords, nullptr);
+                }
+
+                // Versions keep counting so nothing read before the clear can be written back
+                for (size_t record = 0; record < header->m_NumRecords; record++)
+                {
+                    m_Store.BumpVersion(record);
+                }
 
                 header->m_LastWritten = 0;
                 header->m_Size = 0;
 
-                retcode = UnlockDB();
+                if (m_BloomFilters)
+                {
+                    memset(m_BloomFilters, 0, NumBloomFilters() * m_BloomBlocks * sizeof(BLOOM_BLOCK));
+                    header->m_BloomStale = 0;
+                }
+
+                retcode = UnlockDB(DB_OPERATION::CLEAR);
                 if (RTN_OK != retcode)
                 {
-                    return retcode;
+                    return m_Statistics.Failure(retcode);
                 }
 
                 return RTN_OK;
             }
 
-            return RTN_MALLOC_FAIL;
+            return m_Statistics.Failure(RTN_MALLOC_FAIL);
         }
 
         /*
@@ -378,165 +703,676 @@ public:
         /*
          * If multiple records would match the predicate,
          * return the record of the first one found.
+         *
+         * Threads claim chunks of records in order. A match lowers the shared
+         * best record and threads abandon any chunk past it, so the search
+         * stops as soon as no earlier record can still match.
          */
         RETCODE FindFirstOf(Predicate predicate, size_t& out_Record)
         {
             RETCODE retcode = RTN_OK;
-            bool found = false;
-            retcode = LockDB();
+            retcode = LockDB(DB_OPERATION::FIND_FIRST);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
-            const object* currentObject = reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
-            size_t size = reinterpret_cast<DBHeader*>(m_DBAddress)->m_Size;
-            size_t record = 0;
-            for (record = 0; record < size; record++)
+            const object* firstObject = reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
+            size_t size = ScanSize();
+            size_t numChunks = (size + SCAN_CHUNK_RECORDS - 1) / SCAN_CHUNK_RECORDS;
+            std::atomic<size_t> nextChunk(0);
+            std::atomic<size_t> bestRecord(SIZE_MAX);
+            std::atomic<size_t> numScanned(0);
+
+            RunScanThreads(numChunks, [&]()
             {
-                if (predicate(currentObject))
+                for (;;)
                 {
-                    out_Record = record;
-                    found = true;
-                    break;
-                }
+                    size_t chunk = nextChunk.fetch_add(1);
+                    size_t record = chunk * SCAN_CHUNK_RECORDS;
+                    if (numChunks <= chunk || bestRecord.load(std::memory_order_relaxed) <= record)
+                    {
+                        return;
+                    }
 
-                currentObject++;
-            }
+                    size_t firstRecord = record;
+                    size_t end = std::min(size, record + SCAN_CHUNK_RECORDS);
+                    size_t windowEnd = record;
+                    for (; record < end; record++)
+                    {
+                        if (windowEnd == record)
+                        {
+                            windowEnd = UseWindowOf(record, end);
+                        }
+
+                        // Checking every record would make the shared line bounce between cores
+                        if (0 == record % CANCEL_CHECK_RECORDS && bestRecord.load(std::memory_order_relaxed) <= record)
+                        {
+                            break;
+                        }
+
+                        if (predicate(firstObject + record))
+                        {
+                            size_t best = bestRecord.load();
+                            while (record < best && !bestRecord.compare_exchange_weak(best, record))
+                            {
+                            }
+
+                            record++;
+                            break;
+                        }
+                    }
+
+                    numScanned.fetch_add(record - firstRecord, std::memory_order_relaxed);
+                }
+            });
 
-            retcode = UnlockDB();
+            retcode = UnlockDB(DB_OPERATION::FIND_FIRST);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
-            if(!found)
+            m_Statistics.Count(STATISTIC::SCANS);
+            m_Statistics.Count(STATISTIC::RECORDS_SCANNED, numScanned.load());
+
+            if (SIZE_MAX == bestRecord.load())
             {
-                return RTN_NOT_FOUND;
+                return m_Statistics.Failure(RTN_NOT_FOUND);
             }
 
+            out_Record = bestRecord.load();
             return RTN_OK;
         }
 
         /*
          * Find objects using the predicate by sharding the database and searching
-         * in parallel.
+         * in parallel. With NUMA placement every node scans its own records.
          */
         RETCODE FindObjects(Predicate predicate, std::vector<object>& out_MatchingObjects)
         {
             RETCODE retcode = RTN_OK;
-            // Number of threads /2 so we don't completely lock up the CPU
-#ifdef WINDOWS_PLATFORM
-            size_t numThreads = std::thread::hardware_concurrency() / 2;
-#else
-            size_t numThreads = sysconf(_SC_NPROCESSORS_ONLN) / 2;
-#endif
-            std::vector<std::thread> threads;
-            std::vector<std::vector<object>> results(numThreads);
+            size_t numThreads = NumScanThreads();
 
-            retcode = LockDB();
+            retcode = LockDB(DB_OPERATION::FIND);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
-            const object* currentObject = reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
-            size_t size = reinterpret_cast<DBHeader*>(m_DBAddress)->m_Size;
-            size_t segmentSize = size / numThreads;
+            const object* firstObject = reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
+            size_t size = ScanSize();
 
-            for (size_t threadIndex = 0; threadIndex < numThreads - 1; threadIndex++)
+            // Each node gets an equal share of the threads and scans the records placed on it
+            const NumaTopology& topology = NumaTopology::Get();
+            bool isNodeLocal = NUMA_PLACEMENT::NONE != m_Placement;
+            size_t numNodes = isNodeLocal ? topology.NumNodes() : 1;
+            size_t threadsPerNode = std::max<size_t>(numThreads / numNodes, 1);
+
+            std::vector<std::thread> threads;
+            std::vector<std::vector<object>> results(numNodes * threadsPerNode);
+            for (size_t node = 0; node < numNodes; node++)
             {
-                threads.emplace_back(FinderThread, predicate, currentObject, segmentSize, std::ref(results[threadIndex]));
-                currentObject += segmentSize;
+                size_t nodeFirst = NodeFirstRecord(node, numNodes, size);
+                size_t nodeSize = NodeFirstRecord(node + 1, numNodes, size) - nodeFirst;
+                size_t segmentSize = nodeSize / threadsPerNode;
+                for (size_t threadIndex = 0; threadIndex < threadsPerNode; threadIndex++)
+                {
+                    const object* currentObject = firstObject + nodeFirst + threadIndex * segmentSize;
+                    size_t numRecords = threadIndex + 1 < threadsPerNode ? segmentSize : nodeSize - threadIndex * segmentSize;
+                    std::vector<object>& threadResults = results[node * threadsPerNode + threadIndex];
+                    threads.emplace_back([this, &topology, isNodeLocal, node, predicate, currentObject, numRecords, &threadResults]()
+                    {
+                        if (isNodeLocal)
+                        {
+                            topology.PinThread(node);
+                        }
+
+                        // A window at a time so a windowed table keeps only the windows being scanned
+                        size_t firstRecord = currentObject - reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
+                        for (size_t done = 0; done < numRecords;)
+                        {
+                            size_t windowEnd = UseWindowOf(firstRecord + done, firstRecord + numRecords) - firstRecord;
+                            FinderThread(predicate, currentObject + done, windowEnd - done, threadResults);
+                            done = windowEnd;
+                        }
+                    });
+                }
             }
 
-            threads.emplace_back(FinderThread, predicate, currentObject, size - ((numThreads - 1) * segmentSize), std::ref(results[numThreads - 1]));
-
             for (std::thread& thread : threads)
             {
                 thread.join();
             }
 
-            retcode = UnlockDB();
+            retcode = UnlockDB(DB_OPERATION::FIND);
             if (RTN_OK != retcode)
             {
-                return retcode;
+                return m_Statistics.Failure(retcode);
             }
 
+            size_t numMatches = 0;
             for (std::vector<object>& matches : results)
             {
                 for (object& match : matches)
                 {
                     out_MatchingObjects.push_back(match);
                 }
+
+                numMatches += matches.size();
             }
 
+            m_Statistics.Count(STATISTIC::SCANS);
+            m_Statistics.Count(STATISTIC::RECORDS_SCANNED, size);
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, numMatches * sizeof(object));
+
             return RTN_OK;
         }
 
         /*
-         * Total number of records to be accessed by users.
+         * Like FindObjects but stops once limit objects matched and returns
+         * the first limit matches in record order.
+         *
+         * Threads claim chunks of records in order and stop claiming once the
+         * chunks already claimed hold enough matches, later chunks can only
+         * hold later records.
          */
-        inline size_t NumberOfRecords(void)
+        RETCODE FindObjects(Predicate predicate, std::vector<object>& out_MatchingObjects, size_t limit)
         {
-            if (m_IsOpen)
+            RETCODE retcode = RTN_OK;
+            if (0 == limit)
             {
-                return m_NumRecords;
+                return RTN_OK;
             }
 
-            return 0;
-        }
+            retcode = LockDB(DB_OPERATION::FIND);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
 
-        /*
-         * Gather last written record for users.
-         */
-        inline size_t LastWrittenRecord(size_t& record)
-        {
-            RETCODE retcode = RTN_OK;
-            size_t lastWrittenRecord = 0;
+            const object* firstObject = reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
+            size_t size = ScanSize();
+            size_t numChunks = (size + SCAN_CHUNK_RECORDS - 1) / SCAN_CHUNK_RECORDS;
+            std::vector<std::vector<object>> chunkResults(numChunks);
+            std::atomic<size_t> nextChunk(0);
+            std::atomic<size_t> numFound(0);
+            std::atomic<size_t> numScanned(0);
 
-            if (m_IsOpen)
+            RunScanThreads(numChunks, [&]()
             {
-                retcode = LockDB();
-                if (RTN_OK != retcode)
+                while (numFound.load(std::memory_order_relaxed) < limit)
                 {
-                    return retcode;
-                }
+                    size_t chunk = nextChunk.fetch_add(1);
+                    if (numChunks <= chunk)
+                    {
+                        return;
+                    }
 
-                record = reinterpret_cast<DBHeader*>(m_DBAddress)->m_LastWritten;
+                    std::vector<object>& results = chunkResults[chunk];
+                    size_t end = std::min(size, (chunk + 1) * SCAN_CHUNK_RECORDS);
+                    size_t record = chunk * SCAN_CHUNK_RECORDS;
+                    size_t windowEnd = record;
+                    for (; record < end && results.size() < limit; record++)
+                    {
+                        if (windowEnd == record)
+                        {
+                            windowEnd = UseWindowOf(record, end);
+                        }
+
+                        if (predicate(firstObject + record))
+                        {
+                            results.push_back(firstObject[record]);
+                        }
+                    }
 
-                retcode = UnlockDB();
-                if (RTN_OK != retcode)
-                {
-                    return retcode;
+                    numScanned.fetch_add(record - chunk * SCAN_CHUNK_RECORDS, std::memory_order_relaxed);
+                    numFound.fetch_add(results.size());
                 }
+            });
 
+            retcode = UnlockDB(DB_OPERATION::FIND);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
             }
-            else
+
+            size_t numMatches = 0;
+            for (size_t chunk = 0; chunk < numChunks && numMatches < limit; chunk++)
             {
-                return RTN_NULL_OBJ;
+                size_t numTaken = std::min(chunkResults[chunk].size(), limit - numMatches);
+                out_MatchingObjects.insert(out_MatchingObjects.end(), chunkResults[chunk].begin(), chunkResults[chunk].begin() + numTaken);
+                numMatches += numTaken;
             }
 
-            return retcode;
+            m_Statistics.Count(STATISTIC::SCANS);
+            m_Statistics.Count(STATISTIC::RECORDS_SCANNED, numScanned.load());
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, numMatches * sizeof(object));
+
+            return RTN_OK;
         }
 
-        dbInterface(const std::string& dbPath) :
-            m_IsOpen(false), m_Size(0),
-            m_DBAddress(nullptr), m_NumRecords(0)
-#ifdef WINDOWS_PLATFORM
-            , m_Mutex(INVALID_HANDLE_VALUE)
-#endif
+        /*
+         * The count objects matching the predicate with the largest (or
+         * smallest) value of a field, best first. The field is a generated
+         * type such as PERSON_FIELDS::AGE. Every thread keeps a heap of its
+         * best count matches so only those are copied and merged.
+         */
+        template <typename FieldType>
+        RETCODE FindTopObjects(Predicate predicate, size_t count, std::vector<object>& out_MatchingObjects, bool isLargest = true)
         {
-#ifdef WINDOWS_PLATFORM
-            HANDLE hFile = CreateFileA(
-                static_cast<LPCSTR>(dbPath.c_str()), // File name
-                GENERIC_READ | GENERIC_WRITE,        // Access mode
-                FILE_SHARE_READ | FILE_SHARE_WRITE,  // Share mode
-                NULL,                                // Security attributes
-                OPEN_EXISTING,                         // How to create
-                FILE_ATTRIBUTE_NORMAL,               // File attributes
-                NULL                                 // Handle to template file
-            );
+            static_assert(std::is_same<typename FieldType::ObjectType, object>::value, "Field belongs to another object");
+
+            RETCODE retcode = RTN_OK;
+            if (0 == count)
+            {
+                return RTN_OK;
+            }
+
+            // With this ordering the front of a heap is the worst match it keeps
+            auto isBetter = [isLargest](const object& left, const object& right)
+            {
+                return isLargest ? FieldType::Less(right, left) : FieldType::Less(left, right);
+            };
+
+            retcode = LockDB(DB_OPERATION::FIND);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            const object* firstObject = reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
+            size_t size = ScanSize();
+            size_t numChunks = (size + SCAN_CHUNK_RECORDS - 1) / SCAN_CHUNK_RECORDS;
+            std::vector<std::vector<object>> heaps(std::min(NumScanThreads(), std::max<size_t>(numChunks, 1)));
+            std::atomic<size_t> nextChunk(0);
+            std::atomic<size_t> nextHeap(0);
+
+            RunScanThreads(numChunks, [&]()
+            {
+                std::vector<object>& heap = heaps[nextHeap.fetch_add(1)];
+                for (size_t chunk = nextChunk.fetch_add(1); chunk < numChunks; chunk = nextChunk.fetch_add(1))
+                {
+                    size_t end = std::min(size, (chunk + 1) * SCAN_CHUNK_RECORDS);
+                    size_t windowEnd = chunk * SCAN_CHUNK_RECORDS;
+                    for (size_t record = chunk * SCAN_CHUNK_RECORDS; record < end; record++)
+                    {
+                        if (windowEnd == record)
+                        {
+                            windowEnd = UseWindowOf(record, end);
+                        }
+
+                        const object& currentObject = firstObject[record];
+                        if (!predicate(&currentObject))
+                        {
+                            continue;
+                        }
+
+                        if (heap.size() < count)
+                        {
+                            heap.push_back(currentObject);
+                            std::push_heap(heap.begin(), heap.end(), isBetter);
+                        }
+                        else if (isBetter(currentObject, heap.front()))
+                        {
+                            std::pop_heap(heap.begin(), heap.end(), isBetter);
+                            heap.back() = currentObject;
+                            std::push_heap(heap.begin(), heap.end(), isBetter);
+                        }
+                    }
+                }
+            });
+
+            retcode = UnlockDB(DB_OPERATION::FIND);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            std::vector<object> matches;
+            for (std::vector<object>& heap : heaps)
+            {
+                matches.insert(matches.end(), heap.begin(), heap.end());
+            }
+
+            size_t numMatches = std::min(count, matches.size());
+            std::partial_sort(matches.begin(), matches.begin() + numMatches, matches.end(), isBetter);
+            out_MatchingObjects.insert(out_MatchingObjects.end(), matches.begin(), matches.begin() + numMatches);
+
+            m_Statistics.Count(STATISTIC::SCANS);
+            m_Statistics.Count(STATISTIC::RECORDS_SCANNED, size);
+            m_Statistics.Count(STATISTIC::BYTES_COPIED, numMatches * sizeof(object));
+
+            return RTN_OK;
+        }
+
+        /*
+         * False if no record ever held value in the field, true if one may
+         * hold it. Answered from the field's Bloom filter without the lock or
+         * a scan, always true for fields without a filter (declared with
+         * "bloom" in the schema) or while the filters are stale.
+         */
+        template <typename FieldType>
+        bool MayContain(const typename FieldType::ValueType& value)
+        {
+            static_assert(std::is_same<typename FieldType::ObjectType, object>::value, "Field belongs to another object");
+
+            const BLOOM_BLOCK* filter = BloomFilter(FieldType::INDEX);
+            if (nullptr == filter || reinterpret_cast<DBHeader*>(m_DBAddress)->m_BloomStale)
+            {
+                return true;
+            }
+
+            return BloomMayContain(filter, m_BloomBlocks, FieldTraits<typename FieldType::ValueType>::Hash(value));
+        }
+
+        /*
+         * Rebuild the Bloom filters from the records, dropping values that
+         * were deleted or overwritten and clearing a stale mark.
+         */
+        RETCODE RebuildBloomFilters(void)
+        {
+            RETCODE retcode = RTN_OK;
+            if (nullptr == m_BloomFilters)
+            {
+                return RTN_OK;
+            }
+
+            retcode = LockDB(DB_OPERATION::REBUILD_BLOOM);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            memset(m_BloomFilters, 0, NumBloomFilters() * m_BloomBlocks * sizeof(BLOOM_BLOCK));
+
+            const object deletedObject = { 0 };
+            const object* currentObject = reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
+            size_t size = ScanSize();
+            size_t windowEnd = 0;
+            for (size_t record = 0; record < size; record++, currentObject++)
+            {
+                if (windowEnd == record)
+                {
+                    windowEnd = UseWindowOf(record, size);
+                }
+
+                if (0 != std::memcmp(currentObject, &deletedObject, sizeof(object)))
+                {
+                    AddToBloomFilters(*currentObject);
+                }
+            }
+
+            reinterpret_cast<DBHeader*>(m_DBAddress)->m_BloomStale = 0;
+
+            retcode = UnlockDB(DB_OPERATION::REBUILD_BLOOM);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            m_Statistics.Count(STATISTIC::SCANS);
+            m_Statistics.Count(STATISTIC::RECORDS_SCANNED, size);
+
+            return RTN_OK;
+        }
+
+        /*
+         * Move live records from the end of the table into the deleted records
+         * before them, so scans stop at the last live record again.
+         *
+         * Runs in batches of at most batchSize moves, each one holding the
+         * write lock, so other users of the table keep going in between.
+         * Every move is appended to out_Moves in order, callers and indexes
+         * holding record numbers must apply them. A moved record reads as
+         * deleted at its old number and both versions are bumped, so a
+         * CompareAndWrite based on the old number fails.
+         *
+         * isReleasingSpace gives the pages of the empty records after the
+         * last live one back to the file system.
+         */
+        RETCODE Compact(std::vector<RECORD_MOVE>& out_Moves, size_t batchSize = COMPACT_BATCH_RECORDS, bool isReleasingSpace = false)
+        {
+            RETCODE retcode = RTN_OK;
+            if (!m_IsOpen)
+            {
+                return m_Statistics.Failure(RTN_NULL_OBJ);
+            }
+
+            if (0 == batchSize)
+            {
+                return m_Statistics.Failure(RTN_BAD_ARG);
+            }
+
+            const object deletedObject = { 0 };
+            object* records = reinterpret_cast<object*>(m_DBAddress + sizeof(DBHeader));
+            size_t hole = 0;
+            size_t live = SIZE_MAX;
+            bool isDone = false;
+            while (!isDone)
+            {
+                retcode = LockDB(DB_OPERATION::COMPACT);
+                if (RTN_OK != retcode)
+                {
+                    return m_Statistics.Failure(retcode);
+                }
+
+                // Records written past the end since the last batch are left where they are
+                size_t size = ScanSize();
+                live = std::min(live, size ? size - 1 : 0);
+
+                // Searching is bounded too so a batch over mostly live records ends
+                size_t numMoves = 0;
+                size_t budget = batchSize * COMPACT_SEARCH_FACTOR;
+                for (;;)
+                {
+                    while (hole < live && budget && 0 != std::memcmp(&records[hole], &deletedObject, sizeof(object)))
+                    {
+                        hole++;
+                        budget--;
+                        UseRecords(hole, 1);
+                    }
+
+                    while (hole < live && budget && 0 == std::memcmp(&records[live], &deletedObject, sizeof(object)))
+                    {
+                        live--;
+                        budget--;
+                        UseRecords(live, 1);
+                    }
+
+                    if (hole >= live)
+                    {
+                        isDone = true;
+                        break;
+                    }
+
+                    if (0 == budget || batchSize == numMoves)
+                    {
+                        break;
+                    }
+
+                    WriteRecord(reinterpret_cast<char*>(&records[hole]), hole, records[live]);
+                    DeleteRecord(reinterpret_cast<char*>(&records[live]), live);
+                    out_Moves.push_back(RECORD_MOVE{ live, hole });
+                    numMoves++;
+                    hole++;
+                    live--;
+                }
+
+                if (isDone && isReleasingSpace)
+                {
+                    ReleaseEmptyTail();
+                }
+
+                retcode = UnlockDB(DB_OPERATION::COMPACT);
+                if (RTN_OK != retcode)
+                {
+                    return m_Statistics.Failure(retcode);
+                }
+
+                m_Statistics.Count(STATISTIC::WRITES, numMoves);
+                m_Statistics.Count(STATISTIC::DELETES, numMoves);
+                m_Statistics.Count(STATISTIC::BYTES_COPIED, numMoves * sizeof(object));
+            }
+
+            // Drop the values of deleted records from the filters
+            return RebuildBloomFilters();
+        }
+
+        /*
+         * Keep the windows holding numRecords records from firstRecord
+         * resident until they are unpinned, they are read ahead now. Does
+         * nothing unless the table was opened with WINDOWED_MAPPING.
+         */
+        RETCODE PinRecords(size_t firstRecord, size_t numRecords)
+        {
+            if (!m_IsOpen || NumberOfRecords() < firstRecord || NumberOfRecords() - firstRecord < numRecords)
+            {
+                return m_Statistics.Failure(RTN_BAD_ARG);
+            }
+
+            m_Windows.Pin(sizeof(DBHeader) + firstRecord * sizeof(object), numRecords * sizeof(object));
+            return RTN_OK;
+        }
+
+        RETCODE UnpinRecords(size_t firstRecord, size_t numRecords)
+        {
+            if (!m_IsOpen || NumberOfRecords() < firstRecord || NumberOfRecords() - firstRecord < numRecords)
+            {
+                return m_Statistics.Failure(RTN_BAD_ARG);
+            }
+
+            m_Windows.Unpin(sizeof(DBHeader) + firstRecord * sizeof(object), numRecords * sizeof(object));
+            return RTN_OK;
+        }
+
+        /*
+         * Windows of a windowed table that are resident, pinned ones included.
+         */
+        size_t NumberOfResidentWindows(void)
+        {
+            return m_Windows.NumberOfResidentWindows();
+        }
+
+        /*
+         * Number of checksummed blocks of records, 0 if the table was
+         * generated without checksums.
+         */
+        size_t NumberOfChecksumBlocks(void)
+        {
+            return m_Store.Checksums() ? ChecksumBlocks(m_NumRecords, sizeof(object)) : 0;
+        }
+
+        /*
+         * Check numBlocks blocks from firstBlock against their checksums
+         * under the read lock, the blocks that do not match are appended to
+         * out_CorruptBlocks. Block b holds the bytes of the records from
+         * b * CHECKSUM_BLOCK_SIZE. See qcDB/Scrubber.hh to check a whole
+         * table in the background.
+         */
+        RETCODE VerifyChecksums(size_t firstBlock, size_t numBlocks, std::vector<size_t>& out_CorruptBlocks)
+        {
+            RETCODE retcode = RTN_OK;
+            size_t lastBlock = std::min(firstBlock + numBlocks, NumberOfChecksumBlocks());
+            if (nullptr == m_Store.Checksums())
+            {
+                return m_Statistics.Failure(RTN_NOT_FOUND);
+            }
+
+            retcode = LockDB(DB_OPERATION::VERIFY);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            const char* records = m_DBAddress + sizeof(DBHeader);
+            for (size_t block = firstBlock; block < lastBlock; block++)
+            {
+                m_Windows.Use(sizeof(DBHeader) + block * CHECKSUM_BLOCK_SIZE, CHECKSUM_BLOCK_SIZE);
+                if (m_Store.Checksums()[block] != BlockChecksum(records, RecordsLength(), block))
+                {
+                    out_CorruptBlocks.push_back(block);
+                }
+            }
+
+            retcode = UnlockDB(DB_OPERATION::VERIFY);
+            if (RTN_OK != retcode)
+            {
+                return m_Statistics.Failure(retcode);
+            }
+
+            return RTN_OK;
+        }
+
+        /*
+         * Total number of records to be accessed by users.
+         */
+        inline size_t NumberOfRecords(void)
+        {
+            if (m_IsOpen)
+            {
+                return m_NumRecords;
+            }
+
+            return 0;
+        }
+
+        /*
+         * Gather last written record for users.
+         */
+        inline size_t LastWrittenRecord(size_t& record)
+        {
+            RETCODE retcode = RTN_OK;
+            size_t lastWrittenRecord = 0;
+
+            if (m_IsOpen)
+            {
+                retcode = LockDB(DB_OPERATION::LAST_WRITTEN);
+                if (RTN_OK != retcode)
+                {
+                    return m_Statistics.Failure(retcode);
+                }
+
+                record = reinterpret_cast<DBHeader*>(m_DBAddress)->m_LastWritten;
+
+                retcode = UnlockDB(DB_OPERATION::LAST_WRITTEN);
+                if (RTN_OK != retcode)
+                {
+                    return m_Statistics.Failure(retcode);
+                }
+
+            }
+            else
+            {
+                return m_Statistics.Failure(RTN_NULL_OBJ);
+            }
+
+            return retcode;
+        }
+
+        /*
+         * placement: how to spread the records across NUMA nodes, see Numa.hh.
+         * Ignored on machines with a single node.
+         * windows: keep only some windows of the records resident, see
+         * MappingWindows.hh. By default the whole file is populated.
+         */
+        dbInterface(const std::string& dbPath, NUMA_PLACEMENT placement = NUMA_PLACEMENT::NONE,
+            const WINDOWED_MAPPING& windows = WINDOWED_MAPPING()) :
+            m_IsOpen(false), m_Size(0),
+            m_NumRecords(0), m_DBAddress(nullptr),
+            m_Placement(NUMA_PLACEMENT::NONE), m_BloomFilters(nullptr), m_BloomBlocks(0),
+            m_FileIdentity{ 0, 0 }
+        {
+#ifdef WINDOWS_PLATFORM
+            HANDLE hFile = CreateFileA(
+                static_cast<LPCSTR>(dbPath.c_str()), // File name
+                GENERIC_READ | GENERIC_WRITE,        // Access mode
+                FILE_SHARE_READ | FILE_SHARE_WRITE,  // Share mode
+                NULL,                                // Security attributes
+                OPEN_EXISTING,                         // How to create
+                FILE_ATTRIBUTE_NORMAL,               // File attributes
+                NULL                                 // Handle to template file
+            );
 
             if (hFile == INVALID_HANDLE_VALUE)
             {
@@ -550,6 +1386,13 @@ public:
                 return;
             }
 
+            BY_HANDLE_FILE_INFORMATION fileInformation;
+            if (GetFileInformationByHandle(hFile, &fileInformation))
+            {
+                m_FileIdentity.device = fileInformation.dwVolumeSerialNumber;
+                m_FileIdentity.index = (static_cast<uint64_t>(fileInformation.nFileIndexHigh) << 32) | fileInformation.nFileIndexLow;
+            }
+
             HANDLE hMapFile = CreateFileMappingA(
                 hFile,                          // File handle
                 NULL,                           // Security attributes
@@ -595,22 +1438,54 @@ public:
             int error = fstat(fd, &statbuf);
             if(0 > error)
             {
+                close(fd);
                 return;
             }
 
             m_Size = statbuf.st_size;
+            m_FileIdentity.device = statbuf.st_dev;
+            m_FileIdentity.index = statbuf.st_ino;
             m_DBAddress = static_cast<char*>(mmap(nullptr, m_Size,
-                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    PROT_READ | PROT_WRITE, windows.windowSize ? MAP_SHARED : MAP_SHARED | MAP_POPULATE,
                     fd, 0));
+
+            // The mapping keeps its own reference to the file
+            close(fd);
+
             if(MAP_FAILED == m_DBAddress)
             {
+                m_DBAddress = nullptr;
+                return;
+            }
+
+            // The file was generated with a different record layout
+            const DBHeader* header = reinterpret_cast<DBHeader*>(m_DBAddress);
+            if(sizeof(object) != header->m_RecordSize || m_Size < DatabaseFileSize(*header))
+            {
+                munmap(m_DBAddress, m_Size);
+                m_DBAddress = nullptr;
                 return;
             }
 
 #endif
             m_NumRecords = reinterpret_cast<DBHeader*>(m_DBAddress)->m_NumRecords;
+            if (reinterpret_cast<DBHeader*>(m_DBAddress)->m_BloomFields)
+            {
+                m_BloomFilters = reinterpret_cast<BLOOM_BLOCK*>(m_DBAddress + BloomFiltersOffset(m_NumRecords, sizeof(object)));
+                m_BloomBlocks = BloomBlocks(m_NumRecords);
+            }
 
+            m_Store.Attach(m_DBAddress, &m_Windows);
+            m_Windows.Attach(m_DBAddress, sizeof(DBHeader) + RecordsLength(), windows);
             m_IsOpen = true;
+
+            if (NUMA_PLACEMENT::NONE != placement && NumaTopology::Get().IsNuma())
+            {
+                PlaceRecords(placement);
+            }
+
+            // Statistics are best effort, the database works without them
+            m_Statistics.Attach(dbPath, true);
         }
 
         ~dbInterface(void)
@@ -632,47 +1507,130 @@ public:
 protected:
 
     /*
-     * Lock the DB. Several ways to do this depending on OS.
+     * Called after every change to the records with the records as they are
+     * after it, see Replication.hh. Writes made under the lock call it under
+     * the lock, the field operations call it under the read lock. p_records is
+     * nullptr when Clear zeroed the whole table.
      */
-    RETCODE LockDB(void)
+    using ChangeHandler = std::function<void(size_t firstRecord, size_t numRecords, const object* p_records)>;
+
+    /*
+     * Lock the DB according to the lock policy.
+     * Operations that modify the DB take the lock exclusively.
+     */
+    RETCODE LockDB(DB_OPERATION operation)
     {
-#ifdef WINDOWS_PLATFORM
-        m_Mutex = CreateMutexA(NULL, FALSE, "MutexForFileLock");
-        if (nullptr == m_Mutex)
+        if (!LockPolicy::IS_LOCKING)
         {
-            return RTN_LOCK_ERROR;
+            return RTN_OK;
         }
-#else
 
-        int lockError = pthread_rwlock_rdlock(&reinterpret_cast<DBHeader*>(m_DBAddress)->m_DBLock);
-        if (0 != lockError)
+#ifdef QCDB_LOCK_TIMING
+        std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+#endif
+
+        RETCODE retcode = m_Lock.Lock(reinterpret_cast<DBHeader*>(m_DBAddress), IsReadOperation(operation));
+        if (RTN_OK != retcode)
         {
-            return RTN_LOCK_ERROR;
+            return retcode;
         }
+
+        m_Statistics.Count(STATISTIC::LOCK_ACQUISITIONS);
+
+#ifdef QCDB_LOCK_TIMING
+        std::chrono::steady_clock::time_point acquired = std::chrono::steady_clock::now();
+        HeldLocks().emplace_back(this, acquired);
+        m_Statistics.RecordLockWait(operation,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(acquired - waitStart).count());
 #endif
 
         return RTN_OK;
     }
 
     /*
-     * Unlock the DB. Several ways to do this depending on OS.
+     * Unlock the DB according to the lock policy.
      */
-    RETCODE UnlockDB(void)
+    RETCODE UnlockDB(DB_OPERATION operation)
     {
-#ifdef WINDOWS_PLATFORM
-        if (ReleaseMutex(m_Mutex))
+        if (!LockPolicy::IS_LOCKING)
         {
-            return RTN_LOCK_ERROR;
+            return RTN_OK;
         }
-#else
-        lockError = pthread_rwlock_unlock(&reinterpret_cast<DBHeader*>(m_DBAddress)->m_DBLock);
-        if (0 != lockError)
+
+#ifdef QCDB_LOCK_TIMING
+        std::vector<std::pair<const void*, std::chrono::steady_clock::time_point>>& heldLocks = HeldLocks();
+        for (size_t held = heldLocks.size(); held > 0; held--)
         {
-            return RTN_LOCK_ERROR;
+            if (this == heldLocks[held - 1].first)
+            {
+                m_Statistics.RecordLockHold(operation,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - heldLocks[held - 1].second).count());
+                heldLocks.erase(heldLocks.begin() + (held - 1));
+                break;
+            }
         }
 #endif
 
-    return RTN_OK;
+        return m_Lock.Unlock(reinterpret_cast<DBHeader*>(m_DBAddress), IsReadOperation(operation));
+    }
+
+#ifdef QCDB_LOCK_TIMING
+    /*
+     * The locks the calling thread holds and when it acquired them, most
+     * recent last. Per thread since readers share one dbInterface and hold
+     * the lock at the same time, and keyed by dbInterface since a thread
+     * can hold the locks of several tables, or a view's read lock and
+     * another one of the same table. Unlocking takes the most recent
+     * acquisition of its table.
+     */
+    static std::vector<std::pair<const void*, std::chrono::steady_clock::time_point>>& HeldLocks(void)
+    {
+        thread_local std::vector<std::pair<const void*, std::chrono::steady_clock::time_point>> heldLocks;
+        return heldLocks;
+    }
+#endif
+
+    /*
+     * Overwrite a record. The DB must be locked for writing.
+     */
+    void WriteRecord(char* p_object, size_t record, const object& objectWrite)
+    {
+        m_Store.WriteRecord(p_object, record, &objectWrite);
+        NotifyChanged(p_object, sizeof(object));
+        AddToBloomFilters(objectWrite);
+    }
+
+    /*
+     * Zero a record. The DB must be locked for writing.
+     */
+    void DeleteRecord(char* p_object, size_t record)
+    {
+        m_Store.DeleteRecord(p_object, record);
+        NotifyChanged(p_object, sizeof(object));
+    }
+
+    /*
+     * The field of a record inside the mapping, or nullptr if the record is invalid.
+     */
+    template <typename FieldType>
+    typename FieldType::ValueType* GetField(size_t record)
+    {
+        static_assert(std::is_same<typename FieldType::ObjectType, object>::value, "Field belongs to another object");
+
+        char* p_object = Get(record);
+        if (nullptr == p_object)
+        {
+            return nullptr;
+        }
+
+        return &FieldType::Get(*reinterpret_cast<object*>(p_object));
+    }
+
+    template <typename FieldType>
+    static constexpr bool IsAtomicField(void)
+    {
+        return std::is_integral<typename FieldType::ValueType>::value &&
+            !std::is_same<typename FieldType::ValueType, bool>::value;
     }
 
     /*
@@ -681,6 +1639,12 @@ protected:
      */
     char* Get(const size_t record)
     {
+        if(!BoundsPolicy::IS_CHECKED)
+        {
+            UseRecords(record, 1);
+            return m_DBAddress + sizeof(DBHeader) + sizeof(object) * record;
+        }
+
         if(NumberOfRecords() - 1 < record)
         {
             return nullptr;
@@ -698,9 +1662,279 @@ protected:
             return nullptr;
         }
 
+        UseRecords(record, 1);
         return m_DBAddress + byte_index;
     }
 
+    /*
+     * Tell a windowed mapping which records are about to be accessed.
+     */
+    void UseRecords(size_t firstRecord, size_t numRecords)
+    {
+        m_Windows.Use(sizeof(DBHeader) + firstRecord * sizeof(object), numRecords * sizeof(object));
+    }
+
+    /*
+     * Tell a windowed mapping the records from record on in its window are
+     * about to be read and return the end of them, at most end. Scans go a
+     * window at a time: using a whole chunk at once releases its first
+     * windows before they are read once it spans more than maxWindows. A
+     * record crossing into the next window is used on its own.
+     */
+    size_t UseWindowOf(size_t record, size_t end)
+    {
+        if (!m_Windows.IsWindowed())
+        {
+            return end;
+        }
+
+        size_t windowEnd = (m_Windows.WindowEnd(sizeof(DBHeader) + record * sizeof(object)) - sizeof(DBHeader)) / sizeof(object);
+        windowEnd = std::min(end, std::max(windowEnd, record + 1));
+        UseRecords(record, windowEnd - record);
+        return windowEnd;
+    }
+
+    /*
+     * Free the whole pages of records after the last written one, they read
+     * back as zeroes. Best effort, not every file system supports it.
+     * The DB must be locked for writing.
+     */
+    void ReleaseEmptyTail(void)
+    {
+#if !defined(WINDOWS_PLATFORM) && defined(MADV_REMOVE)
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t first = sizeof(DBHeader) + ScanSize() * sizeof(object);
+        size_t last = sizeof(DBHeader) + m_NumRecords * sizeof(object);
+        first = (first + pageSize - 1) / pageSize * pageSize;
+        last = last / pageSize * pageSize;
+        if (first < last)
+        {
+            madvise(m_DBAddress + first, last - first, MADV_REMOVE);
+        }
+#endif
+    }
+
+    size_t RecordsLength(void)
+    {
+        return m_NumRecords * sizeof(object);
+    }
+
+    /*
+     * Tell the change handler about the records holding length bytes at
+     * p_destination, after the bytes changed.
+     */
+    void NotifyChanged(const char* p_destination, size_t length)
+    {
+        if (m_ChangeHandler && length)
+        {
+            const object* records = reinterpret_cast<const object*>(m_DBAddress + sizeof(DBHeader));
+            size_t offset = p_destination - (m_DBAddress + sizeof(DBHeader));
+            size_t firstRecord = offset / sizeof(object);
+            size_t lastRecord = (offset + length - 1) / sizeof(object);
+            m_ChangeHandler(firstRecord, lastRecord - firstRecord + 1, records + firstRecord);
+        }
+    }
+
+    /*
+     * Copy bytes into the records, nullptr zeroes them, see
+     * RecordStore::StoreBytes. The DB must be locked for writing.
+     */
+    void StoreBytes(char* p_destination, const void* p_source, size_t length)
+    {
+        m_Store.StoreBytes(p_destination, p_source, length);
+        NotifyChanged(p_destination, length);
+    }
+
+    /*
+     * The field operations are atomic against each other and only keep
+     * whole record writes out, which would copy over them. Tables with
+     * checksums lock for writing, the field and the checksum of its block
+     * change together.
+     */
+    RETCODE LockForField(void)
+    {
+        return LockDB(m_Store.Checksums() ? DB_OPERATION::FIELD : DB_OPERATION::FIELD_SHARED);
+    }
+
+    RETCODE UnlockForField(void)
+    {
+        return UnlockDB(m_Store.Checksums() ? DB_OPERATION::FIELD : DB_OPERATION::FIELD_SHARED);
+    }
+
+    /*
+     * Whether the blocks holding length bytes at p_data match their
+     * checksums. Only checked when built with QCDB_VERIFY_CHECKSUMS, the
+     * DB must be locked.
+     */
+#ifdef QCDB_VERIFY_CHECKSUMS
+    bool IsIntact(const char* p_data, size_t length)
+    {
+        if (nullptr == m_Store.Checksums())
+        {
+            return true;
+        }
+
+        const char* records = m_DBAddress + sizeof(DBHeader);
+        size_t offset = p_data - records;
+        for (size_t block = offset / CHECKSUM_BLOCK_SIZE; block <= (offset + length - 1) / CHECKSUM_BLOCK_SIZE; block++)
+        {
+            if (m_Store.Checksums()[block] != BlockChecksum(records, RecordsLength(), block))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+#else
+    bool IsIntact(const char* /* p_data */, size_t /* length */)
+    {
+        return true;
+    }
+#endif
+
+    size_t NumBloomFilters(void)
+    {
+        return __builtin_popcountll(reinterpret_cast<DBHeader*>(m_DBAddress)->m_BloomFields);
+    }
+
+    /*
+     * The filter of a field, nullptr if the field has none. Filters are
+     * stored in field order.
+     */
+    BLOOM_BLOCK* BloomFilter(size_t field)
+    {
+        uint64_t bloomFields = reinterpret_cast<DBHeader*>(m_DBAddress)->m_BloomFields;
+        if (nullptr == m_BloomFilters || 64 <= field || 0 == (bloomFields & (1ULL << field)))
+        {
+            return nullptr;
+        }
+
+        return m_BloomFilters + __builtin_popcountll(bloomFields & ((1ULL << field) - 1)) * m_BloomBlocks;
+    }
+
+    /*
+     * Add the fields of a written object to their filters.
+     */
+    void AddToBloomFilters(const object& objectWrite)
+    {
+        if (nullptr == m_BloomFilters)
+        {
+            return;
+        }
+
+        ForEachField(objectWrite, [&](auto field, const auto&)
+        {
+            BLOOM_BLOCK* filter = BloomFilter(decltype(field)::INDEX);
+            if (filter)
+            {
+                BloomAdd(filter, m_BloomBlocks, decltype(field)::Hash(objectWrite));
+            }
+        });
+    }
+
+    template <typename FieldType>
+    void AddFieldToBloomFilter(const typename FieldType::ValueType& value)
+    {
+        BLOOM_BLOCK* filter = BloomFilter(FieldType::INDEX);
+        if (filter)
+        {
+            BloomAdd(filter, m_BloomBlocks, FieldTraits<typename FieldType::ValueType>::Hash(value));
+        }
+    }
+
+    /*
+     * Number of records scans look at, every record up to the last written.
+     */
+    size_t ScanSize(void)
+    {
+        if (0 == m_NumRecords)
+        {
+            return 0;
+        }
+
+        return std::min(reinterpret_cast<DBHeader*>(m_DBAddress)->m_Size + 1, m_NumRecords);
+    }
+
+    static size_t NumScanThreads(void)
+    {
+        // Number of threads /2 so we don't completely lock up the CPU
+#ifdef WINDOWS_PLATFORM
+        size_t numThreads = std::thread::hardware_concurrency() / 2;
+#else
+        size_t numThreads = sysconf(_SC_NPROCESSORS_ONLN) / 2;
+#endif
+        return std::max<size_t>(numThreads, 1);
+    }
+
+    /*
+     * Run worker on up to NumScanThreads threads, no more than there are
+     * chunks, the calling thread being one of them.
+     */
+    template <typename Worker>
+    static void RunScanThreads(size_t numChunks, Worker&& worker)
+    {
+        size_t numThreads = std::min(NumScanThreads(), std::max<size_t>(numChunks, 1));
+        std::vector<std::thread> threads;
+        for (size_t threadIndex = 1; threadIndex < numThreads; threadIndex++)
+        {
+            threads.emplace_back(std::ref(worker));
+        }
+
+        worker();
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /*
+     * First record of the node's share when numRecords are split across
+     * numNodes, node == numNodes gives numRecords.
+     */
+    static size_t NodeFirstRecord(size_t node, size_t numNodes, size_t numRecords)
+    {
+        return numRecords / numNodes * node + std::min(node, numRecords % numNodes);
+    }
+
+    /*
+     * Apply the NUMA placement to the records, page by page. Records sharing
+     * a page with the next node's share stay with the first node. Keeps
+     * working without a placement if the kernel refuses it.
+     */
+    void PlaceRecords(NUMA_PLACEMENT placement)
+    {
+#ifndef WINDOWS_PLATFORM
+        const NumaTopology& topology = NumaTopology::Get();
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t recordsEnd = sizeof(DBHeader) + m_NumRecords * sizeof(object);
+        size_t mappingEnd = (recordsEnd + pageSize - 1) / pageSize * pageSize;
+
+        bool isPlaced = true;
+        if (NUMA_PLACEMENT::INTERLEAVE == placement)
+        {
+            isPlaced = RTN_OK == topology.Interleave(m_DBAddress, mappingEnd);
+        }
+        else
+        {
+            size_t numNodes = topology.NumNodes();
+            for (size_t node = 0; node < numNodes && isPlaced; node++)
+            {
+                size_t first = sizeof(DBHeader) + NodeFirstRecord(node, numNodes, m_NumRecords) * sizeof(object);
+                size_t last = sizeof(DBHeader) + NodeFirstRecord(node + 1, numNodes, m_NumRecords) * sizeof(object);
+                first = 0 == node ? 0 : (first + pageSize - 1) / pageSize * pageSize;
+                last = numNodes == node + 1 ? mappingEnd : (last + pageSize - 1) / pageSize * pageSize;
+                if (first < last)
+                {
+                    isPlaced = RTN_OK == topology.Bind(m_DBAddress + first, last - first, node);
+                }
+            }
+        }
+
+        m_Placement = isPlaced ? placement : NUMA_PLACEMENT::NONE;
+#endif
+    }
+
     /*
      * Internal thread function that is used to run the predicate
      * in parallel in the sharded database.
@@ -709,10 +1943,12 @@ protected:
     {
         for (size_t record = 0; record < numRecords; record++)
         {
-            if (predicate(++currentObject))
+            if (predicate(currentObject))
             {
                 results.push_back(*currentObject);
             }
+
+            currentObject++;
         }
     }
 
@@ -720,14 +1956,28 @@ protected:
     size_t m_Size;
     size_t m_NumRecords;
     char* m_DBAddress;
-
-#ifdef WINDOWS_PLATFORM
-    HANDLE m_Mutex;
-#else
-#endif
+    dbStatistics m_Statistics;
+    LockPolicy m_Lock;
+    NUMA_PLACEMENT m_Placement;
+    BLOOM_BLOCK* m_BloomFilters;
+    size_t m_BloomBlocks;
+    RecordStore m_Store;
+    ChangeHandler m_ChangeHandler;
+    MappingWindows m_Windows;
+    FILE_IDENTITY m_FileIdentity;
 
     static constexpr int INVALID_FD = 0;
 
+    // Moves per Compact batch and how many records a batch may look at per move
+    static constexpr size_t COMPACT_BATCH_RECORDS = 4096;
+    static constexpr size_t COMPACT_SEARCH_FACTOR = 16;
+
+    // Records a scan thread claims at a time when scans can stop early
+    static constexpr size_t SCAN_CHUNK_RECORDS = 16 * 1024;
+
+    // Records between checks whether another thread already found an earlier match
+    static constexpr size_t CANCEL_CHECK_RECORDS = 1024;
+
     };
 }
 
@@ -0,0 +1,52 @@
+#ifndef __SCENARIOS_HH
+#define __SCENARIOS_HH
+
+#include <string>
+#include <cstddef>
+
+#include <common/Retcode.hh>
+#include <common/Logger.hh>
+#include <dbGenerator/inc/Schema.hh>
+#include <dbHeaders/ACCOUNT.hh>
+
+/*
+ * Fail the running scenario if condition does not hold.
+ */
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            LOG_FATAL("Check failed: ", #condition, " at ", __FILE__, ":", __LINE__); \
+            return RTN_FAIL; \
+        } \
+    } while (0)
+
+/*
+ * Generate an empty ACCOUNT table in directory, replacing the one an
+ * earlier run left there, and return the path of its file.
+ */
+RETCODE CreateTable(const std::string& directory, const GENERATE_OPTIONS& options, std::string& out_dbPath);
+
+/*
+ * The account every scenario writes to a record, so what it reads back can
+ * be told apart from zeroes and from other records.
+ */
+ACCOUNT MakeAccount(size_t record, long balance);
+
+/*
+ * Each scenario gets a directory of its own for its tables.
+ */
+RETCODE TestAsync(const std::string& directory);
+RETCODE TestFieldUpdate(const std::string& directory);
+RETCODE TestTransaction(const std::string& directory);
+RETCODE TestView(const std::string& directory);
+RETCODE TestChecksums(const std::string& directory);
+RETCODE TestReplication(const std::string& directory);
+RETCODE TestColdRead(const std::string& directory);
+RETCODE TestCompaction(const std::string& directory);
+RETCODE TestSharded(const std::string& directory);
+RETCODE TestClient(const std::string& directory);
+RETCODE TestWindowedScan(const std::string& directory);
+
+#endif
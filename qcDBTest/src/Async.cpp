@@ -0,0 +1,141 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/Async.hh>
+
+#include <atomic>
+#include <exception>
+
+static constexpr size_t NUM_ACCOUNTS = 16;
+static constexpr size_t NUM_TASKS = 64;
+static constexpr size_t NUM_DEPOSITS = 50;
+
+/*
+ * A coroutine that starts right away and frees itself when it is done, the
+ * dbAsync destructor waits for everything it awaits.
+ */
+struct DETACHED_TASK
+{
+    struct promise_type
+    {
+        DETACHED_TASK get_return_object(void)
+        {
+            return DETACHED_TASK();
+        }
+
+        std::suspend_never initial_suspend(void)
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend(void) noexcept
+        {
+            return {};
+        }
+
+        void return_void(void)
+        {
+        }
+
+        void unhandled_exception(void)
+        {
+            std::terminate();
+        }
+    };
+};
+
+/*
+ * Add one to the balance of record numDeposits times. The tasks sharing a
+ * record race, a conflict means another one got there first so read again.
+ */
+static DETACHED_TASK Deposit(qcDB::dbAsync<ACCOUNT>& accounts, size_t record, std::atomic<size_t>& numFailures)
+{
+    for (size_t deposit = 0; deposit < NUM_DEPOSITS; deposit++)
+    {
+        RETCODE retcode = RTN_CONFLICT;
+        while (RTN_CONFLICT == retcode)
+        {
+            ACCOUNT account = { 0 };
+            RECORD_VERSION version = 0;
+            retcode = co_await accounts.ReadObject(record, account, version);
+            if (RTN_OK != retcode)
+            {
+                break;
+            }
+
+            account = MakeAccount(record, account.BALANCE + 1);
+            retcode = co_await accounts.CompareAndWrite(record, version, account);
+        }
+
+        if (RTN_OK != retcode)
+        {
+            numFailures++;
+            co_return;
+        }
+    }
+}
+
+/*
+ * Delete the even accounts then find what is left, all from one coroutine.
+ */
+static DETACHED_TASK DeleteEven(qcDB::dbAsync<ACCOUNT>& accounts, std::vector<ACCOUNT>& out_remaining, std::atomic<size_t>& numFailures)
+{
+    for (size_t record = 0; record < NUM_ACCOUNTS; record += 2)
+    {
+        if (RTN_OK != co_await accounts.DeleteObject(record))
+        {
+            numFailures++;
+        }
+    }
+
+    if (RTN_OK != co_await accounts.FindObjects([](const ACCOUNT* p_account) { return 0 != p_account->KEY; }, out_remaining))
+    {
+        numFailures++;
+    }
+}
+
+RETCODE TestAsync(const std::string& directory)
+{
+    std::string dbPath;
+    GENERATE_OPTIONS options = { 0 };
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<ACCOUNT> accounts(dbPath);
+    CHECK(0 < accounts.NumberOfRecords());
+
+    std::atomic<size_t> numFailures(0);
+    {
+        qcDB::dbAsync<ACCOUNT> asyncAccounts(accounts);
+        for (size_t task = 0; task < NUM_TASKS; task++)
+        {
+            Deposit(asyncAccounts, task % NUM_ACCOUNTS, numFailures);
+        }
+    }
+
+    CHECK(0 == numFailures.load());
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        ACCOUNT account = { 0 };
+        CHECK(RTN_OK == accounts.ReadObject(record, account));
+        CHECK(record + 1 == account.KEY);
+        CHECK(static_cast<long>(NUM_TASKS / NUM_ACCOUNTS * NUM_DEPOSITS) == account.BALANCE);
+    }
+
+    std::vector<ACCOUNT> remaining;
+    {
+        qcDB::dbAsync<ACCOUNT> asyncAccounts(accounts);
+        DeleteEven(asyncAccounts, remaining, numFailures);
+    }
+
+    CHECK(0 == numFailures.load());
+    CHECK(NUM_ACCOUNTS / 2 == remaining.size());
+    for (const ACCOUNT& account : remaining)
+    {
+        CHECK(1 == (account.KEY - 1) % 2);
+    }
+
+    return RTN_OK;
+}
@@ -0,0 +1,131 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <common/DBHeader.hh>
+#include <qcDB/Scrubber.hh>
+#include <qcDB/Transaction.hh>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static constexpr size_t NUM_ACCOUNTS = 5000;
+static constexpr size_t CORRUPT_RECORD = 2000;
+static constexpr std::chrono::seconds SCRUB_TIMEOUT = std::chrono::seconds(10);
+
+static std::vector<size_t> CorruptBlocks(qcDB::dbInterface<ACCOUNT>& accounts)
+{
+    std::vector<size_t> corruptBlocks;
+    accounts.VerifyChecksums(0, accounts.NumberOfChecksumBlocks(), corruptBlocks);
+    return corruptBlocks;
+}
+
+/*
+ * Flip a bit of a record through a mapping of its own, behind the back of
+ * the dbInterface and its checksums.
+ */
+static RETCODE FlipBit(const std::string& dbPath, size_t offset)
+{
+    int fd = open(dbPath.c_str(), O_RDWR);
+    if (-1 == fd)
+    {
+        return RTN_NOT_FOUND;
+    }
+
+    struct stat fileStatus;
+    char* p_file = static_cast<char*>(MAP_FAILED);
+    if (0 == fstat(fd, &fileStatus))
+    {
+        p_file = static_cast<char*>(mmap(nullptr, fileStatus.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    }
+
+    close(fd);
+    if (MAP_FAILED == p_file)
+    {
+        return RTN_FAIL;
+    }
+
+    p_file[offset] ^= 0x10;
+    munmap(p_file, fileStatus.st_size);
+    return RTN_OK;
+}
+
+RETCODE TestChecksums(const std::string& directory)
+{
+    std::string dbPath;
+    GENERATE_OPTIONS options = { 0 };
+    options.hasChecksums = true;
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<ACCOUNT> accounts(dbPath);
+    CHECK(0 < accounts.NumberOfChecksumBlocks());
+
+    // Every write path keeps the checksums current
+    std::vector<std::tuple<size_t, ACCOUNT>> writes;
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        writes.emplace_back(record, MakeAccount(record, record));
+    }
+
+    CHECK(RTN_OK == accounts.WriteObjects(writes));
+    for (size_t record = 0; record < NUM_ACCOUNTS; record += 7)
+    {
+        CHECK(RTN_OK == accounts.DeleteObject(record));
+    }
+
+    ACCOUNT account = MakeAccount(NUM_ACCOUNTS, 1);
+    CHECK(RTN_OK == accounts.WriteObject(NUM_ACCOUNTS, account));
+    CHECK(RTN_OK == accounts.UpdateField<ACCOUNT_FIELDS::BALANCE>(1, -1l));
+    long previous = 0;
+    CHECK(RTN_OK == accounts.FetchAddField<ACCOUNT_FIELDS::BALANCE>(2, 5l, previous));
+    {
+        qcDB::dbTransaction transaction;
+        CHECK(RTN_OK == transaction.Write(accounts, 3, account));
+        CHECK(RTN_OK == transaction.Delete(accounts, 4));
+        CHECK(RTN_OK == transaction.Commit());
+    }
+
+    CHECK(CorruptBlocks(accounts).empty());
+
+    size_t offset = CORRUPT_RECORD * sizeof(ACCOUNT) + offsetof(ACCOUNT, NAME);
+    size_t expectedBlock = offset / CHECKSUM_BLOCK_SIZE;
+    CHECK(RTN_OK == FlipBit(dbPath, sizeof(DBHeader) + offset));
+
+    std::vector<size_t> corruptBlocks = CorruptBlocks(accounts);
+    CHECK(1 == corruptBlocks.size() && expectedBlock == corruptBlocks[0]);
+
+    std::mutex handledMutex;
+    std::vector<size_t> handledBlocks;
+    {
+        qcDB::dbScrubber<ACCOUNT> scrubber(accounts, 0, [&](size_t block)
+            {
+                std::lock_guard<std::mutex> lock(handledMutex);
+                handledBlocks.push_back(block);
+            });
+
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + SCRUB_TIMEOUT;
+        while (0 == scrubber.NumberOfPasses() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        CHECK(0 < scrubber.NumberOfPasses());
+        CHECK(RTN_OK == scrubber.Retcode());
+        corruptBlocks = scrubber.CorruptBlocks();
+    }
+
+    CHECK(1 == corruptBlocks.size() && expectedBlock == corruptBlocks[0]);
+    CHECK(!handledBlocks.empty() && expectedBlock == handledBlocks[0]);
+
+    // Flipping the bit back repairs the block
+    CHECK(RTN_OK == FlipBit(dbPath, sizeof(DBHeader) + offset));
+    CHECK(CorruptBlocks(accounts).empty());
+    return RTN_OK;
+}
@@ -0,0 +1,118 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/qcDB.hh>
+#include <qcDB/Client.hh>
+#include <dbServer/inc/Server.hh>
+
+#include <thread>
+
+static constexpr size_t NUM_ACCOUNTS = 500;
+// More than the responses dbServer holds for a client that is not reading
+static constexpr size_t LARGE_BATCH_BYTES = 4 * 1024 * 1024;
+
+/*
+ * Everything a client does against the running server.
+ */
+static RETCODE UseClient(const std::string& socketPath)
+{
+    qcDB::dbClient<ACCOUNT> client(socketPath);
+    CHECK(client.IsOpen());
+    CHECK(qcDB::Reflection<ACCOUNT>::NUM_RECORDS == client.NumberOfRecords());
+
+    ACCOUNT account = MakeAccount(3, 3);
+    CHECK(RTN_OK == client.WriteObject(3, account));
+
+    ACCOUNT read = { 0 };
+    RECORD_VERSION version = 0;
+    CHECK(RTN_OK == client.ReadObject(3, read, version));
+    CHECK(0 == memcmp(&account, &read, sizeof(ACCOUNT)));
+    CHECK(RTN_CONFLICT == client.CompareAndWrite(3, version + 1, account));
+    CHECK(RTN_OK == client.CompareAndWrite(3, version, account));
+    CHECK(RTN_NULL_OBJ == client.WriteObject(client.NumberOfRecords(), account));
+
+    // Pipelined batches
+    std::vector<std::tuple<size_t, ACCOUNT>> accounts;
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        accounts.emplace_back(record, MakeAccount(record, record));
+    }
+
+    CHECK(RTN_OK == client.WriteObjects(accounts));
+    for (std::tuple<size_t, ACCOUNT>& entry : accounts)
+    {
+        std::get<1>(entry) = ACCOUNT{ 0 };
+    }
+
+    CHECK(RTN_OK == client.ReadObjects(accounts));
+    for (const std::tuple<size_t, ACCOUNT>& entry : accounts)
+    {
+        CHECK(static_cast<long>(std::get<0>(entry)) == std::get<1>(entry).BALANCE);
+    }
+
+    // Batches whose responses are more than the server buffers per client
+    accounts.clear();
+    for (size_t record = 0; record < client.NumberOfRecords(); record++)
+    {
+        accounts.emplace_back(record, MakeAccount(record, record));
+    }
+
+    CHECK(LARGE_BATCH_BYTES < accounts.size() * (sizeof(qcDB::RESPONSE_HEADER) + sizeof(ACCOUNT)));
+    CHECK(RTN_OK == client.WriteObjects(accounts));
+    for (std::tuple<size_t, ACCOUNT>& entry : accounts)
+    {
+        std::get<1>(entry) = ACCOUNT{ 0 };
+    }
+
+    CHECK(RTN_OK == client.ReadObjects(accounts));
+    for (const std::tuple<size_t, ACCOUNT>& entry : accounts)
+    {
+        CHECK(static_cast<long>(std::get<0>(entry)) == std::get<1>(entry).BALANCE);
+    }
+
+    CHECK(RTN_OK == client.DeleteObject(5));
+    return RTN_OK;
+}
+
+RETCODE TestClient(const std::string& directory)
+{
+    std::string dbPath;
+    GENERATE_OPTIONS options = { 0 };
+    options.hasChecksums = true;
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    std::string socketPath = directory + "server.sock";
+    {
+        Server server;
+        CHECK(RTN_OK == server.AddTable(dbPath));
+        CHECK(RTN_OK == server.Listen(socketPath));
+
+        RETCODE serverRetcode = RTN_OK;
+        std::thread serving([&] { serverRetcode = server.Run(); });
+        retcode = UseClient(socketPath);
+        server.Stop();
+        serving.join();
+
+        CHECK(RTN_OK == serverRetcode);
+        if (RTN_OK != retcode)
+        {
+            return retcode;
+        }
+    }
+
+    // The server wrote through the same path as dbInterface
+    qcDB::dbInterface<ACCOUNT> accounts(dbPath);
+    ACCOUNT account = { 0 };
+    CHECK(RTN_OK == accounts.ReadObject(NUM_ACCOUNTS - 1, account));
+    CHECK(static_cast<long>(NUM_ACCOUNTS - 1) == account.BALANCE);
+    CHECK(RTN_OK == accounts.ReadObject(5, account));
+    CHECK(0 == account.KEY);
+
+    std::vector<size_t> corruptBlocks;
+    CHECK(RTN_OK == accounts.VerifyChecksums(0, accounts.NumberOfChecksumBlocks(), corruptBlocks));
+    CHECK(corruptBlocks.empty());
+    return RTN_OK;
+}
@@ -0,0 +1,113 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/ColdReader.hh>
+
+#include <random>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+static constexpr size_t NUM_LOOKUPS = 2000;
+static constexpr size_t WINDOW_SIZE = 1 << 20;
+static constexpr size_t MAX_WINDOWS = 2;
+
+/*
+ * Write the table back and drop it from the page cache. Only pages no
+ * process maps can go, the windows of the table that are still mapped stay.
+ */
+static RETCODE DropCache(const std::string& dbPath)
+{
+    int fd = open(dbPath.c_str(), O_RDONLY);
+    if (-1 == fd)
+    {
+        return RTN_NOT_FOUND;
+    }
+
+    RETCODE retcode = 0 == fdatasync(fd) && 0 == posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) ? RTN_OK : RTN_FAIL;
+    close(fd);
+    return retcode;
+}
+
+/*
+ * Look up records of the first half of the table, the windows mapped last
+ * hold the end of it.
+ */
+static RETCODE ReadCold(qcDB::dbInterface<ACCOUNT>& accounts, const std::string& dbPath, const qcDB::COLD_READ_OPTIONS& options)
+{
+    std::mt19937_64 generator(options.queueDepth);
+    std::vector<std::tuple<size_t, ACCOUNT>> lookups;
+    for (size_t lookup = 0; lookup < NUM_LOOKUPS; lookup++)
+    {
+        lookups.emplace_back(generator() % (accounts.NumberOfRecords() / 2), ACCOUNT{ 0 });
+    }
+
+    CHECK(RTN_OK == DropCache(dbPath));
+
+    qcDB::dbColdReader<ACCOUNT> reader(accounts, dbPath, options);
+    CHECK(reader.IsOpen());
+    CHECK(RTN_OK == reader.ReadObjects(lookups));
+    CHECK(0 < reader.NumberOfColdReads());
+    CHECK(NUM_LOOKUPS == reader.NumberOfColdReads() + reader.NumberOfResidentReads());
+
+    for (const std::tuple<size_t, ACCOUNT>& lookup : lookups)
+    {
+        ACCOUNT expected = MakeAccount(std::get<0>(lookup), std::get<0>(lookup));
+        CHECK(0 == memcmp(&expected, &std::get<1>(lookup), sizeof(ACCOUNT)));
+    }
+
+    // A second batch through the same reader, the first left nothing behind
+    for (std::tuple<size_t, ACCOUNT>& lookup : lookups)
+    {
+        std::get<1>(lookup) = ACCOUNT{ 0 };
+    }
+
+    CHECK(RTN_OK == DropCache(dbPath));
+    CHECK(RTN_OK == reader.ReadObjects(lookups));
+    for (const std::tuple<size_t, ACCOUNT>& lookup : lookups)
+    {
+        CHECK(static_cast<long>(std::get<0>(lookup)) == std::get<1>(lookup).BALANCE);
+    }
+
+    std::vector<std::tuple<size_t, ACCOUNT>> outside = { { accounts.NumberOfRecords(), ACCOUNT{ 0 } } };
+    CHECK(RTN_NULL_OBJ == reader.ReadObjects(outside));
+    return RTN_OK;
+}
+
+RETCODE TestColdRead(const std::string& directory)
+{
+    std::string dbPath;
+    std::string otherPath;
+    GENERATE_OPTIONS options = { 0 };
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    retcode = RTN_OK == retcode ? CreateTable(directory + "other/", options, otherPath) : retcode;
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    // Windowed so the pages of the records read are not mapped
+    qcDB::dbInterface<ACCOUNT> accounts(dbPath, qcDB::NUMA_PLACEMENT::NONE, qcDB::WINDOWED_MAPPING{ WINDOW_SIZE, MAX_WINDOWS });
+    CHECK(0 < accounts.NumberOfRecords());
+
+    std::vector<std::tuple<size_t, ACCOUNT>> writes;
+    for (size_t record = 0; record < accounts.NumberOfRecords(); record++)
+    {
+        writes.emplace_back(record, MakeAccount(record, record));
+    }
+
+    CHECK(RTN_OK == accounts.WriteObjects(writes));
+
+    retcode = ReadCold(accounts, dbPath, qcDB::COLD_READ_OPTIONS{ 64, true });
+    retcode = RTN_OK == retcode ? ReadCold(accounts, dbPath, qcDB::COLD_READ_OPTIONS{ 8, false }) : retcode;
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    // A reader only opens the file its table maps
+    qcDB::dbColdReader<ACCOUNT> otherReader(accounts, otherPath);
+    CHECK(!otherReader.IsOpen());
+    std::vector<std::tuple<size_t, ACCOUNT>> lookups = { { 0, ACCOUNT{ 0 } } };
+    CHECK(RTN_NOT_FOUND == otherReader.ReadObjects(lookups));
+    return RTN_OK;
+}
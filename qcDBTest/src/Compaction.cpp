@@ -0,0 +1,95 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/qcDB.hh>
+
+#include <cstring>
+#include <vector>
+
+static constexpr size_t NUM_ACCOUNTS = 30000;
+static constexpr size_t COMPACT_BATCH = 1000;
+
+RETCODE TestCompaction(const std::string& directory)
+{
+    std::string dbPath;
+    GENERATE_OPTIONS options = { 0 };
+    options.hasChecksums = true;
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<ACCOUNT> accounts(dbPath);
+    CHECK(0 < accounts.NumberOfRecords());
+
+    std::vector<std::tuple<size_t, ACCOUNT>> writes;
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        writes.emplace_back(record, MakeAccount(record, record));
+    }
+
+    CHECK(RTN_OK == accounts.WriteObjects(writes));
+
+    // Keep every third account
+    size_t numLive = 0;
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        if (0 == record % 3)
+        {
+            numLive++;
+            continue;
+        }
+
+        CHECK(RTN_OK == accounts.DeleteObject(record));
+    }
+
+    RECORD_VERSION movedVersion = 0;
+    CHECK(RTN_OK == accounts.ReadVersion(NUM_ACCOUNTS - 3, movedVersion));
+
+    std::vector<qcDB::RECORD_MOVE> moves;
+    CHECK(RTN_OK == accounts.Compact(moves, COMPACT_BATCH, true));
+    CHECK(!moves.empty());
+
+    // Every move took the account at from to to and left from empty
+    for (const qcDB::RECORD_MOVE& move : moves)
+    {
+        CHECK(move.to < move.from);
+
+        ACCOUNT account = { 0 };
+        CHECK(RTN_OK == accounts.ReadObject(move.to, account));
+        ACCOUNT expected = MakeAccount(move.from, move.from);
+        CHECK(0 == memcmp(&expected, &account, sizeof(ACCOUNT)));
+
+        CHECK(RTN_OK == accounts.ReadObject(move.from, account));
+        CHECK(0 == account.KEY);
+    }
+
+    // The live accounts are packed at the front, each of them once
+    std::vector<bool> isSeen(NUM_ACCOUNTS, false);
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        ACCOUNT account = { 0 };
+        CHECK(RTN_OK == accounts.ReadObject(record, account));
+        CHECK((record < numLive) == (0 != account.KEY));
+        if (record < numLive)
+        {
+            size_t original = account.KEY - 1;
+            CHECK(0 == original % 3 && !isSeen[original]);
+            isSeen[original] = true;
+        }
+    }
+
+    // A write based on the old number of a moved account is refused
+    ACCOUNT account = MakeAccount(NUM_ACCOUNTS - 3, 0);
+    CHECK(RTN_CONFLICT == accounts.CompareAndWrite(NUM_ACCOUNTS - 3, movedVersion, account));
+
+    std::vector<size_t> corruptBlocks;
+    CHECK(RTN_OK == accounts.VerifyChecksums(0, accounts.NumberOfChecksumBlocks(), corruptBlocks));
+    CHECK(corruptBlocks.empty());
+
+    // Nothing is left to move
+    moves.clear();
+    CHECK(RTN_OK == accounts.Compact(moves));
+    CHECK(moves.empty());
+    return RTN_OK;
+}
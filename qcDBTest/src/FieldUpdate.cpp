@@ -0,0 +1,84 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/qcDB.hh>
+
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+static constexpr size_t RECORD = 42;
+static constexpr size_t NUM_ADDS = 200000;
+
+/*
+ * Rename the account at least once and for as long as the adds go on by
+ * reading it and writing it back with CompareAndWrite, reading again on
+ * conflict. The balance is written back as it was read, an add that lands
+ * in between must make it conflict.
+ */
+static RETCODE Rename(qcDB::dbInterface<ACCOUNT>& accounts, const std::atomic<bool>& isAdding, size_t& out_numRenames, size_t& out_numConflicts)
+{
+    for (out_numRenames = 0; 0 == out_numRenames || isAdding; out_numRenames++)
+    {
+        RETCODE retcode = RTN_CONFLICT;
+        while (RTN_CONFLICT == retcode)
+        {
+            ACCOUNT account = { 0 };
+            RECORD_VERSION version = 0;
+            CHECK(RTN_OK == accounts.ReadObject(RECORD, account, version));
+
+            snprintf(account.NAME, sizeof(account.NAME), "renamed_%zu", out_numRenames);
+            retcode = accounts.CompareAndWrite(RECORD, version, account);
+            out_numConflicts += RTN_CONFLICT == retcode ? 1 : 0;
+        }
+
+        CHECK(RTN_OK == retcode);
+    }
+
+    return RTN_OK;
+}
+
+RETCODE TestFieldUpdate(const std::string& directory)
+{
+    std::string dbPath;
+    GENERATE_OPTIONS options = { 0 };
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<ACCOUNT> accounts(dbPath);
+    CHECK(0 < accounts.NumberOfRecords());
+    ACCOUNT account = MakeAccount(RECORD, 0);
+    CHECK(RTN_OK == accounts.WriteObject(RECORD, account));
+
+    RETCODE renameRetcode = RTN_OK;
+    std::atomic<bool> isAdding(true);
+    size_t numRenames = 0;
+    size_t numConflicts = 0;
+    std::thread renaming([&] { renameRetcode = Rename(accounts, isAdding, numRenames, numConflicts); });
+
+    size_t numFailedAdds = 0;
+    for (size_t add = 0; add < NUM_ADDS; add++)
+    {
+        long previous = 0;
+        numFailedAdds += RTN_OK == accounts.FetchAddField<ACCOUNT_FIELDS::BALANCE>(RECORD, 1, previous) ? 0 : 1;
+    }
+
+    isAdding = false;
+    renaming.join();
+    LOG_INFO("Renames: ", numRenames, " CompareAndWrite conflicts with the adds: ", numConflicts);
+    CHECK(RTN_OK == renameRetcode && 0 < numRenames);
+    CHECK(0 == numFailedAdds);
+
+    // Not one add was written over by a rename
+    CHECK(RTN_OK == accounts.ReadObject(RECORD, account));
+    CHECK(static_cast<long>(NUM_ADDS) == account.BALANCE);
+    CHECK(RECORD + 1 == account.KEY);
+
+    char lastName[sizeof(account.NAME)] = { 0 };
+    snprintf(lastName, sizeof(lastName), "renamed_%zu", numRenames - 1);
+    CHECK(0 == strcmp(lastName, account.NAME));
+    return RTN_OK;
+}
@@ -0,0 +1,183 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/Replication.hh>
+
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static constexpr size_t NUM_ACCOUNTS = 20000;
+static constexpr size_t NUM_CHANGES = 5000;
+static constexpr std::chrono::seconds CATCH_UP_TIMEOUT = std::chrono::seconds(30);
+
+static size_t NumberOfDifferences(qcDB::dbInterface<ACCOUNT>& primary, qcDB::dbInterface<ACCOUNT>& standby)
+{
+    size_t numDifferences = 0;
+    for (size_t record = 0; record < primary.NumberOfRecords(); record++)
+    {
+        ACCOUNT primaryAccount = { 0 };
+        ACCOUNT standbyAccount = { 0 };
+        primary.ReadObject(record, primaryAccount);
+        standby.ReadObject(record, standbyAccount);
+        numDifferences += 0 != memcmp(&primaryAccount, &standbyAccount, sizeof(ACCOUNT)) ? 1 : 0;
+    }
+
+    return numDifferences;
+}
+
+/*
+ * Wait until the replica applied sequence or stopped applying.
+ */
+static bool CatchUp(qcDB::dbReplica<ACCOUNT>& replica, uint64_t sequence)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + CATCH_UP_TIMEOUT;
+    while (replica.Status().appliedSequence < sequence && RTN_OK == replica.Retcode())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return replica.Status().appliedSequence >= sequence;
+}
+
+/*
+ * Send a stream header for the table followed by a single change header
+ * and return what the replica makes of it.
+ */
+static RETCODE SendChange(qcDB::dbInterface<ACCOUNT>& standby, uint64_t firstRecord, uint32_t numRecords, uint32_t type)
+{
+    int fds[2];
+    if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+    {
+        return RTN_CONNECTION_FAIL;
+    }
+
+    RETCODE retcode = RTN_OK;
+    {
+        qcDB::dbReplica<ACCOUNT> replica(standby, fds[1]);
+
+        qcDB::STREAM_HEADER streamHeader;
+        memset(&streamHeader, 0, sizeof(streamHeader));
+        strncpy(streamHeader.objectName, qcDB::Reflection<ACCOUNT>::OBJECT_NAME, sizeof(streamHeader.objectName) - 1);
+        streamHeader.numRecords = standby.NumberOfRecords();
+        streamHeader.recordSize = sizeof(ACCOUNT);
+
+        qcDB::CHANGE_HEADER change;
+        memset(&change, 0, sizeof(change));
+        change.sequence = 1;
+        change.firstRecord = firstRecord;
+        change.numRecords = numRecords;
+        change.type = type;
+
+        if (sizeof(streamHeader) != write(fds[0], &streamHeader, sizeof(streamHeader)) ||
+            sizeof(change) != write(fds[0], &change, sizeof(change)))
+        {
+            retcode = RTN_CONNECTION_FAIL;
+        }
+
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + CATCH_UP_TIMEOUT;
+        while (RTN_OK == retcode && RTN_OK == replica.Retcode() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        retcode = RTN_OK == retcode ? replica.Retcode() : retcode;
+        close(fds[0]);
+    }
+
+    close(fds[1]);
+    return retcode;
+}
+
+RETCODE TestReplication(const std::string& directory)
+{
+    std::string primaryPath;
+    std::string standbyPath;
+    GENERATE_OPTIONS options = { 0 };
+    RETCODE retcode = CreateTable(directory + "primary/", options, primaryPath);
+    retcode = RTN_OK == retcode ? CreateTable(directory + "standby/", options, standbyPath) : retcode;
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<ACCOUNT> primary(primaryPath);
+    qcDB::dbInterface<ACCOUNT> standby(standbyPath);
+    CHECK(0 < primary.NumberOfRecords() && 0 < standby.NumberOfRecords());
+
+    std::vector<std::tuple<size_t, ACCOUNT>> writes;
+    for (size_t record = 0; record < NUM_ACCOUNTS; record += 2)
+    {
+        writes.emplace_back(record, MakeAccount(record, record));
+    }
+
+    CHECK(RTN_OK == primary.WriteObjects(writes));
+
+    // The snapshot replaces whatever the standby held
+    ACCOUNT stale = MakeAccount(NUM_ACCOUNTS + 1, -1);
+    CHECK(RTN_OK == standby.WriteObject(NUM_ACCOUNTS + 1, stale));
+
+    int fds[2];
+    CHECK(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    {
+        qcDB::dbReplica<ACCOUNT> replica(standby, fds[1]);
+        {
+            qcDB::dbReplicationSource<ACCOUNT> source(primary, fds[0]);
+
+            // Changes made while the snapshot streams follow it
+            for (size_t change = 0; change < NUM_CHANGES; change++)
+            {
+                size_t record = (change * 7919) % NUM_ACCOUNTS;
+                if (0 == change % 5)
+                {
+                    primary.DeleteObject(record);
+                }
+                else if (1 == change % 5)
+                {
+                    long previous = 0;
+                    primary.FetchAddField<ACCOUNT_FIELDS::BALANCE>(record, 1l, previous);
+                }
+                else
+                {
+                    ACCOUNT account = MakeAccount(record, change);
+                    primary.WriteObject(record, account);
+                }
+            }
+
+            CHECK(RTN_OK == source.Retcode());
+            CHECK(CatchUp(replica, source.Sequence()));
+            CHECK(replica.Status().isSynchronized);
+            CHECK(0 == NumberOfDifferences(primary, standby));
+
+            CHECK(RTN_OK == primary.Clear());
+            ACCOUNT account = MakeAccount(12, 12);
+            CHECK(RTN_OK == primary.WriteObject(12, account));
+            CHECK(CatchUp(replica, source.Sequence()));
+            CHECK(0 == NumberOfDifferences(primary, standby));
+        }
+
+        close(fds[0]);
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + CATCH_UP_TIMEOUT;
+        while (RTN_OK == replica.Retcode() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        CHECK(RTN_EOF == replica.Retcode());
+    }
+
+    close(fds[1]);
+
+    // Changes the replica can not apply end the stream
+    uint32_t records = static_cast<uint32_t>(qcDB::CHANGE_TYPE::RECORDS);
+    CHECK(RTN_CORRUPT == SendChange(standby, 0, UINT32_MAX, records));
+    CHECK(RTN_CORRUPT == SendChange(standby, UINT64_MAX - 2, 10, records));
+    CHECK(RTN_CORRUPT == SendChange(standby, 0, 0, 77));
+    return RTN_OK;
+}
@@ -0,0 +1,85 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/Sharded.hh>
+
+#include <cstring>
+
+// Does not split 100000 records evenly, the last shard ends in padding
+static constexpr size_t NUM_SHARDS = 3;
+static constexpr size_t NUM_WRITES = 1000;
+
+/*
+ * Write and read back records spread over every shard under one policy.
+ */
+template <class ShardPolicy>
+static RETCODE TestPolicy(const std::string& dbPath)
+{
+    qcDB::dbShardedInterface<ACCOUNT, ShardPolicy> accounts(dbPath, NUM_SHARDS);
+    CHECK(NUM_SHARDS == accounts.NumberOfShards());
+    CHECK(qcDB::Reflection<ACCOUNT>::NUM_RECORDS == accounts.NumberOfRecords());
+    CHECK(RTN_OK == accounts.Clear());
+
+    size_t stride = accounts.NumberOfRecords() / NUM_WRITES;
+    std::vector<std::tuple<size_t, ACCOUNT>> writes;
+    for (size_t write = 0; write < NUM_WRITES; write++)
+    {
+        size_t record = write * stride + write % stride;
+        writes.emplace_back(record, MakeAccount(record, record));
+    }
+
+    // The last write is to the very last record, in the shard with the padding
+    size_t lastRecord = std::get<0>(writes.back());
+    CHECK(accounts.NumberOfRecords() - 1 == lastRecord);
+    CHECK(RTN_OK == accounts.WriteObjects(writes));
+
+    std::vector<std::tuple<size_t, ACCOUNT>> reads;
+    for (const std::tuple<size_t, ACCOUNT>& write : writes)
+    {
+        reads.emplace_back(std::get<0>(write), ACCOUNT{ 0 });
+    }
+
+    // Batches come back in shard order
+    CHECK(RTN_OK == accounts.ReadObjects(reads));
+    for (const std::tuple<size_t, ACCOUNT>& read : reads)
+    {
+        ACCOUNT expected = MakeAccount(std::get<0>(read), std::get<0>(read));
+        CHECK(0 == memcmp(&expected, &std::get<1>(read), sizeof(ACCOUNT)));
+    }
+
+    long firstMatch = NUM_WRITES / 2 * stride + NUM_WRITES / 2 % stride;
+    size_t found = 0;
+    CHECK(RTN_OK == accounts.FindFirstOf([=](const ACCOUNT* p_account) { return firstMatch <= p_account->BALANCE; }, found));
+    CHECK(static_cast<size_t>(firstMatch) == found);
+
+    std::vector<ACCOUNT> matches;
+    CHECK(RTN_OK == accounts.FindObjects([](const ACCOUNT* p_account) { return 0 != p_account->KEY; }, matches));
+    CHECK(writes.size() == matches.size());
+
+    // Records past the schema's count are refused even where shards have padding
+    ACCOUNT account = MakeAccount(0, 0);
+    CHECK(RTN_NULL_OBJ == accounts.ReadObject(accounts.NumberOfRecords(), account));
+    CHECK(RTN_NULL_OBJ == accounts.WriteObject(accounts.NumberOfRecords(), account));
+    CHECK(RTN_OK == accounts.DeleteObject(lastRecord));
+    CHECK(RTN_OK == accounts.ReadObject(lastRecord, account));
+    CHECK(0 == account.KEY);
+    return RTN_OK;
+}
+
+RETCODE TestSharded(const std::string& directory)
+{
+    std::string dbPath;
+    GENERATE_OPTIONS options = { 0 };
+    options.numShards = NUM_SHARDS;
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    retcode = RTN_OK == retcode ? TestPolicy<qcDB::RangeSharding>(dbPath) : retcode;
+    retcode = RTN_OK == retcode ? TestPolicy<qcDB::HashSharding>(dbPath) : retcode;
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    // A shard of another split does not open as part of this one
+    qcDB::dbShardedInterface<ACCOUNT> accounts(dbPath, NUM_SHARDS - 1);
+    CHECK(0 == accounts.NumberOfRecords());
+    return RTN_OK;
+}
@@ -0,0 +1,38 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <common/Constants.hh>
+#include <common/DBHeader.hh>
+
+#include <cstdio>
+#include <cerrno>
+#include <sys/stat.h>
+
+RETCODE CreateTable(const std::string& directory, const GENERATE_OPTIONS& options, std::string& out_dbPath)
+{
+    if (0 != mkdir(directory.c_str(), 0755) && EEXIST != errno)
+    {
+        LOG_FATAL("Could not create: ", directory);
+        return RTN_FAIL;
+    }
+
+    // Start from empty files, otherwise old records survive the resize
+    out_dbPath = directory + "ACCOUNT" + CONSTANTS::DB_EXT;
+    std::remove(out_dbPath.c_str());
+    std::remove((out_dbPath + CONSTANTS::STATS_EXT).c_str());
+    for (size_t shard = 0; shard < options.numShards; shard++)
+    {
+        std::remove(ShardFilePath(out_dbPath, shard).c_str());
+        std::remove((ShardFilePath(out_dbPath, shard) + CONSTANTS::STATS_EXT).c_str());
+    }
+
+    return GenerateDatabase(QCDB_TEST_SCHEMA, directory, directory, options);
+}
+
+ACCOUNT MakeAccount(size_t record, long balance)
+{
+    ACCOUNT account = { 0 };
+    account.KEY = record + 1;
+    account.BALANCE = balance;
+    snprintf(account.NAME, sizeof(account.NAME), "account_%zu", record);
+    return account;
+}
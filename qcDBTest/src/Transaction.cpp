@@ -0,0 +1,148 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/Transaction.hh>
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+static constexpr size_t NUM_ACCOUNTS = 64;
+static constexpr long OPENING_BALANCE = 1000;
+static constexpr size_t NUM_THREADS = 4;
+static constexpr size_t NUM_TRANSFERS = 500;
+
+static RETCODE ReadBalance(qcDB::dbInterface<ACCOUNT>& accounts, size_t record, long& out_balance)
+{
+    ACCOUNT account = { 0 };
+    RETCODE retcode = accounts.ReadObject(record, account);
+    out_balance = account.BALANCE;
+    return retcode;
+}
+
+static long TotalBalance(qcDB::dbInterface<ACCOUNT>& accounts)
+{
+    long total = 0;
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        long balance = 0;
+        ReadBalance(accounts, record, balance);
+        total += balance;
+    }
+
+    return total;
+}
+
+/*
+ * Move one from an account to the same account of the other table in one
+ * transaction. Every thread owns its accounts so nothing changes them
+ * between the reads and the commit, the threads stage the tables in
+ * opposite orders.
+ */
+static void Transfer(qcDB::dbInterface<ACCOUNT>& left, qcDB::dbInterface<ACCOUNT>& right, size_t thread, std::atomic<size_t>& numFailures)
+{
+    for (size_t transfer = 0; transfer < NUM_TRANSFERS; transfer++)
+    {
+        size_t record = thread + (transfer * NUM_THREADS) % NUM_ACCOUNTS;
+        qcDB::dbInterface<ACCOUNT>& from = 0 == thread % 2 ? left : right;
+        qcDB::dbInterface<ACCOUNT>& to = 0 == thread % 2 ? right : left;
+
+        long fromBalance = 0;
+        long toBalance = 0;
+        RETCODE retcode = ReadBalance(from, record, fromBalance);
+        retcode = RTN_OK == retcode ? ReadBalance(to, record, toBalance) : retcode;
+
+        qcDB::dbTransaction transaction;
+        retcode = RTN_OK == retcode ? transaction.Write(from, record, MakeAccount(record, fromBalance - 1)) : retcode;
+        retcode = RTN_OK == retcode ? transaction.Write(to, record, MakeAccount(record, toBalance + 1)) : retcode;
+        retcode = RTN_OK == retcode ? transaction.Commit() : retcode;
+        if (RTN_OK != retcode)
+        {
+            numFailures++;
+        }
+    }
+}
+
+RETCODE TestTransaction(const std::string& directory)
+{
+    std::string leftPath;
+    std::string rightPath;
+    GENERATE_OPTIONS options = { 0 };
+    RETCODE retcode = CreateTable(directory + "left/", options, leftPath);
+    retcode = RTN_OK == retcode ? CreateTable(directory + "right/", options, rightPath) : retcode;
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<ACCOUNT> left(leftPath);
+    qcDB::dbInterface<ACCOUNT> right(rightPath);
+    CHECK(0 < left.NumberOfRecords() && 0 < right.NumberOfRecords());
+
+    // Commit: both tables get their writes
+    {
+        qcDB::dbTransaction transaction;
+        for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+        {
+            CHECK(RTN_OK == transaction.Write(left, record, MakeAccount(record, OPENING_BALANCE)));
+            CHECK(RTN_OK == transaction.Write(right, record, MakeAccount(record, OPENING_BALANCE)));
+        }
+
+        CHECK(RTN_OK == transaction.Commit());
+    }
+
+    CHECK(static_cast<long>(NUM_ACCOUNTS) * OPENING_BALANCE == TotalBalance(left));
+    CHECK(static_cast<long>(NUM_ACCOUNTS) * OPENING_BALANCE == TotalBalance(right));
+
+    // Rollback: neither an aborted transaction nor one that is dropped
+    // without a commit changes anything
+    RECORD_VERSION versionBefore = 0;
+    CHECK(RTN_OK == left.ReadVersion(0, versionBefore));
+    {
+        qcDB::dbTransaction transaction;
+        CHECK(RTN_OK == transaction.Write(left, 0, MakeAccount(0, 0)));
+        CHECK(RTN_OK == transaction.Delete(right, 0));
+        transaction.Abort();
+        CHECK(RTN_OK == transaction.Commit());
+
+        CHECK(RTN_OK == transaction.Delete(left, 1));
+        CHECK(RTN_OK == transaction.Write(right, 1, MakeAccount(1, 0)));
+    }
+
+    RECORD_VERSION versionAfter = 0;
+    CHECK(RTN_OK == left.ReadVersion(0, versionAfter));
+    CHECK(versionBefore == versionAfter);
+    CHECK(static_cast<long>(NUM_ACCOUNTS) * OPENING_BALANCE == TotalBalance(left));
+    CHECK(static_cast<long>(NUM_ACCOUNTS) * OPENING_BALANCE == TotalBalance(right));
+
+    // A record outside the table is refused when it is staged
+    {
+        qcDB::dbTransaction transaction;
+        CHECK(RTN_NULL_OBJ == transaction.Write(left, left.NumberOfRecords(), MakeAccount(0, 0)));
+    }
+
+    std::atomic<size_t> numFailures(0);
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < NUM_THREADS; thread++)
+    {
+        threads.emplace_back(Transfer, std::ref(left), std::ref(right), thread, std::ref(numFailures));
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(0 == numFailures.load());
+    // Every transfer stays within one pair of accounts
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        long leftBalance = 0;
+        long rightBalance = 0;
+        CHECK(RTN_OK == ReadBalance(left, record, leftBalance));
+        CHECK(RTN_OK == ReadBalance(right, record, rightBalance));
+        CHECK(2 * OPENING_BALANCE == leftBalance + rightBalance);
+        CHECK(OPENING_BALANCE != leftBalance);
+    }
+
+    return RTN_OK;
+}
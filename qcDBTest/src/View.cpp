@@ -0,0 +1,74 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/View.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static constexpr size_t NUM_ACCOUNTS = 1000;
+
+RETCODE TestView(const std::string& directory)
+{
+    std::string dbPath;
+    GENERATE_OPTIONS options = { 0 };
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<ACCOUNT> accounts(dbPath);
+    CHECK(0 < accounts.NumberOfRecords());
+
+    std::vector<std::tuple<size_t, ACCOUNT>> writes;
+    for (size_t record = 0; record < NUM_ACCOUNTS; record++)
+    {
+        writes.emplace_back(record, MakeAccount(record, record % 10));
+    }
+
+    CHECK(RTN_OK == accounts.WriteObjects(writes));
+    CHECK(RTN_OK == accounts.DeleteObject(3));
+
+    auto isThree = [](const ACCOUNT* p_account) { return 3 == p_account->BALANCE; };
+    std::vector<ACCOUNT> matches;
+    CHECK(RTN_OK == accounts.FindObjects(isThree, matches));
+
+    std::atomic<bool> isWritten(false);
+    bool isWrittenEarly = false;
+    std::thread writer;
+    {
+        qcDB::dbReadView<ACCOUNT> view(accounts);
+        CHECK(RTN_OK == view.Retcode());
+        CHECK(NUM_ACCOUNTS == view.size());
+
+        // The deleted record reads as zeroes
+        CHECK(0 == view[3].KEY);
+        size_t numThrees = std::count_if(view.begin(), view.end(), [&](const ACCOUNT& account) { return isThree(&account); });
+        CHECK(matches.size() == numThrees);
+
+        const ACCOUNT* p_found = std::find_if(view.begin(), view.end(), [](const ACCOUNT& account) { return 7 == account.BALANCE; });
+        CHECK(view.end() != p_found);
+        CHECK(7 == view.Record(*p_found));
+
+        // Writers wait for the view
+        writer = std::thread([&]
+            {
+                ACCOUNT account = MakeAccount(NUM_ACCOUNTS, 0);
+                accounts.WriteObject(NUM_ACCOUNTS, account);
+                isWritten = true;
+            });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        isWrittenEarly = isWritten.load();
+    }
+
+    writer.join();
+    CHECK(!isWrittenEarly);
+    CHECK(isWritten.load());
+
+    qcDB::dbReadView<ACCOUNT> view(accounts);
+    CHECK(NUM_ACCOUNTS + 1 == view.size());
+    return RTN_OK;
+}
@@ -0,0 +1,108 @@
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <qcDB/qcDB.hh>
+
+#include <fstream>
+#include <sstream>
+
+static constexpr size_t WINDOW_SIZE = 64 * 1024;
+static constexpr size_t MAX_WINDOWS = 2;
+// Pages of the rest of the process that may come and go during a scan
+static constexpr size_t RSS_SLACK = 1024 * 1024;
+
+/*
+ * Bytes of mapped files resident in this process, RssFile of
+ * /proc/self/status, 0 if it can not be read.
+ */
+static size_t ResidentFileBytes(void)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (0 == line.compare(0, 8, "RssFile:"))
+        {
+            size_t kilobytes = 0;
+            std::istringstream(line.substr(8)) >> kilobytes;
+            return kilobytes * 1024;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Run a scan and check the process kept no more of the records resident
+ * than its windows, however many of them were looked at. baseBytes were
+ * resident before the first scan, with the header and the record versions
+ * the writes touched.
+ */
+template <class Scan>
+static RETCODE CheckScan(qcDB::dbInterface<ACCOUNT>& accounts, const char* name, size_t baseBytes, Scan scan)
+{
+    CHECK(RTN_OK == scan());
+    size_t residentBytes = ResidentFileBytes();
+
+    LOG_INFO(name, " left resident file bytes: ", residentBytes, " before the scans: ", baseBytes);
+    CHECK(residentBytes <= baseBytes + MAX_WINDOWS * WINDOW_SIZE + RSS_SLACK);
+    CHECK(MAX_WINDOWS >= accounts.NumberOfResidentWindows());
+    return RTN_OK;
+}
+
+RETCODE TestWindowedScan(const std::string& directory)
+{
+    std::string dbPath;
+    GENERATE_OPTIONS options = { 0 };
+    RETCODE retcode = CreateTable(directory, options, dbPath);
+    if (RTN_OK != retcode)
+    {
+        return retcode;
+    }
+
+    qcDB::dbInterface<ACCOUNT> accounts(dbPath, qcDB::NUMA_PLACEMENT::NONE, qcDB::WINDOWED_MAPPING{ WINDOW_SIZE, MAX_WINDOWS });
+    size_t numRecords = accounts.NumberOfRecords();
+    CHECK(0 < numRecords);
+
+    // The table is several times what a scan may keep, one keeping it resident shows
+    CHECK(4 * (MAX_WINDOWS * WINDOW_SIZE + RSS_SLACK) < numRecords * sizeof(ACCOUNT));
+    for (size_t record = 0; record < numRecords; record++)
+    {
+        ACCOUNT account = MakeAccount(record, record % 1000);
+        CHECK(RTN_OK == accounts.WriteObject(record, account));
+    }
+
+    CHECK(MAX_WINDOWS >= accounts.NumberOfResidentWindows());
+
+    size_t baseBytes = ResidentFileBytes();
+    CHECK(0 < baseBytes);
+
+    std::vector<ACCOUNT> matches;
+    retcode = CheckScan(accounts, "FindObjects", baseBytes, [&]
+        {
+            matches.clear();
+            return accounts.FindObjects([](const ACCOUNT* p_account) { return 7 == p_account->BALANCE; }, matches);
+        });
+    CHECK(RTN_OK == retcode && numRecords / 1000 == matches.size());
+
+    retcode = CheckScan(accounts, "FindObjects with a limit", baseBytes, [&]
+        {
+            matches.clear();
+            return accounts.FindObjects([](const ACCOUNT* p_account) { return 999 == p_account->BALANCE; }, matches, numRecords);
+        });
+    CHECK(RTN_OK == retcode && numRecords / 1000 == matches.size());
+
+    size_t found = 0;
+    retcode = CheckScan(accounts, "FindFirstOf", baseBytes, [&]
+        {
+            return accounts.FindFirstOf([&](const ACCOUNT* p_account) { return numRecords == p_account->KEY; }, found);
+        });
+    CHECK(RTN_OK == retcode && numRecords - 1 == found);
+
+    retcode = CheckScan(accounts, "FindTopObjects", baseBytes, [&]
+        {
+            matches.clear();
+            return accounts.FindTopObjects<ACCOUNT_FIELDS::KEY>([](const ACCOUNT* p_account) { return true; }, 3, matches);
+        });
+    CHECK(RTN_OK == retcode && 3 == matches.size() && numRecords == matches[0].KEY);
+    return RTN_OK;
+}
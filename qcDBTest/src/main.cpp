@@ -0,0 +1,82 @@
+#include <common/Retcode.hh>
+#include <common/Logger.hh>
+#include <common/CLI.hh>
+
+#include <qcDBTest/inc/Scenarios.hh>
+
+#include <cerrno>
+#include <sys/stat.h>
+
+struct SCENARIO
+{
+    const char* name;
+    RETCODE (*run)(const std::string& directory);
+};
+
+static const SCENARIO SCENARIOS[] =
+{
+    { "async", TestAsync },
+    { "fieldUpdate", TestFieldUpdate },
+    { "transaction", TestTransaction },
+    { "view", TestView },
+    { "checksums", TestChecksums },
+    { "replication", TestReplication },
+    { "coldRead", TestColdRead },
+    { "compaction", TestCompaction },
+    { "sharded", TestSharded },
+    { "client", TestClient },
+    { "windowedScan", TestWindowedScan },
+};
+
+int main(int argc, char* argv[])
+{
+    CLI_StringArgument scenarioArg("-t", "The scenario to run", true);
+    CLI_StringArgument directoryArg("-d", "Directory to generate the tables of the scenario in", true);
+
+    Parser parser("qcDBTest", "Exercise qcDB and its extensions on generated tables");
+
+    parser
+        .AddArg(scenarioArg)
+        .AddArg(directoryArg);
+
+    RETCODE retcode = parser.ParseCommandLineArguments(argc, argv);
+    if (RTN_OK != retcode)
+    {
+        parser.Usage();
+        return retcode;
+    }
+
+    std::string directory = directoryArg.GetValue();
+    if ('/' != directory.back())
+    {
+        directory += '/';
+    }
+
+    if (0 != mkdir(directory.c_str(), 0755) && EEXIST != errno)
+    {
+        LOG_FATAL("Could not create: ", directory);
+        return RTN_FAIL;
+    }
+
+    for (const SCENARIO& scenario : SCENARIOS)
+    {
+        if (scenarioArg.GetValue() != scenario.name)
+        {
+            continue;
+        }
+
+        retcode = scenario.run(directory);
+        if (RTN_OK != retcode)
+        {
+            LOG_FATAL("Failed: ", scenario.name, " with retcode: ", retcode);
+            return retcode;
+        }
+
+        LOG_INFO("Passed: ", scenario.name);
+        return RTN_OK;
+    }
+
+    LOG_FATAL("Unknown scenario: ", scenarioArg.GetValue());
+    parser.Usage();
+    return RTN_BAD_ARG;
+}